@@ -29,6 +29,7 @@
  */
 
 #include "ns3/nada-controller.h"
+#include "ns3/dummy-controller.h"
 #include "ns3/rmcat-sender.h"
 #include "ns3/rmcat-receiver.h"
 #include "ns3/rmcat-constants.h"
@@ -42,6 +43,8 @@
 #include "ns3/ipv4-address-helper.h"
 #include "ns3/core-module.h"
 
+#include <sstream>
+
 const uint32_t RMCAT_DEFAULT_RMIN  =  150000;  // in bps: 150Kbps
 const uint32_t RMCAT_DEFAULT_RMAX  = 1500000;  // in bps: 1.5Mbps
 const uint32_t RMCAT_DEFAULT_RINIT =  150000;  // in bps: 150Kbps
@@ -157,25 +160,39 @@ static void InstallApps (bool nada,
                          float minBw,
                          float maxBw,
                          float startTime,
-                         float stopTime)
+                         float stopTime,
+                         const std::string& traceFile,
+                         std::shared_ptr<rmcat::StatsSink> statsSink)
 {
     Ptr<RmcatSender> sendApp = CreateObject<RmcatSender> ();
     Ptr<RmcatReceiver> recvApp = CreateObject<RmcatReceiver> ();
     sender->AddApplication (sendApp);
     receiver->AddApplication (recvApp);
 
+    std::shared_ptr<rmcat::SenderBasedController> controller;
     if (nada) {
-        sendApp->SetController (std::make_shared<rmcat::NadaController> ());
+        controller = std::make_shared<rmcat::NadaController> ();
+    } else {
+        controller = std::make_shared<rmcat::DummyController> ();
     }
+    sendApp->SetController (controller);
     Ptr<Ipv4> ipv4 = receiver->GetObject<Ipv4> ();
     Ipv4Address receiverIp = ipv4->GetAddress (1, 0).GetLocal ();
     sendApp->Setup (receiverIp, port); // initBw, minBw, maxBw);
+    if (statsSink) {
+        // After Setup, which resets the controller
+        controller->setStatsSink (statsSink);
+    }
 
     const auto fps = 25.;
     auto innerCodec = new syncodecs::StatisticsCodec{fps};
     auto codec = new syncodecs::ShapedPacketizer{innerCodec, DEFAULT_PACKET_SIZE};
     sendApp->SetCodec (std::shared_ptr<syncodecs::Codec>{codec});
 
+    if (!traceFile.empty ()) {
+        sendApp->EnablePacketTrace (traceFile);
+    }
+
     recvApp->Setup (port);
 
     sendApp->SetStartTime (Seconds (startTime));
@@ -192,6 +209,8 @@ int main (int argc, char *argv[])
     int nUdp = 0;
     bool log = false;
     bool nada = true;
+    std::string tracePrefix;
+    std::string statsFile;
     std::string strArg  = "strArg default";
 
     CommandLine cmd;
@@ -200,6 +219,8 @@ int main (int argc, char *argv[])
     cmd.AddValue ("udp", "Number of UDP flows", nUdp);
     cmd.AddValue ("log", "Turn on logs", log);
     cmd.AddValue ("nada", "true: use NADA, false: use dummy", nada);
+    cmd.AddValue ("trace", "Record packet traces of RMCAT flows to <trace>-<flow>.rmtr", tracePrefix);
+    cmd.AddValue ("stats", "Write controller statistics to this binary file rather than logging them", statsFile);
     cmd.Parse (argc, argv);
 
     if (log) {
@@ -225,12 +246,25 @@ int main (int argc, char *argv[])
 
     NodeContainer nodes = BuildExampleTopo (linkBw, msDelay, msQDelay);
 
+    std::shared_ptr<rmcat::BinaryStatsSink> statsSink;
+    if (!statsFile.empty ()) {
+        statsSink = std::make_shared<rmcat::BinaryStatsSink> ();
+        const bool ok = statsSink->open (statsFile);
+        NS_ABORT_MSG_UNLESS (ok, "Cannot create stats file " << statsFile);
+    }
+
     int port = 8000;
     for (size_t i = 0; i < nRmcat; i++) {
         auto start = 10. * i;
         auto end = std::max (start + 1., endTime - start);
+        std::string traceFile;
+        if (!tracePrefix.empty ()) {
+            std::ostringstream oss;
+            oss << tracePrefix << "-" << i << ".rmtr";
+            traceFile = oss.str ();
+        }
         InstallApps (nada, nodes.Get (0), nodes.Get (1), port++,
-                     initBw, minBw, maxBw, start, end);
+                     initBw, minBw, maxBw, start, end, traceFile, statsSink);
     }
 
     for (size_t i = 0; i < nTcp; i++) {
@@ -254,6 +288,9 @@ int main (int argc, char *argv[])
     Simulator::Stop (Seconds (endTime));
     Simulator::Run ();
     Simulator::Destroy ();
+    if (statsSink) {
+        statsSink->close ();
+    }
     std::cout << "Done" << std::endl;
 
     return 0;
@@ -35,9 +35,34 @@ const uint32_t DEFAULT_PACKET_SIZE = 1000;
 const uint32_t IPV4_HEADER_SIZE = 20;
 const uint32_t UDP_HEADER_SIZE = 8;
 const uint32_t IPV4_UDP_OVERHEAD = IPV4_HEADER_SIZE + UDP_HEADER_SIZE;
+// rmcat's own media packets (see #ns3::MediaHeader )
+const uint32_t MEDIA_HEADER_SIZE = 20;
+const uint32_t IPV4_UDP_MEDIA_OVERHEAD = IPV4_UDP_OVERHEAD + MEDIA_HEADER_SIZE;
+// RTP media packets (see #ns3::RtpHeader )
+const uint32_t RTP_HEADER_SIZE = 12;            // fixed header, no CSRCs
+const uint32_t RTP_HEADER_EXTENSION_SIZE = 12;  // transport-wide seq, abs-send-time
+const uint32_t IPV4_UDP_RTP_OVERHEAD = IPV4_UDP_OVERHEAD +
+                                       RTP_HEADER_SIZE +
+                                       RTP_HEADER_EXTENSION_SIZE;
+const uint32_t RTP_VIDEO_CLOCK_RATE = 90000;    // Hz
+const uint8_t RTP_VIDEO_PAYLOAD_TYPE = 96;      // dynamic
+/**
+ * Maximum number of received media packets in an aggregated feedback
+ * report (see #ns3::RmcatReceiver::SetFeedbackInterval ). Without
+ * losses, such a report takes less than DEFAULT_PACKET_SIZE bytes
+ */
+const uint32_t FEEDBACK_MAX_PACKETS = 180;
+// ECN field: the two least significant bits of the IP TOS byte (RFC 3168)
+const uint8_t RMCAT_ECN_MASK = 0x03;
+const uint8_t RMCAT_ECN_ECT0 = 0x02;
 
 // syncodec parameters
 const uint32_t SYNCODEC_DEFAULT_FPS = 30;
+/**
+ * Interval, in seconds, over which #ns3::RmcatSender pulls packets from
+ * the codec at once in burst mode (see #ns3::RmcatSender::SetBurstMode )
+ */
+const double BURST_MODE_FRAME_INTERVAL = 1. / SYNCODEC_DEFAULT_FPS;
 enum SyncodecType {
     SYNCODEC_TYPE_PERFECT = 0,
     SYNCODEC_TYPE_FIXFPS,
@@ -65,6 +90,13 @@ const uint32_t T_MAX_S = 500;  // maximum simulation duration  in seconds
 const uint32_t T_TCP_LOG = 1;  // whether to log TCP flows
 
 /* Default topology setting parameters */
+// ECN-marking RED at the wired bottleneck, thresholds in ms at link capacity
+const uint32_t WIRED_TOPO_RED_MINTH_MS = 5;
+const uint32_t WIRED_TOPO_RED_MAXTH_MS = 15;
+// Device rate of a trace-driven bottleneck, well above any trace's peak rate
+const uint64_t WIRED_TOPO_TRACE_LINK_RATE = 1ull << 30; // 1 Gbps
+// Bytes a trace-driven bottleneck delivers per opportunity (Mahimahi's MTU)
+const uint32_t WIRED_TOPO_TRACE_MTU = 1500;
 const uint32_t WIFI_TOPO_MACQUEUE_MAXNPKTS = 1000;
 const uint32_t WIFI_TOPO_ARPCACHE_ALIVE_TIMEOUT = 24 * 60 * 60; // 24 hours
 const float WIFI_TOPO_2_4GHZ_PATHLOSS_EXPONENT = 3.0f;
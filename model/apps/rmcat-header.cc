@@ -26,9 +26,36 @@
  */
 
 #include "rmcat-header.h"
+#include "rmcat-constants.h"
+#include "ns3/assert.h"
+#include <limits>
 
 namespace ns3 {
 
+const uint16_t FEEDBACK_CHUNK_RECEIVED = 0x8000; /**< R bit of a chunk */
+const uint16_t FEEDBACK_CHUNK_LENGTH_MASK = 0x7fff;
+const uint8_t FEEDBACK_FORMAT_DELTA_MASK = 0x03; /**< DF field of the format */
+const uint8_t FEEDBACK_FORMAT_ECN = 0x04;        /**< E bit of the format */
+const uint8_t FEEDBACK_ECN_MASK = 0x03;
+
+/* Sequence comparison that supports wrapping */
+static bool SequenceLessThan (uint32_t lhs, uint32_t rhs)
+{
+    return int32_t (lhs - rhs) < 0;
+}
+
+/* Rounded division by #FeedbackHeader::FEEDBACK_DELTA_UNIT */
+static int64_t ToDeltaUnits (int64_t us)
+{
+    const int64_t unit = FeedbackHeader::FEEDBACK_DELTA_UNIT;
+    return us >= 0 ? (us + unit / 2) / unit : -((-us + unit / 2) / unit);
+}
+
+FeedbackHeader::FeedbackHeader ()
+: flow_id{0}
+, m_entries{}
+{}
+
 FeedbackHeader::~FeedbackHeader () {}
 
 TypeId MediaHeader::GetTypeId (void)
@@ -77,6 +104,134 @@ void MediaHeader::Print (std::ostream &os) const
        << ", timestamp = " << send_tstmp;
 }
 
+const uint8_t RTP_VERSION = 2;
+const uint16_t RTP_ONE_BYTE_EXTENSION_PROFILE = 0xBEDE;
+const uint8_t RTP_EXT_ID_ABS_SEND_TIME = 3;
+const uint8_t RTP_EXT_ID_TRANSPORT_SEQUENCE = 5;
+const uint8_t RTP_EXT_ID_STOP = 15;
+
+RtpHeader::RtpHeader ()
+: marker{false}
+, payload_type{0}
+, sequence{0}
+, timestamp{0}
+, ssrc{0}
+, transport_sequence{0}
+, abs_send_time{0}
+, m_size{RTP_HEADER_SIZE + RTP_HEADER_EXTENSION_SIZE}
+{}
+
+RtpHeader::~RtpHeader () {}
+
+TypeId RtpHeader::GetTypeId (void)
+{
+    static TypeId tid = TypeId ("RtpHeader")
+      .SetParent<Header> ()
+      .AddConstructor<RtpHeader> ()
+    ;
+    return tid;
+}
+
+TypeId RtpHeader::GetInstanceTypeId (void) const
+{
+    return GetTypeId ();
+}
+
+uint32_t RtpHeader::GetSerializedSize (void) const
+{
+    return m_size;
+}
+
+void RtpHeader::Serialize (Buffer::Iterator start) const
+{
+    // V=2, P=0, X=1, CC=0
+    start.WriteU8 ((RTP_VERSION << 6) | 0x10);
+    start.WriteU8 ((marker ? 0x80 : 0) | (payload_type & 0x7f));
+    start.WriteHtonU16 (sequence);
+    start.WriteHtonU32 (timestamp);
+    start.WriteHtonU32 (ssrc);
+
+    start.WriteHtonU16 (RTP_ONE_BYTE_EXTENSION_PROFILE);
+    start.WriteHtonU16 ((RTP_HEADER_EXTENSION_SIZE - 4) / 4); // in 32-bit words
+    start.WriteU8 ((RTP_EXT_ID_TRANSPORT_SEQUENCE << 4) | (2 - 1));
+    start.WriteHtonU16 (transport_sequence);
+    start.WriteU8 ((RTP_EXT_ID_ABS_SEND_TIME << 4) | (3 - 1));
+    start.WriteU8 ((abs_send_time >> 16) & 0xff);
+    start.WriteU8 ((abs_send_time >> 8) & 0xff);
+    start.WriteU8 (abs_send_time & 0xff);
+    start.WriteU8 (0); // padding
+}
+
+uint32_t RtpHeader::Deserialize (Buffer::Iterator start)
+{
+    const uint8_t first = start.ReadU8 ();
+    NS_ASSERT ((first >> 6) == RTP_VERSION);
+    const bool hasExtension = (first & 0x10) != 0;
+    const uint8_t csrcCount = first & 0x0f;
+    const uint8_t second = start.ReadU8 ();
+    marker = (second & 0x80) != 0;
+    payload_type = second & 0x7f;
+    sequence = start.ReadNtohU16 ();
+    timestamp = start.ReadNtohU32 ();
+    ssrc = start.ReadNtohU32 ();
+    start.Next (4 * csrcCount);
+    m_size = RTP_HEADER_SIZE + 4 * csrcCount;
+
+    transport_sequence = 0;
+    abs_send_time = 0;
+    if (!hasExtension) {
+        return m_size;
+    }
+    const uint16_t profile = start.ReadNtohU16 ();
+    const uint16_t words = start.ReadNtohU16 ();
+    m_size += 4 + 4 * words;
+    if (profile != RTP_ONE_BYTE_EXTENSION_PROFILE) {
+        start.Next (4 * words);
+        return m_size;
+    }
+    // One-byte header elements; other than the two known ones are skipped
+    uint32_t left = 4 * words;
+    while (left > 0) {
+        const uint8_t elementHeader = start.ReadU8 ();
+        --left;
+        if (elementHeader == 0) {
+            continue; // padding
+        }
+        const uint8_t id = elementHeader >> 4;
+        const uint8_t len = (elementHeader & 0x0f) + 1;
+        if (id == RTP_EXT_ID_STOP || len > left) {
+            start.Next (left);
+            break;
+        }
+        if (id == RTP_EXT_ID_TRANSPORT_SEQUENCE && len == 2) {
+            transport_sequence = start.ReadNtohU16 ();
+        } else if (id == RTP_EXT_ID_ABS_SEND_TIME && len == 3) {
+            abs_send_time = uint32_t (start.ReadU8 ()) << 16;
+            abs_send_time |= uint32_t (start.ReadU8 ()) << 8;
+            abs_send_time |= start.ReadU8 ();
+        } else {
+            start.Next (len);
+        }
+        left -= len;
+    }
+    return m_size;
+}
+
+void RtpHeader::Print (std::ostream &os) const
+{
+    os << "RtpHeader - ssrc = " << ssrc
+       << ", sequence = " << sequence
+       << ", timestamp = " << timestamp
+       << ", transport_sequence = " << transport_sequence
+       << ", abs_send_time = " << abs_send_time;
+}
+
+uint32_t RtpHeader::ToAbsSendTime (uint64_t us)
+{
+    // 18 fractional bits; the 6 integer bits wrap every 64 s
+    return uint32_t (((us << 18) / 1000000) & 0xffffff);
+}
+
 TypeId FeedbackHeader::GetTypeId (void)
 {
     static TypeId tid = TypeId ("FeedbackHeader")
@@ -93,31 +248,246 @@ TypeId FeedbackHeader::GetInstanceTypeId (void) const
 
 uint32_t FeedbackHeader::GetSerializedSize (void) const
 {
-    return sizeof (flow_id)      +
-           sizeof (sequence)     +
-           sizeof (receive_tstmp);
+    const uint32_t fixedSize = sizeof (flow_id) +
+                               sizeof (uint64_t) + // base timestamp
+                               sizeof (uint32_t) + // begin sequence
+                               sizeof (uint16_t) + // number of chunks
+                               sizeof (uint8_t);   // format
+    uint32_t deltaSize = sizeof (uint32_t);
+    switch (GetDeltaFormat ()) {
+        case DELTA_8BIT:
+            deltaSize = sizeof (uint8_t);
+            break;
+        case DELTA_16BIT:
+            deltaSize = sizeof (uint16_t);
+            break;
+        default:
+            break;
+    }
+    const uint32_t n = m_entries.size ();
+    return fixedSize +
+           GetNumChunks () * sizeof (uint16_t) +
+           (n > 0 ? (n - 1) * deltaSize : 0) +
+           (HasEcn () ? (n + 3) / 4 : 0);
 }
 
 void FeedbackHeader::Serialize (Buffer::Iterator start) const
 {
+    const auto format = GetDeltaFormat ();
+    const bool hasEcn = HasEcn ();
     start.WriteHtonU32 (flow_id);
-    start.WriteHtonU32 (sequence);
-    start.WriteHtonU64 (receive_tstmp);
+    start.WriteHtonU64 (m_entries.empty () ? 0 : m_entries.front ().receive_tstmp);
+    start.WriteHtonU32 (m_entries.empty () ? 0 : m_entries.front ().sequence);
+    start.WriteHtonU16 (GetNumChunks ());
+    start.WriteU8 (uint8_t (format) | (hasEcn ? FEEDBACK_FORMAT_ECN : 0));
+
+    // Runs of received packets, each followed by the run of lost packets
+    // up to the next received one
+    size_t i = 0;
+    while (i < m_entries.size ()) {
+        size_t j = i + 1;
+        while (j < m_entries.size () &&
+               m_entries[j].sequence == m_entries[j - 1].sequence + 1) {
+            ++j;
+        }
+        start.WriteHtonU16 (FEEDBACK_CHUNK_RECEIVED | uint16_t (j - i));
+        if (j < m_entries.size ()) {
+            const uint32_t lost = m_entries[j].sequence - m_entries[j - 1].sequence - 1;
+            start.WriteHtonU16 (uint16_t (lost));
+        }
+        i = j;
+    }
+
+    // Arrival time deltas. Rounded ones are taken from the arrival time
+    // the receiver will have decoded for the previous packet, as checked
+    // by GetDeltaFormat
+    uint64_t decoded = m_entries.empty () ? 0 : m_entries.front ().receive_tstmp;
+    for (size_t k = 1; k < m_entries.size (); ++k) {
+        const int64_t delta = int64_t (m_entries[k].receive_tstmp - decoded);
+        if (format == DELTA_32BIT) {
+            NS_ASSERT (delta == int64_t (int32_t (delta)));
+            start.WriteHtonU32 (uint32_t (int32_t (delta)));
+            decoded = m_entries[k].receive_tstmp;
+            continue;
+        }
+        const int64_t units = ToDeltaUnits (delta);
+        if (format == DELTA_8BIT) {
+            start.WriteU8 (uint8_t (units));
+        } else {
+            start.WriteHtonU16 (uint16_t (int16_t (units)));
+        }
+        decoded += units * FEEDBACK_DELTA_UNIT;
+    }
+
+    if (hasEcn) {
+        for (size_t k = 0; k < m_entries.size (); k += 4) {
+            uint8_t byte = 0;
+            for (size_t l = k; l < k + 4 && l < m_entries.size (); ++l) {
+                byte |= (m_entries[l].ecn & FEEDBACK_ECN_MASK) << (2 * (l - k));
+            }
+            start.WriteU8 (byte);
+        }
+    }
 }
 
 uint32_t FeedbackHeader::Deserialize (Buffer::Iterator start)
 {
+    m_entries.clear ();
     flow_id = start.ReadNtohU32 ();
-    sequence = start.ReadNtohU32 ();
-    receive_tstmp = start.ReadNtohU64 ();
+    const uint64_t baseTstmp = start.ReadNtohU64 ();
+    uint32_t sequence = start.ReadNtohU32 ();
+    const uint16_t numChunks = start.ReadNtohU16 ();
+    const uint8_t format = start.ReadU8 ();
+
+    for (uint16_t chunk = 0; chunk < numChunks; ++chunk) {
+        const uint16_t header = start.ReadNtohU16 ();
+        const uint16_t runLength = header & FEEDBACK_CHUNK_LENGTH_MASK;
+        if ((header & FEEDBACK_CHUNK_RECEIVED) != 0) {
+            for (uint16_t k = 0; k < runLength; ++k) {
+                RecvEntry entry;
+                entry.sequence = sequence + k;
+                entry.receive_tstmp = 0;
+                entry.ecn = 0;
+                m_entries.push_back (entry);
+            }
+        }
+        sequence += runLength;
+    }
+
+    const auto deltaFormat = DeltaFormat (format & FEEDBACK_FORMAT_DELTA_MASK);
+    uint64_t tstmp = baseTstmp;
+    for (size_t k = 0; k < m_entries.size (); ++k) {
+        if (k > 0) {
+            switch (deltaFormat) {
+                case DELTA_8BIT:
+                    tstmp += uint64_t (start.ReadU8 ()) * FEEDBACK_DELTA_UNIT;
+                    break;
+                case DELTA_16BIT:
+                    tstmp += int64_t (int16_t (start.ReadNtohU16 ())) * FEEDBACK_DELTA_UNIT;
+                    break;
+                default:
+                    tstmp += int64_t (int32_t (start.ReadNtohU32 ()));
+                    break;
+            }
+        }
+        m_entries[k].receive_tstmp = tstmp;
+    }
+
+    if ((format & FEEDBACK_FORMAT_ECN) != 0) {
+        for (size_t k = 0; k < m_entries.size (); k += 4) {
+            const uint8_t byte = start.ReadU8 ();
+            for (size_t l = k; l < k + 4 && l < m_entries.size (); ++l) {
+                m_entries[l].ecn = (byte >> (2 * (l - k))) & FEEDBACK_ECN_MASK;
+            }
+        }
+    }
     return GetSerializedSize ();
 }
 
 void FeedbackHeader::Print (std::ostream &os) const
 {
     os << "FeedbackHeader - flow_id = " << flow_id
-       << ", sequence = " << sequence
-       << ",receive_tstmp = " << receive_tstmp;
+       << ", received = " << m_entries.size ()
+       << ", delta format = " << GetDeltaFormat ();
+    if (!m_entries.empty ()) {
+        os << ", sequences = [" << m_entries.front ().sequence
+           << ", " << m_entries.back ().sequence << "]";
+    }
+}
+
+bool FeedbackHeader::AddFeedback (uint32_t sequence, uint64_t receiveTstmp, uint8_t ecn)
+{
+    RecvEntry entry;
+    entry.sequence = sequence;
+    entry.receive_tstmp = receiveTstmp;
+    entry.ecn = ecn;
+
+    if (m_entries.empty () ||
+        SequenceLessThan (m_entries.back ().sequence, sequence)) {
+        // Common case: in order arrival
+        if (!m_entries.empty () &&
+            sequence - m_entries.front ().sequence >= FEEDBACK_MAX_SPAN) {
+            return false;
+        }
+        m_entries.push_back (entry);
+        return true;
+    }
+
+    auto it = m_entries.end ();
+    while (it != m_entries.begin () && SequenceLessThan (sequence, (it - 1)->sequence)) {
+        --it;
+    }
+    if (it != m_entries.begin () && (it - 1)->sequence == sequence) {
+        // Duplicate
+        return true;
+    }
+    if (it == m_entries.begin () &&
+        m_entries.back ().sequence - sequence >= FEEDBACK_MAX_SPAN) {
+        return false;
+    }
+    m_entries.insert (it, entry);
+    return true;
+}
+
+const std::vector<FeedbackHeader::RecvEntry>& FeedbackHeader::GetFeedback () const
+{
+    return m_entries;
+}
+
+void FeedbackHeader::Clear ()
+{
+    m_entries.clear ();
+}
+
+bool FeedbackHeader::IsEmpty () const
+{
+    return m_entries.empty ();
+}
+
+uint32_t FeedbackHeader::GetNumChunks () const
+{
+    if (m_entries.empty ()) {
+        return 0;
+    }
+    // One chunk for every run of received packets, plus one for every gap
+    uint32_t gaps = 0;
+    for (size_t i = 1; i < m_entries.size (); ++i) {
+        if (m_entries[i].sequence != m_entries[i - 1].sequence + 1) {
+            ++gaps;
+        }
+    }
+    return 2 * gaps + 1;
+}
+
+FeedbackHeader::DeltaFormat FeedbackHeader::GetDeltaFormat () const
+{
+    // Deltas are checked as they will be encoded: from the decoded arrival
+    // time of the previous packet
+    auto format = DELTA_8BIT;
+    uint64_t decoded = m_entries.empty () ? 0 : m_entries.front ().receive_tstmp;
+    for (size_t k = 1; k < m_entries.size (); ++k) {
+        const int64_t delta = int64_t (m_entries[k].receive_tstmp - decoded);
+        const int64_t units = ToDeltaUnits (delta);
+        if (units < std::numeric_limits<int16_t>::min () ||
+            units > std::numeric_limits<int16_t>::max ()) {
+            return DELTA_32BIT;
+        }
+        if (units < 0 || units > std::numeric_limits<uint8_t>::max ()) {
+            format = DELTA_16BIT;
+        }
+        decoded += units * FEEDBACK_DELTA_UNIT;
+    }
+    return format;
+}
+
+bool FeedbackHeader::HasEcn () const
+{
+    for (const auto& entry : m_entries) {
+        if ((entry.ecn & FEEDBACK_ECN_MASK) != 0) {
+            return true;
+        }
+    }
+    return false;
 }
 
 }
@@ -30,11 +30,10 @@
 
 #include "ns3/header.h"
 #include "ns3/type-id.h"
+#include <vector>
 
 namespace ns3 {
 
-// TODO (deferred) conform to RTP header formatting
-//
 //---------------------- MEDIA HEADER -----------------------------//
 //   0                   1                   2                   3
 //   0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
@@ -61,29 +60,129 @@ public:
 
     uint32_t flow_id;
     uint32_t sequence;
-    uint64_t send_tstmp;
+    uint64_t send_tstmp;  // in us
     uint32_t packet_size;
 };
 
 
-// TODO (deferred): implement header format as described in
-//                  draft-dt-rmcat-feedback-message
+//------------------------ RTP HEADER -----------------------------//
+// Media header conforming to RTP (RFC 3550), used instead of #MediaHeader
+// if enabled on both the sender and the receiver (see
+// #RmcatSender::SetRtpHeader ). The fixed header is followed by a
+// one-byte header extension block (RFC 8285) with two elements, as
+// WebRTC stacks send them: transport-wide sequence number
+// (draft-holmer-rmcat-transport-wide-cc-extensions) and abs-send-time
+// (http://www.webrtc.org/experiments/rtp-hdrext/abs-send-time)
+//
+//   0                   1                   2                   3
+//   0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+//  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//  |V=2|P|X|  CC   |M|     PT      |       sequence number         |
+//  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//  |                           timestamp                           |
+//  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//  |           synchronization source (SSRC) identifier            |
+//  +=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+
+//  |            0xBEDE             |           length=2            |
+//  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//  |  ID   | L=1   |     transport-wide sequence   |  ID   | L=2   |
+//  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//  |                  abs-send-time                |  0 (padding)  |
+//  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//
+// The SSRC carries the flow id. Sequence numbers are 16 bits: endpoints
+// unwrap them into the 32-bit sequences the controllers work with
+class RtpHeader : public ns3::Header
+{
+public:
+    RtpHeader ();
+    virtual ~RtpHeader ();
+
+    static ns3::TypeId GetTypeId ();
+    virtual ns3::TypeId GetInstanceTypeId () const;
+    virtual uint32_t GetSerializedSize () const;
+    virtual void Serialize (ns3::Buffer::Iterator start) const;
+    virtual uint32_t Deserialize (ns3::Buffer::Iterator start);
+    virtual void Print (std::ostream &os) const;
+
+    /** abs-send-time (6.18 fixed point seconds, 24 bits) of a time in us */
+    static uint32_t ToAbsSendTime (uint64_t us);
+
+    bool marker;
+    uint8_t payload_type;
+    uint16_t sequence;
+    uint32_t timestamp;            // media clock, see RTP_VIDEO_CLOCK_RATE
+    uint32_t ssrc;
+    uint16_t transport_sequence;   // header extension
+    uint32_t abs_send_time;        // header extension
+
+private:
+    uint32_t m_size; // bytes deserialized, CSRCs and other extensions included
+};
+
 
 //--------------------- FEEDBACK HEADER ---------------------------//
+// A feedback report covers a range of consecutive sequences, described as
+// runs of received and lost packets (in the spirit of RFC 8888, with run
+// length encoding of the packets' state, see RFC 3611)
+//
 //   0                   1                   2                   3
 //   0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
 //  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
 //  |                           flow_id                             |
 //  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
-//  |                          sequence                             |
+//  |                      base t(ime)st(a)mp  (1)                  |
+//  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//  |                      base t(ime)st(a)mp  (2)                  |
 //  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
-//  |                  receive t(ime)st(a)mp  (1)                   |
+//  |                       begin sequence                          |
 //  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
-//  |                  receive t(ime)st(a)mp  (2)                   |
+//  |        number of chunks       |  format   |E|DF |  chunks ... |
+//  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//  |  ... chunks   |  arrival time deltas ...  |  ECN markings ...  |
 //  +=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+
+//
+// Each chunk is a run of packets with consecutive sequences, all received
+// (R = 1) or all lost (R = 0)
+//
+//   0                   1
+//   0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5
+//  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//  |R|         run length          |
+//  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//
+// The base timestamp is the arrival time, in us, of the first packet
+// received (in sequence order). Every other packet received has an arrival
+// time delta: time elapsed since the arrival of the previous packet
+// received (in sequence order, so deltas can be negative). Deltas are all
+// of the size given by DF (delta format), the smallest that fits them in
+// the report, like transport-wide congestion control feedback does:
+//  - 0: 8 bits, unsigned, in units of #FEEDBACK_DELTA_UNIT us
+//  - 1: 16 bits, signed, in units of #FEEDBACK_DELTA_UNIT us
+//  - 2: 32 bits, signed, in us
+// With 8 or 16 bit deltas, arrival times are rounded, so as not to
+// accumulate errors, to within half a unit.
+//
+// If E is set, the 2-bit ECN markings of the packets received follow, four
+// per byte; otherwise all were Not-ECT
 class FeedbackHeader : public ns3::Header
 {
 public:
+    /** A media packet covered by the report, and received */
+    struct RecvEntry {
+        uint32_t sequence;
+        uint64_t receive_tstmp;  // in us
+        uint8_t ecn;
+    };
+
+    /** Size of arrival time deltas (see DF above) */
+    enum DeltaFormat {
+        DELTA_8BIT = 0,
+        DELTA_16BIT = 1,
+        DELTA_32BIT = 2,
+    };
+
+    FeedbackHeader ();
     virtual ~FeedbackHeader ();
 
     static ns3::TypeId GetTypeId ();
@@ -93,9 +192,46 @@ public:
     virtual uint32_t Deserialize (ns3::Buffer::Iterator start);
     virtual void Print (std::ostream &os) const;
 
+    /**
+     * Add a received media packet to the report. Packets can be added in
+     * any order; a sequence already in the report is ignored
+     *
+     * @param [in] sequence Sequence of the media packet
+     * @param [in] receiveTstmp Time it was received at, in us
+     * @param [in] ecn ECN marking of the packet (2 bits)
+     * @retval false if the packet could not be added, because the range of
+     *         sequences covered would become too large (see
+     *         #FEEDBACK_MAX_SPAN ); the report is left unchanged
+     */
+    bool AddFeedback (uint32_t sequence, uint64_t receiveTstmp, uint8_t ecn = 0);
+
+    /**
+     * Received packets in the report, in sequence order. Once deserialized,
+     * arrival times are as precise as the delta format allows
+     */
+    const std::vector<RecvEntry>& GetFeedback () const;
+
+    /** Remove all packets from the report */
+    void Clear ();
+
+    /** Whether the report covers no packets */
+    bool IsEmpty () const;
+
+    /** Smallest delta format able to encode the report's arrival times */
+    DeltaFormat GetDeltaFormat () const;
+
+    /** Maximum number of sequences a report can cover, lost ones included */
+    static const uint32_t FEEDBACK_MAX_SPAN = 0x7fff;
+    /** Unit of 8 and 16 bit arrival time deltas, in us */
+    static const uint32_t FEEDBACK_DELTA_UNIT = 250;
+
     uint32_t flow_id;
-    uint32_t sequence;
-    uint64_t receive_tstmp;
+
+private:
+    uint32_t GetNumChunks () const;
+    bool HasEcn () const;
+
+    std::vector<RecvEntry> m_entries;  // sorted by sequence
 };
 
 }
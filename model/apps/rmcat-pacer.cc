@@ -0,0 +1,148 @@
+/******************************************************************************
+ * Copyright 2016-2017 Cisco Systems, Inc.                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ *                                                                            *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+/**
+ * @file
+ * Pacer (rate shaping buffer) implementation for rmcat ns3 module.
+ *
+ * @version 0.1.0
+ * @author Jiantao Fu
+ * @author Sergio Mena
+ * @author Xiaoqing Zhu
+ */
+
+#include "rmcat-pacer.h"
+#include "ns3/assert.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ns3 {
+
+RmcatPacer::RmcatPacer ()
+: m_buffer{}
+, m_bytes{0}
+, m_rate{0.}
+, m_burst{0}
+, m_overhead{0}
+, m_tokens{0.}
+, m_lastRefill{}
+{}
+
+void RmcatPacer::SetRate (double bps, Time now)
+{
+    NS_ASSERT (bps > 0.);
+    Refill (now);
+    m_rate = bps;
+}
+
+double RmcatPacer::GetRate () const
+{
+    return m_rate;
+}
+
+void RmcatPacer::SetBurstAllowance (uint32_t bytes)
+{
+    m_burst = bytes;
+    m_tokens = std::min<double> (m_tokens, m_burst);
+}
+
+uint32_t RmcatPacer::GetBurstAllowance () const
+{
+    return m_burst;
+}
+
+void RmcatPacer::SetPacketOverhead (uint32_t bytes)
+{
+    m_overhead = bytes;
+}
+
+uint32_t RmcatPacer::GetPacketOverhead () const
+{
+    return m_overhead;
+}
+
+void RmcatPacer::Enqueue (uint32_t bytes)
+{
+    m_buffer.push_back (bytes);
+    m_bytes += bytes;
+}
+
+uint32_t RmcatPacer::Dequeue (Time now)
+{
+    NS_ASSERT (!m_buffer.empty ());
+    const auto bytes = m_buffer.front ();
+    m_buffer.pop_front ();
+    NS_ASSERT (m_bytes >= bytes);
+    m_bytes -= bytes;
+
+    Refill (now);
+    m_tokens -= bytes + m_overhead;
+    return bytes;
+}
+
+Time RmcatPacer::GetTimeToNextSend (Time now)
+{
+    Refill (now);
+    if (m_tokens >= 0.) {
+        return Time{0};
+    }
+    NS_ASSERT (m_rate > 0.);
+    // Rounded up, so that the debt is paid off when the time comes
+    const double ns = std::ceil (-m_tokens * 8. * 1e9 / m_rate);
+    return NanoSeconds (static_cast<uint64_t> (ns));
+}
+
+bool RmcatPacer::IsEmpty () const
+{
+    return m_buffer.empty ();
+}
+
+size_t RmcatPacer::GetSize () const
+{
+    return m_buffer.size ();
+}
+
+uint32_t RmcatPacer::GetBytes () const
+{
+    return m_bytes;
+}
+
+void RmcatPacer::Clear (Time now)
+{
+    m_buffer.clear ();
+    m_bytes = 0;
+    m_tokens = m_burst;
+    m_lastRefill = now;
+}
+
+void RmcatPacer::Refill (Time now)
+{
+    if (now <= m_lastRefill) {
+        // Already accounted for
+        return;
+    }
+    const double elapsed = (now - m_lastRefill).GetSeconds ();
+    // The cap leaves room for up to 1 ns worth of tokens, so that the
+    // rounding up of #GetTimeToNextSend carries over to the next packet
+    // instead of adding up over consecutive packets
+    const double cap = m_burst + m_rate / 8. * 1e-9;
+    m_tokens = std::min<double> (cap, m_tokens + m_rate / 8. * elapsed);
+    m_lastRefill = now;
+}
+
+}
@@ -0,0 +1,138 @@
+/******************************************************************************
+ * Copyright 2016-2017 Cisco Systems, Inc.                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ *                                                                            *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+/**
+ * @file
+ * Pacer (rate shaping buffer) interface for rmcat ns3 module.
+ *
+ * @version 0.1.0
+ * @author Jiantao Fu
+ * @author Sergio Mena
+ * @author Xiaoqing Zhu
+ */
+
+#ifndef RMCAT_PACER_H
+#define RMCAT_PACER_H
+
+#include "ns3/nstime.h"
+#include <deque>
+#include <cstddef>
+
+namespace ns3 {
+
+/**
+ * Rate shaping buffer of #RmcatSender (see draft-ietf-rmcat-nada): media
+ * packets produced by the codec wait here until the pacer lets them go
+ * at the sending rate.
+ *
+ * Departures are governed by a token bucket, kept with the simulator's
+ * (nanosecond) time resolution. Tokens, in bytes, accumulate at the
+ * sending rate up to the burst allowance. A packet may leave whenever the
+ * bucket is not in debt, and takes its size from the bucket, which can
+ * thus go negative. With no burst allowance, consecutive packets are
+ * spaced by exactly size / rate, however small that is; with a burst
+ * allowance, that many bytes (plus the packet that takes the bucket into
+ * debt) can leave back to back after an idle period.
+ *
+ * Calls take the time they apply to, which must not go backwards; the
+ * sender may plan departures a little ahead of the simulator's clock
+ * (see #RmcatSender::SetBurstMode ). A call for a time earlier than one
+ * already accounted for is taken as happening at that later time.
+ */
+class RmcatPacer
+{
+public:
+    RmcatPacer ();
+
+    /**
+     * Set the sending rate. Tokens accumulated so far are accounted for
+     * at the previous rate
+     *
+     * @param [in] bps New sending rate, in bps; must be positive
+     * @param [in] now Time at which the rate changes
+     */
+    void SetRate (double bps, Time now);
+
+    /** Current sending rate, in bps */
+    double GetRate () const;
+
+    /**
+     * Set the number of tokens, in bytes, the bucket can accumulate while
+     * idle (default: 0, i.e., strict pacing)
+     */
+    void SetBurstAllowance (uint32_t bytes);
+
+    /** Current burst allowance, in bytes */
+    uint32_t GetBurstAllowance () const;
+
+    /**
+     * Set the number of bytes each packet carries on the wire on top of
+     * its buffered size, e.g., an RTP header (default: 0). They are taken
+     * from the token bucket along with the packet, so that the sending
+     * rate covers them, but are not counted in #GetBytes
+     */
+    void SetPacketOverhead (uint32_t bytes);
+
+    /** Current per-packet overhead, in bytes */
+    uint32_t GetPacketOverhead () const;
+
+    /** Append a packet of the given size to the buffer */
+    void Enqueue (uint32_t bytes);
+
+    /**
+     * Remove the packet at the head of the buffer, taking its size (plus
+     * the per-packet overhead) from the token bucket. Callers are expected to respect #GetTimeToNextSend ,
+     * but the packet is released anyway
+     *
+     * @param [in] now Departure time of the packet
+     * @retval Size of the packet, in bytes
+     */
+    uint32_t Dequeue (Time now);
+
+    /**
+     * Time to wait, from now, until the packet at the head of the buffer
+     * (or the next one enqueued, if the buffer is empty) may be sent
+     */
+    Time GetTimeToNextSend (Time now);
+
+    /** Whether the buffer is empty */
+    bool IsEmpty () const;
+
+    /** Number of packets in the buffer */
+    size_t GetSize () const;
+
+    /** Number of bytes in the buffer */
+    uint32_t GetBytes () const;
+
+    /** Drop all buffered packets and reset the token bucket */
+    void Clear (Time now);
+
+private:
+    void Refill (Time now);
+
+    std::deque<uint32_t> m_buffer; // packet sizes, in bytes
+    uint32_t m_bytes;
+    double m_rate;          // bps
+    uint32_t m_burst;       // bytes
+    uint32_t m_overhead;    // bytes per packet
+    double m_tokens;        // bytes; negative while in debt
+    Time m_lastRefill;
+};
+
+}
+
+#endif /* RMCAT_PACER_H */
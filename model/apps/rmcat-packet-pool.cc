@@ -0,0 +1,96 @@
+/******************************************************************************
+ * Copyright 2016-2017 Cisco Systems, Inc.                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ *                                                                            *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+/**
+ * @file
+ * Packet pool implementation for rmcat ns3 module.
+ *
+ * @version 0.1.0
+ * @author Jiantao Fu
+ * @author Sergio Mena
+ * @author Xiaoqing Zhu
+ */
+
+#include "rmcat-packet-pool.h"
+#include "ns3/assert.h"
+
+namespace ns3 {
+
+RmcatPacketPool::RmcatPacketPool (size_t capacity)
+: m_packets{}
+, m_capacity{capacity}
+, m_next{0}
+, m_requests{0}
+, m_allocations{0}
+{
+    m_packets.reserve (m_capacity);
+}
+
+Ptr<Packet> RmcatPacketPool::Get (uint32_t payloadSize)
+{
+    ++m_requests;
+    // Packets are handed out in turn, so the one after the last handed out
+    // is usually the oldest, and the most likely to be free
+    for (size_t i = 0; i < m_packets.size (); ++i) {
+        const size_t index = (m_next + i) % m_packets.size ();
+        const Ptr<Packet>& packet = m_packets[index];
+        if (packet->GetReferenceCount () != 1) {
+            // Still held by the application or the network stack
+            continue;
+        }
+        m_next = index + 1;
+        packet->RemoveAllPacketTags ();
+        packet->RemoveAllByteTags ();
+        packet->RemoveAtStart (packet->GetSize ());
+        packet->AddPaddingAtEnd (payloadSize);
+        NS_ASSERT (packet->GetSize () == payloadSize);
+        return packet;
+    }
+
+    ++m_allocations;
+    auto packet = Create<Packet> (payloadSize);
+    if (m_packets.size () < m_capacity) {
+        m_packets.push_back (packet);
+    }
+    return packet;
+}
+
+void RmcatPacketPool::Clear ()
+{
+    m_packets.clear ();
+    m_next = 0;
+}
+
+uint64_t RmcatPacketPool::GetRequests () const
+{
+    return m_requests;
+}
+
+uint64_t RmcatPacketPool::GetAllocations () const
+{
+    return m_allocations;
+}
+
+double RmcatPacketPool::GetAllocationsPerPacket () const
+{
+    if (m_requests == 0) {
+        return 0.;
+    }
+    return double (m_allocations) / double (m_requests);
+}
+
+}
@@ -0,0 +1,94 @@
+/******************************************************************************
+ * Copyright 2016-2017 Cisco Systems, Inc.                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ *                                                                            *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+/**
+ * @file
+ * Packet pool interface for rmcat ns3 module.
+ *
+ * @version 0.1.0
+ * @author Jiantao Fu
+ * @author Sergio Mena
+ * @author Xiaoqing Zhu
+ */
+
+#ifndef RMCAT_PACKET_POOL_H
+#define RMCAT_PACKET_POOL_H
+
+#include "ns3/packet.h"
+#include "ns3/ptr.h"
+#include <vector>
+#include <cstddef>
+
+namespace ns3 {
+
+/**
+ * Recycles the packets an rmcat application sends, so that sending does
+ * not allocate a new #Packet every time in the steady state.
+ *
+ * The pool keeps a reference to every packet it hands out. Once the
+ * application and the network stack have dropped theirs (the pool holds
+ * the only one left), the packet is free again: its headers, trailers and
+ * tags are stripped, and it is resized to the payload requested. Only
+ * when no packet is free is a new one created; the pool keeps up to its
+ * capacity of them.
+ *
+ * Recycled packets keep their uid; tools that identify packets by uid
+ * across the whole simulation (e.g., FlowMonitor) should not be used with
+ * a pool. The topologies' bottleneck sojourn times do not rely on uids:
+ * they are keyed by queue item (see #SojournStats ).
+ */
+class RmcatPacketPool
+{
+public:
+    /**
+     * Class constructor
+     *
+     * @param [in] capacity Maximum number of packets kept for reuse
+     */
+    explicit RmcatPacketPool (size_t capacity = DEFAULT_CAPACITY);
+
+    /**
+     * Get a packet with a zero-filled payload of the given size, and
+     * nothing else
+     */
+    Ptr<Packet> Get (uint32_t payloadSize);
+
+    /** Drop all the packets kept; statistics are kept */
+    void Clear ();
+
+    /** Number of packets requested so far */
+    uint64_t GetRequests () const;
+
+    /** Number of packets created so far, to serve the requests */
+    uint64_t GetAllocations () const;
+
+    /** Packets created per packet requested, 0 if none requested */
+    double GetAllocationsPerPacket () const;
+
+    static const size_t DEFAULT_CAPACITY = 64; /**< packets */
+
+private:
+    std::vector<Ptr<Packet> > m_packets;
+    size_t m_capacity;
+    size_t m_next;          // where to start looking for a free packet
+    uint64_t m_requests;
+    uint64_t m_allocations;
+};
+
+}
+
+#endif /* RMCAT_PACKET_POOL_H */
@@ -27,6 +27,7 @@
 
 #include "rmcat-receiver.h"
 #include "rmcat-header.h"
+#include "rmcat-constants.h"
 #include "ns3/udp-socket-factory.h"
 #include "ns3/packet.h"
 #include "ns3/simulator.h"
@@ -36,18 +37,52 @@ NS_LOG_COMPONENT_DEFINE ("RmcatReceiver");
 
 namespace ns3 {
 
+RmcatReceiver::RmcatReceiver ()
+: m_running{false}
+, m_socket{}
+, m_rtpHeader{false}
+, m_packetPool{}
+, m_feedbackInterval{}
+, m_flows{}
+{}
+
 RmcatReceiver::~RmcatReceiver () {}
 
+bool RmcatReceiver::FlowKey::operator< (const FlowKey& other) const
+{
+    if (flowId != other.flowId) {
+        return flowId < other.flowId;
+    }
+    if (ip != other.ip) {
+        return ip < other.ip;
+    }
+    return port < other.port;
+}
+
 void RmcatReceiver::Setup (uint16_t port)
 {
     m_socket = Socket::CreateSocket (GetNode (), UdpSocketFactory::GetTypeId ());
     auto local = InetSocketAddress{Ipv4Address::GetAny (), port};
     auto ret = m_socket->Bind (local);
     NS_ASSERT (ret == 0);
+    m_socket->SetIpRecvTos (true); // ECN codepoints, reported in the feedback
     m_socket->SetRecvCallback (MakeCallback (&RmcatReceiver::RecvPacket,this));
+}
 
-    m_running = false;
-    m_waiting = true;
+void RmcatReceiver::SetFeedbackInterval (Time interval)
+{
+    NS_ASSERT (!interval.IsNegative ());
+    m_feedbackInterval = interval;
+}
+
+void RmcatReceiver::SetRtpHeader (bool enable)
+{
+    m_rtpHeader = enable;
+}
+
+size_t RmcatReceiver::GetNumFlows () const
+{
+    return m_flows.size ();
 }
 
 void RmcatReceiver::StartApplication ()
@@ -58,6 +93,15 @@ void RmcatReceiver::StartApplication ()
 void RmcatReceiver::StopApplication ()
 {
     m_running = false;
+    for (auto& flow : m_flows) {
+        Simulator::Cancel (flow.second.feedbackEvent);
+        flow.second.feedback.Clear ();
+    }
+    NS_LOG_INFO ("RmcatReceiver::StopApplication, flows: " << m_flows.size ()
+                 << ", feedback packets: " << m_packetPool.GetRequests ()
+                 << ", allocations per packet: "
+                 << m_packetPool.GetAllocationsPerPacket ());
+    m_packetPool.Clear ();
 }
 
 void RmcatReceiver::RecvPacket (Ptr<Socket> socket)
@@ -69,44 +113,88 @@ void RmcatReceiver::RecvPacket (Ptr<Socket> socket)
     Address remoteAddr;
     auto packet = m_socket->RecvFrom (remoteAddr);
     NS_ASSERT (packet);
-    MediaHeader header;
     NS_LOG_INFO ("RmcatReceiver::RecvPacket, " << packet->ToString ());
-    packet->RemoveHeader (header);
-    auto srcIp = InetSocketAddress::ConvertFrom (remoteAddr).GetIpv4 ();
-    auto srcPort = InetSocketAddress::ConvertFrom (remoteAddr).GetPort ();
-    if (m_waiting) {
-        m_waiting = false;
-        m_srcId = header.flow_id;
-        m_srcIp = srcIp;
-        m_srcPort = srcPort;
+    uint8_t ecn = 0;
+    SocketIpTosTag tosTag;
+    if (packet->RemovePacketTag (tosTag)) {
+        ecn = tosTag.GetTos () & RMCAT_ECN_MASK;
+    }
+    FlowKey key;
+    uint32_t sequence;
+    if (m_rtpHeader) {
+        RtpHeader header;
+        packet->RemoveHeader (header);
+        key.flowId = header.ssrc;
+        sequence = header.transport_sequence;
     } else {
-        // Only one flow supported
-        NS_ASSERT (m_srcId == header.flow_id);
-        NS_ASSERT (m_srcIp == srcIp);
-        NS_ASSERT (m_srcPort == srcPort);
+        MediaHeader header;
+        packet->RemoveHeader (header);
+        key.flowId = header.flow_id;
+        sequence = header.sequence;
+    }
+    key.ip = InetSocketAddress::ConvertFrom (remoteAddr).GetIpv4 ();
+    key.port = InetSocketAddress::ConvertFrom (remoteAddr).GetPort ();
+
+    auto flow = m_flows.find (key);
+    if (flow == m_flows.end ()) {
+        NS_LOG_INFO ("RmcatReceiver::RecvPacket, new flow " << key.flowId
+                     << " from " << key.ip << ":" << key.port);
+        FlowState state;
+        state.lastSequence = sequence;
+        flow = m_flows.insert (std::make_pair (key, state)).first;
     }
 
-    //TODO (deferred): We need to aggregate feedback information
-    //                 (for the moment, one feedback packet per media packet)
+    if (m_rtpHeader) {
+        // Unwrap to the closest sequence to the last one received
+        auto& lastSequence = flow->second.lastSequence;
+        const auto delta = static_cast<int16_t> (static_cast<uint16_t> (sequence - lastSequence));
+        sequence = lastSequence + delta;
+        if (delta > 0) {
+            lastSequence = sequence;
+        }
+    }
+
+    auto recvTimestamp = Simulator::Now ().GetMicroSeconds ();
+    AddFeedback (flow, sequence, recvTimestamp, ecn);
+}
+
+void RmcatReceiver::AddFeedback (FlowTable::iterator flow,
+                                 uint32_t sequence,
+                                 uint64_t recvTimestamp,
+                                 uint8_t ecn)
+{
+    auto& feedback = flow->second.feedback;
+    if (!feedback.AddFeedback (sequence, recvTimestamp, ecn)) {
+        // Range of sequences too large for one report
+        SendFeedback (flow);
+        feedback.AddFeedback (sequence, recvTimestamp, ecn); // into an empty report
+    }
 
-    auto recvTimestamp = Simulator::Now ().GetMilliSeconds ();
-    SendFeedback (header.sequence, recvTimestamp);
+    if (m_feedbackInterval.IsZero () ||
+        feedback.GetFeedback ().size () >= FEEDBACK_MAX_PACKETS) {
+        SendFeedback (flow);
+    } else if (!flow->second.feedbackEvent.IsRunning ()) {
+        flow->second.feedbackEvent = Simulator::Schedule (m_feedbackInterval,
+                                                          &RmcatReceiver::SendFeedback,
+                                                          this, flow);
+    }
 }
 
-void RmcatReceiver::SendFeedback (uint32_t sequence,
-                                  uint64_t recvTimestamp)
+void RmcatReceiver::SendFeedback (FlowTable::iterator flow)
 {
-    FeedbackHeader header;
-    header.flow_id = m_srcId;
-    header.sequence = sequence;
-    header.receive_tstmp = recvTimestamp;
+    auto& feedback = flow->second.feedback;
+    Simulator::Cancel (flow->second.feedbackEvent);
+    if (feedback.IsEmpty ()) {
+        return;
+    }
+    feedback.flow_id = flow->first.flowId;
 
-    auto packet = Create<Packet> ();
-    packet->AddHeader (header);
+    auto packet = m_packetPool.Get (0);
+    packet->AddHeader (feedback);
     NS_LOG_INFO ("RmcatReceiver::SendFeedback, " << packet->ToString ());
 
-    m_socket->SendTo (packet, 0, InetSocketAddress{m_srcIp, m_srcPort});
+    m_socket->SendTo (packet, 0, InetSocketAddress{flow->first.ip, flow->first.port});
+    feedback.Clear ();
 }
 
 }
-
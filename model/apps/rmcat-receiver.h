@@ -28,33 +28,79 @@
 #ifndef RMCAT_RECEIVER_H
 #define RMCAT_RECEIVER_H
 
+#include "rmcat-packet-pool.h"
+#include "rmcat-header.h"
 #include "ns3/socket.h"
 #include "ns3/application.h"
+#include <map>
 
 namespace ns3 {
 
+/**
+ * Receiver endpoint of rmcat flows. A single receiver (and socket) can
+ * sink many flows: flows are told apart by their flow id and source
+ * address and port, and each gets its own feedback reports
+ */
 class RmcatReceiver: public Application
 {
 public:
+    RmcatReceiver ();
     virtual ~RmcatReceiver ();
 
     void Setup (uint16_t port);
 
+    /**
+     * Aggregate feedback: instead of one report per media packet received,
+     * send a report covering all the packets of a flow received during the
+     * given interval (e.g., 20, 50 or 100 ms) after the first one. Reports
+     * are sent earlier if they grow too large (see #FEEDBACK_MAX_PACKETS ).
+     * A zero interval (default) sends a report for every media packet
+     */
+    void SetFeedbackInterval (Time interval);
+
+    /**
+     * Expect media packets with an RTP header (see #RtpHeader ) rather
+     * than a #MediaHeader (default: off); see #RmcatSender::SetRtpHeader
+     */
+    void SetRtpHeader (bool enable);
+
+    /** Number of flows received so far */
+    size_t GetNumFlows () const;
+
 private:
+    struct FlowKey {
+        uint32_t flowId;
+        Ipv4Address ip;
+        uint16_t port;
+
+        bool operator< (const FlowKey& other) const;
+    };
+
+    struct FlowState {
+        uint32_t lastSequence;    // unwrapped from RTP 16-bit sequences
+        FeedbackHeader feedback;  // report being built
+        EventId feedbackEvent;
+    };
+
+    typedef std::map<FlowKey, FlowState> FlowTable;
+
     virtual void StartApplication ();
     virtual void StopApplication ();
 
     void RecvPacket (Ptr<Socket> socket);
-    void SendFeedback (uint32_t sequence,
-                       uint64_t recvTimestamp);
+    void AddFeedback (FlowTable::iterator flow,
+                      uint32_t sequence,
+                      uint64_t recvTimestamp,
+                      uint8_t ecn);
+    void SendFeedback (FlowTable::iterator flow);
 
 private:
     bool m_running;
-    bool m_waiting;
-    uint32_t m_srcId;
-    Ipv4Address m_srcIp;
-    uint16_t m_srcPort;
     Ptr<Socket> m_socket;
+    bool m_rtpHeader;
+    RmcatPacketPool m_packetPool;
+    Time m_feedbackInterval;
+    FlowTable m_flows;
 };
 
 }
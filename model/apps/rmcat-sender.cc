@@ -34,7 +34,9 @@
 #include "ns3/simulator.h"
 #include "ns3/uinteger.h"
 #include "ns3/log.h"
+#include "ns3/abort.h"
 
+#include <algorithm>
 #include <sys/stat.h>
 
 NS_LOG_COMPONENT_DEFINE ("RmcatSender");
@@ -42,7 +44,14 @@ NS_LOG_COMPONENT_DEFINE ("RmcatSender");
 namespace ns3 {
 
 RmcatSender::RmcatSender ()
-: m_destIP{}
+: m_streams{}
+, m_totalWeight{0.}
+, m_controller{}
+, m_fse{}
+, m_fsePriority{1.f}
+, m_fseFlowId{0}
+, m_fseRegistered{false}
+, m_destIP{}
 , m_destPort{0}
 , m_initBw{0}
 , m_minBw{0}
@@ -50,14 +59,26 @@ RmcatSender::RmcatSender ()
 , m_paused{false}
 , m_flowId{0}
 , m_sequence{0}
-, m_enqueueEvent{}
 , m_sendEvent{}
 , m_sendOversleepEvent{}
 , m_rVin{0.}
-, m_rSend{0.}
-, m_rateShapingBytes{0}
-, m_nextSendTstmp{0}
-{}
+, m_pacer{}
+, m_burstMode{false}
+, m_rtpHeader{false}
+, m_ecn{false}
+, m_framePackets{}
+, m_departurePlanned{false}
+, m_nextDeparture{}
+, m_nextWireTime{}
+, m_sentPackets{0}
+, m_scheduledEvents{0}
+, m_traceRecorder{}
+, m_packetPool{}
+, m_feedbackBatch{}
+{
+    AddStream (std::shared_ptr<syncodecs::Codec>{}, 1.);
+    SetRtpHeader (false);
+}
 
 RmcatSender::~RmcatSender () {}
 
@@ -65,23 +86,40 @@ void RmcatSender::PauseResume (bool pause)
 {
     NS_ASSERT (pause != m_paused);
     if (pause) {
-        Simulator::Cancel (m_enqueueEvent);
+        for (auto& stream : m_streams) {
+            Simulator::Cancel (stream.enqueueEvent);
+        }
         Simulator::Cancel (m_sendEvent);
         Simulator::Cancel (m_sendOversleepEvent);
-        m_rateShapingBuf.clear ();
-        m_rateShapingBytes = 0;
+        ClearBuffers ();
+        DeregisterFlow ();
     } else {
         m_rVin = m_initBw;
-        m_rSend = m_initBw;
-        m_enqueueEvent = Simulator::ScheduleNow (&RmcatSender::EnqueuePacket, this);
-        m_nextSendTstmp = 0;
+        m_pacer.SetRate (m_initBw, Simulator::Now ());
+        ClearBuffers ();
+        RegisterFlow ();
+        for (size_t i = 0; i < m_streams.size (); ++i) {
+            ScheduleEnqueue (i, Seconds (0.0));
+        }
     }
     m_paused = pause;
 }
 
 void RmcatSender::SetCodec (std::shared_ptr<syncodecs::Codec> codec)
 {
-    m_codec = codec;
+    m_streams[0].codec = codec;
+}
+
+void RmcatSender::AddStream (std::shared_ptr<syncodecs::Codec> codec, double weight)
+{
+    NS_ASSERT (weight > 0.);
+    MediaStream stream;
+    stream.codec = codec;
+    stream.weight = weight;
+    stream.packets = 0;
+    stream.bytes = 0;
+    m_streams.push_back (stream);
+    m_totalWeight += weight;
 }
 
 // TODO (deferred): allow flexible input of video traffic trace path via config file, etc.
@@ -160,7 +198,7 @@ void RmcatSender::SetCodecType (SyncodecType codecType)
     }
 
     // update member variable
-    m_codec = std::shared_ptr<syncodecs::Codec>{codec};
+    m_streams[0].codec = std::shared_ptr<syncodecs::Codec>{codec};
 }
 
 void RmcatSender::SetController (std::shared_ptr<rmcat::SenderBasedController> controller)
@@ -168,11 +206,16 @@ void RmcatSender::SetController (std::shared_ptr<rmcat::SenderBasedController> c
     m_controller = controller;
 }
 
+std::shared_ptr<rmcat::SenderBasedController> RmcatSender::GetController () const
+{
+    return m_controller;
+}
+
 void RmcatSender::Setup (Ipv4Address destIP,
                          uint16_t destPort)
 {
-    if (!m_codec) {
-        m_codec = std::make_shared<syncodecs::PerfectCodec> (DEFAULT_PACKET_SIZE);
+    if (!m_streams[0].codec) {
+        m_streams[0].codec = std::make_shared<syncodecs::PerfectCodec> (DEFAULT_PACKET_SIZE);
     }
 
     if (!m_controller) {
@@ -185,6 +228,81 @@ void RmcatSender::Setup (Ipv4Address destIP,
     m_destPort = destPort;
 }
 
+void RmcatSender::EnablePacketTrace (const std::string& filename)
+{
+    const bool ok = m_traceRecorder.open (filename);
+    NS_ABORT_MSG_UNLESS (ok, "Cannot open packet trace file " << filename);
+}
+
+void RmcatSender::SetPacingBurst (uint32_t bytes)
+{
+    m_pacer.SetBurstAllowance (bytes);
+}
+
+void RmcatSender::SetBurstMode (bool enable)
+{
+    m_burstMode = enable;
+}
+
+uint64_t RmcatSender::GetSentPackets () const
+{
+    return m_sentPackets;
+}
+
+uint64_t RmcatSender::GetScheduledEvents () const
+{
+    return m_scheduledEvents;
+}
+
+const RmcatPacketPool& RmcatSender::GetPacketPool () const
+{
+    return m_packetPool;
+}
+
+void RmcatSender::SetRtpHeader (bool enable)
+{
+    m_rtpHeader = enable;
+    // The media header goes on the wire with every media packet, whichever
+    // it is: the pacer's rate and the controller's byte counts cover it
+    m_pacer.SetPacketOverhead (enable ? RTP_HEADER_SIZE + RTP_HEADER_EXTENSION_SIZE
+                                      : MEDIA_HEADER_SIZE);
+}
+
+void RmcatSender::SetEcn (bool enable)
+{
+    m_ecn = enable;
+}
+
+void RmcatSender::SetFlowStateExchange (std::shared_ptr<rmcat::FlowStateExchange> fse,
+                                        float priority)
+{
+    NS_ASSERT (priority > 0.);
+    m_fse = fse;
+    m_fsePriority = priority;
+}
+
+void RmcatSender::RegisterFlow ()
+{
+    if (!m_fse || m_fseRegistered) {
+        return;
+    }
+    const auto now = Simulator::Now ().GetMicroSeconds ();
+    m_fseFlowId = m_fse->registerFlow (m_controller, m_fsePriority,
+                                       m_minBw, m_maxBw,
+                                       m_controller->getBandwidth (now));
+    m_fseRegistered = true;
+    NS_LOG_INFO ("RmcatSender::RegisterFlow, coupled flows: " << m_fse->getNumFlows ());
+}
+
+void RmcatSender::DeregisterFlow ()
+{
+    if (!m_fseRegistered) {
+        return;
+    }
+    m_fse->deregisterFlow (m_fseFlowId);
+    m_fseRegistered = false;
+}
+
 void RmcatSender::SetRinit (float r)
 {
     m_initBw = r;
@@ -194,13 +312,13 @@ void RmcatSender::SetRinit (float r)
 void RmcatSender::SetRmin (float r)
 {
     m_minBw = r;
-    if (m_controller) m_controller->setInitBw (m_minBw);
+    if (m_controller) m_controller->setMinBw (m_minBw);
 }
 
 void RmcatSender::SetRmax (float r)
 {
     m_maxBw = r;
-    if (m_controller) m_controller->setInitBw (m_maxBw);
+    if (m_controller) m_controller->setMaxBw (m_maxBw);
 }
 
 void RmcatSender::StartApplication ()
@@ -212,122 +330,295 @@ void RmcatSender::StartApplication ()
     NS_ASSERT (m_initBw <= m_maxBw);
 
     m_rVin = m_initBw;
-    m_rSend = m_initBw;
+    m_pacer.SetRate (m_initBw, Simulator::Now ());
+    ClearBuffers ();
 
     if (m_socket == NULL) {
         m_socket = Socket::CreateSocket (GetNode (), UdpSocketFactory::GetTypeId ());
         auto res = m_socket->Bind ();
         NS_ASSERT (res == 0);
     }
+    m_socket->SetIpTos (m_ecn ? RMCAT_ECN_ECT0 : 0);
     m_socket->SetRecvCallback (MakeCallback (&RmcatSender::RecvPacket, this));
 
-    m_enqueueEvent = Simulator::Schedule (Seconds (0.0), &RmcatSender::EnqueuePacket, this);
-    m_nextSendTstmp = 0;
+    for (size_t i = 0; i < m_streams.size (); ++i) {
+        NS_ASSERT (m_streams[i].codec);
+        m_streams[i].packets = 0;
+        m_streams[i].bytes = 0;
+        ScheduleEnqueue (i, Seconds (0.0));
+    }
+    RegisterFlow ();
 }
 
 void RmcatSender::StopApplication ()
 {
-    Simulator::Cancel (m_enqueueEvent);
+    for (size_t i = 0; i < m_streams.size (); ++i) {
+        Simulator::Cancel (m_streams[i].enqueueEvent);
+        NS_LOG_INFO ("RmcatSender::StopApplication, stream " << i
+                     << ", weight: " << m_streams[i].weight
+                     << ", packets: " << m_streams[i].packets
+                     << ", bytes: " << m_streams[i].bytes);
+    }
     Simulator::Cancel (m_sendEvent);
     Simulator::Cancel (m_sendOversleepEvent);
-    m_rateShapingBuf.clear ();
-    m_rateShapingBytes = 0;
+    ClearBuffers ();
+    m_traceRecorder.close ();
+    NS_LOG_INFO ("RmcatSender::StopApplication, media packets: "
+                 << m_packetPool.GetRequests ()
+                 << ", allocations per packet: "
+                 << m_packetPool.GetAllocationsPerPacket ());
+    m_packetPool.Clear ();
+    DeregisterFlow ();
+    if (m_controller) {
+        m_controller->logEventCounters ();
+    }
 }
 
-void RmcatSender::EnqueuePacket ()
+/*
+ * The controller's rate, split among the streams in proportion to their
+ * weights
+ */
+double RmcatSender::GetStreamRate (size_t stream) const
 {
-    syncodecs::Codec& codec = *m_codec;
-    codec.setTargetRate (m_rVin);
+    return m_rVin * m_streams[stream].weight / m_totalWeight;
+}
+
+void RmcatSender::ScheduleEnqueue (size_t stream, Time delay)
+{
+    ++m_scheduledEvents;
+    m_streams[stream].enqueueEvent =
+        Simulator::Schedule (delay,
+                             m_burstMode ? &RmcatSender::EnqueueFrame :
+                                           &RmcatSender::EnqueuePacket,
+                             this, stream);
+}
+
+void RmcatSender::EnqueuePacket (size_t stream)
+{
+    syncodecs::Codec& codec = *m_streams[stream].codec;
+    codec.setTargetRate (GetStreamRate (stream));
     ++codec; // Advance codec/packetizer to next frame/packet
     const auto bytesToSend = codec->first.size ();
     NS_ASSERT (bytesToSend > 0);
     NS_ASSERT (bytesToSend <= DEFAULT_PACKET_SIZE);
 
-    m_rateShapingBuf.push_back (bytesToSend);
-    m_rateShapingBytes += bytesToSend;
+    m_pacer.Enqueue (bytesToSend);
+    ++m_streams[stream].packets;
+    m_streams[stream].bytes += bytesToSend;
 
-    NS_LOG_INFO ("RmcatSender::EnqueuePacket, packet enqueued, packet length: " << bytesToSend
-                 << ", buffer size: " << m_rateShapingBuf.size ()
-                 << ", buffer bytes: " << m_rateShapingBytes);
+    NS_LOG_INFO ("RmcatSender::EnqueuePacket, stream " << stream
+                 << ", packet enqueued, packet length: " << bytesToSend
+                 << ", buffer size: " << m_pacer.GetSize ()
+                 << ", buffer bytes: " << m_pacer.GetBytes ());
 
     auto secsToNextEnqPacket = codec->second;
     Time tNext{Seconds (secsToNextEnqPacket)};
-    m_enqueueEvent = Simulator::Schedule (tNext, &RmcatSender::EnqueuePacket, this);
+    ScheduleEnqueue (stream, tNext);
 
     if (!USE_BUFFER) {
+        // No pacing: the packet is sent right away
+        ++m_scheduledEvents;
         m_sendEvent = Simulator::ScheduleNow (&RmcatSender::SendPacket, this,
-                                              secsToNextEnqPacket * 1000.);
+                                              tNext);
         return;
     }
 
-    if (m_rateShapingBuf.size () == 1) {
+    if (m_pacer.GetSize () == 1) {
         // Buffer was empty
-        const auto now = Simulator::Now ().GetMilliSeconds ();
-        const auto msToNextSentPacket = now < m_nextSendTstmp ?
-                                                m_nextSendTstmp - now : 0;
-        NS_LOG_INFO ("(Re-)starting the send timer: now " << now
+        const auto tNextSend = m_pacer.GetTimeToNextSend (Simulator::Now ());
+        NS_LOG_INFO ("(Re-)starting the send timer: now " << Simulator::Now ()
                      << ", bytesToSend " << bytesToSend
-                     << ", msToNextSentPacket " << msToNextSentPacket
-                     << ", m_rSend " << m_rSend
+                     << ", tNextSend " << tNextSend
+                     << ", rSend " << m_pacer.GetRate ()
                      << ", m_rVin " << m_rVin
                      << ", secsToNextEnqPacket " << secsToNextEnqPacket);
 
-        Time tNext{MilliSeconds (msToNextSentPacket)};
-        m_sendEvent = Simulator::Schedule (tNext, &RmcatSender::SendPacket, this, msToNextSentPacket);
+        ++m_scheduledEvents;
+        m_sendEvent = Simulator::Schedule (tNextSend, &RmcatSender::SendPacket, this, tNextSend);
     }
 }
 
-void RmcatSender::SendPacket (uint64_t msSlept)
+void RmcatSender::SendPacket (Time slept)
 {
-    NS_ASSERT (m_rateShapingBuf.size () > 0);
-    NS_ASSERT (m_rateShapingBytes < MAX_QUEUE_SIZE_SANITY);
+    NS_ASSERT (!m_pacer.IsEmpty ());
+    NS_ASSERT (m_pacer.GetBytes () < MAX_QUEUE_SIZE_SANITY);
 
-    const auto bytesToSend = m_rateShapingBuf.front ();
+    const auto bytesToSend = m_pacer.Dequeue (Simulator::Now ());
     NS_ASSERT (bytesToSend > 0);
     NS_ASSERT (bytesToSend <= DEFAULT_PACKET_SIZE);
-    m_rateShapingBuf.pop_front ();
-    NS_ASSERT (m_rateShapingBytes >= bytesToSend);
-    m_rateShapingBytes -= bytesToSend;
 
-    const auto now = Simulator::Now ().GetMilliSeconds ();
+    const auto now = Simulator::Now ().GetMicroSeconds ();
 
     NS_LOG_INFO ("RmcatSender::SendPacket, packet dequeued, packet length: " << bytesToSend
-                 << ", buffer size: " << m_rateShapingBuf.size ()
-                 << ", buffer bytes: " << m_rateShapingBytes);
+                 << ", buffer size: " << m_pacer.GetSize ()
+                 << ", buffer bytes: " << m_pacer.GetBytes ());
 
     // Synthetic oversleep: random uniform [0% .. 1%]
-    auto oversleepMs = msSlept * (rand () % 100) / 10000;
-    Time tOver{MilliSeconds (oversleepMs)};
+    Time tOver{NanoSeconds (slept.GetNanoSeconds () * (rand () % 100) / 10000)};
+    ++m_scheduledEvents;
     m_sendOversleepEvent = Simulator::Schedule (tOver, &RmcatSender::SendOverSleep,
                                                 this, m_sequence, bytesToSend);
 
-    m_controller->processSendPacket (now, m_sequence++, bytesToSend);
+    const auto wireBytes = bytesToSend + m_pacer.GetPacketOverhead ();
+    m_traceRecorder.onSend (now, m_sequence, wireBytes);
+    m_controller->processSendPacket (now, m_sequence++, wireBytes);
+    ++m_sentPackets;
 
     // schedule next sendData
-    auto msToNextSentPacketD = static_cast<double> (bytesToSend) * 8. * 1000. / m_rSend;
-    auto msToNextSentPacket = static_cast<uint64_t> (msToNextSentPacketD);
-
-    if (!USE_BUFFER || m_rateShapingBuf.size () == 0) {
-        // Buffer became empty
-        m_nextSendTstmp = now + msToNextSentPacket;
+    if (!USE_BUFFER || m_pacer.IsEmpty ()) {
+        // Buffer became empty: the pacer remembers when the next packet
+        // can be sent
         return;
     }
 
-    Time tNext{MilliSeconds (msToNextSentPacket)};
-    m_sendEvent = Simulator::Schedule (tNext, &RmcatSender::SendPacket, this, msToNextSentPacket);
+    const auto tNext = m_pacer.GetTimeToNextSend (Simulator::Now ());
+    ++m_scheduledEvents;
+    m_sendEvent = Simulator::Schedule (tNext, &RmcatSender::SendPacket, this, tNext);
 }
 
-void RmcatSender::SendOverSleep (uint32_t seq, uint32_t bytesToSend) {
+void RmcatSender::EnqueueFrame (size_t stream)
+{
+    syncodecs::Codec& codec = *m_streams[stream].codec;
+    const auto now = Simulator::Now ();
+    const auto frameEnd = now + Seconds (BURST_MODE_FRAME_INTERVAL);
+    auto release = now;
+    // Same codec calls, and packet release times, as those EnqueuePacket
+    // would make over one frame interval
+    do {
+        codec.setTargetRate (GetStreamRate (stream));
+        ++codec; // Advance codec/packetizer to next frame/packet
+        const auto bytesToSend = codec->first.size ();
+        NS_ASSERT (bytesToSend > 0);
+        NS_ASSERT (bytesToSend <= DEFAULT_PACKET_SIZE);
+        const auto framePacket = std::make_pair (release, bytesToSend);
+        // Other streams' packets may be waiting; keep release time order
+        const auto pos = std::upper_bound (m_framePackets.begin (), m_framePackets.end (),
+                                           framePacket,
+                                           [] (const std::pair<Time, uint32_t>& a,
+                                               const std::pair<Time, uint32_t>& b) {
+                                               return a.first < b.first;
+                                           });
+        m_framePackets.insert (pos, framePacket);
+        ++m_streams[stream].packets;
+        m_streams[stream].bytes += bytesToSend;
+        release += Seconds (codec->second);
+    } while (release + MicroSeconds (1) < frameEnd);
+
+    NS_LOG_INFO ("RmcatSender::EnqueueFrame, stream " << stream
+                 << ", packets enqueued: " << m_framePackets.size ()
+                 << ", buffer size: " << m_pacer.GetSize ()
+                 << ", buffer bytes: " << m_pacer.GetBytes ());
+
+    ScheduleEnqueue (stream, release - now);
+
+    if (!m_departurePlanned) {
+        // Send timer was idle, or waiting for a later release than the
+        // ones just enqueued
+        Simulator::Cancel (m_sendEvent);
+        RunSendTimer ();
+    }
+}
+
+void RmcatSender::RunSendTimer ()
+{
+    const auto now = Simulator::Now ();
+    auto base = now; // time the next departure is planned from
+    while (true) {
+        if (m_departurePlanned) {
+            if (m_nextWireTime > now) {
+                ++m_scheduledEvents;
+                m_sendEvent = Simulator::Schedule (m_nextWireTime - now,
+                                                   &RmcatSender::RunSendTimer, this);
+                return;
+            }
+            SendPlannedPacket ();
+            base = m_nextDeparture;
+        }
+
+        ReleaseFramePackets (base);
+        if (m_pacer.IsEmpty ()) {
+            if (m_framePackets.empty ()) {
+                // Idle until the next frame
+                return;
+            }
+            const auto release = m_framePackets.front ().first;
+            if (release > now) {
+                ++m_scheduledEvents;
+                m_sendEvent = Simulator::Schedule (release - now,
+                                                   &RmcatSender::RunSendTimer, this);
+                return;
+            }
+            base = release;
+            ReleaseFramePackets (base);
+        }
+
+        // As SendPacket would schedule it, including the oversleep
+        const auto tNextSend = USE_BUFFER ? m_pacer.GetTimeToNextSend (base) : Time{0};
+        Time tOver{NanoSeconds (tNextSend.GetNanoSeconds () * (rand () % 100) / 10000)};
+        m_nextDeparture = base + tNextSend;
+        m_nextWireTime = m_nextDeparture + tOver;
+        m_departurePlanned = true;
+    }
+}
+
+void RmcatSender::ReleaseFramePackets (Time until)
+{
+    while (!m_framePackets.empty () && m_framePackets.front ().first <= until) {
+        m_pacer.Enqueue (m_framePackets.front ().second);
+        m_framePackets.pop_front ();
+    }
+}
 
-    ns3::MediaHeader header;
-    header.flow_id = m_flowId;
-    header.sequence = seq;
-    header.packet_size = bytesToSend;
-    const auto now = Simulator::Now ().GetMilliSeconds ();
-    header.send_tstmp = now;
+void RmcatSender::SendPlannedPacket ()
+{
+    NS_ASSERT (m_departurePlanned);
+    NS_ASSERT (!m_pacer.IsEmpty ());
+    NS_ASSERT (m_pacer.GetBytes () < MAX_QUEUE_SIZE_SANITY);
 
-    auto packet = Create<Packet> (bytesToSend);
-    packet->AddHeader (header);
+    const auto bytesToSend = m_pacer.Dequeue (m_nextDeparture);
+    NS_ASSERT (bytesToSend > 0);
+    NS_ASSERT (bytesToSend <= DEFAULT_PACKET_SIZE);
+    m_departurePlanned = false;
+
+    // The controller sees the planned departure, the wire the actual one
+    const auto departure = m_nextDeparture.GetMicroSeconds ();
+    const auto wireBytes = bytesToSend + m_pacer.GetPacketOverhead ();
+    m_traceRecorder.onSend (departure, m_sequence, wireBytes);
+    m_controller->processSendPacket (departure, m_sequence, wireBytes);
+    ++m_sentPackets;
+    SendOverSleep (m_sequence++, bytesToSend);
+}
+
+void RmcatSender::ClearBuffers ()
+{
+    m_pacer.Clear (Simulator::Now ());
+    m_framePackets.clear ();
+    m_departurePlanned = false;
+}
+
+void RmcatSender::SendOverSleep (uint32_t seq, uint32_t bytesToSend) {
+
+    const auto now = Simulator::Now ().GetMicroSeconds ();
+    auto packet = m_packetPool.Get (bytesToSend);
+    if (m_rtpHeader) {
+        // The media clock follows the sending time: the codecs do not
+        // expose capture times
+        ns3::RtpHeader header;
+        header.payload_type = RTP_VIDEO_PAYLOAD_TYPE;
+        header.sequence = static_cast<uint16_t> (seq);
+        header.timestamp = static_cast<uint32_t> (now * RTP_VIDEO_CLOCK_RATE / 1000000);
+        header.ssrc = m_flowId;
+        header.transport_sequence = static_cast<uint16_t> (seq);
+        header.abs_send_time = RtpHeader::ToAbsSendTime (now);
+        packet->AddHeader (header);
+    } else {
+        ns3::MediaHeader header;
+        header.flow_id = m_flowId;
+        header.sequence = seq;
+        header.packet_size = bytesToSend;
+        header.send_tstmp = now;
+        packet->AddHeader (header);
+    }
 
     NS_LOG_INFO ("RmcatSender::SendOverSleep, " << packet->ToString ());
     m_socket->SendTo (packet, 0, InetSocketAddress{m_destIP, m_destPort});
@@ -350,43 +641,85 @@ void RmcatSender::RecvPacket (Ptr<Socket> socket)
     Packet->RemoveHeader (header);
     NS_ASSERT (header.flow_id == m_flowId);
 
-    const auto now = Simulator::Now ().GetMilliSeconds ();
-    NS_ASSERT (header.receive_tstmp <= now);
+    const auto now = Simulator::Now ().GetMicroSeconds ();
 
-    m_controller->processFeedback (now,
-                                   header.sequence,
-                                   header.receive_tstmp);
+    // The whole report is handed to the controller at once
+    m_feedbackBatch.clear ();
+    for (const auto& entry : header.GetFeedback ()) {
+        const auto sequence = UnwrapSequence (entry.sequence);
+        m_traceRecorder.onFeedback (now, sequence, entry.receive_tstmp, entry.ecn);
+        m_feedbackBatch.push_back ({sequence, entry.receive_tstmp, entry.ecn});
+    }
+    m_controller->processFeedbackBatch (now,
+                                        m_feedbackBatch.data (),
+                                        m_feedbackBatch.size ());
     CalcBufferParams (now);
 }
 
+/*
+ * With RTP headers, only the lower 16 bits of the sequence make it to the
+ * receiver. The sequence meant is the latest one sent with those bits
+ */
+uint32_t RmcatSender::UnwrapSequence (uint32_t sequence) const
+{
+    if (!m_rtpHeader) {
+        return sequence;
+    }
+    const auto lastSent = m_sequence - 1;
+    return lastSent - static_cast<uint16_t> (lastSent - sequence);
+}
+
 void RmcatSender::CalcBufferParams (uint64_t now)
 {
     //Calculate rate shaping buffer parameters
-    const auto r_ref = m_controller->getBandwidth (now); // in bps
+    auto r_ref = m_controller->getBandwidth (now); // in bps
+    if (m_fseRegistered) {
+        // Share of the coupled flows' aggregate rate. The controller keeps
+        // the rate it was last assigned until it calculates a new one
+        const auto assigned = m_fse->getRate (m_fseFlowId);
+        r_ref = (r_ref != assigned) ? m_fse->updateRate (m_fseFlowId, r_ref) : assigned;
+    }
+    auto bufferPkts = m_pacer.GetSize ();
+    auto bufferBytes = m_pacer.GetBytes ();
+    // In burst mode, packets released by the codec may not have entered
+    // the pacer yet
+    for (const auto& framePacket : m_framePackets) {
+        if (framePacket.first > Simulator::Now ()) {
+            break;
+        }
+        ++bufferPkts;
+        bufferBytes += framePacket.second;
+    }
     float bufferLen;
     //Purpose: smooth out timing issues between send and receive
     // feedback for the common case: buffer oscillating between 0 and 1 packets
-    if (m_rateShapingBuf.size () > 1) {
-        bufferLen = static_cast<float> (m_rateShapingBytes);
+    if (bufferPkts > 1) {
+        bufferLen = static_cast<float> (bufferBytes);
     } else {
         bufferLen = 0;
     }
 
-    syncodecs::Codec& codec = *m_codec;
+    // The primary stream's frame rate drives the buffer adjustment
+    syncodecs::Codec& codec = *m_streams[0].codec;
+
+    // The codec's target only covers media payload: leave room for the
+    // per-packet overhead, assuming full-size packets, before enforcing Rmin
+    const auto overhead = m_pacer.GetPacketOverhead ();
+    const float payloadShare = static_cast<float> (DEFAULT_PACKET_SIZE) / (DEFAULT_PACKET_SIZE + overhead);
 
-    // TODO (deferred):  encapsulate rate shaping buffer in a separate class
     if (USE_BUFFER && static_cast<bool> (codec)) {
         const float fps = 1. / static_cast<float>  (codec->second);
-        m_rVin = std::max<float> (m_minBw, r_ref - BETA_V * 8. * bufferLen * fps);
-        m_rSend = r_ref + BETA_S * 8. * bufferLen * fps;
+        m_rVin = std::max<float> (m_minBw, payloadShare * (r_ref - BETA_V * 8. * bufferLen * fps));
+        const double rSend = r_ref + BETA_S * 8. * bufferLen * fps;
+        m_pacer.SetRate (rSend, Simulator::Now ());
         NS_LOG_INFO ("New rate shaping buffer parameters: r_ref " << r_ref
                      << ", m_rVin " << m_rVin
-                     << ", m_rSend " << m_rSend
+                     << ", rSend " << rSend
                      << ", fps " << fps
                      << ", buffer length " << bufferLen);
     } else {
-        m_rVin = r_ref;
-        m_rSend = r_ref;
+        m_rVin = std::max<float> (m_minBw, payloadShare * r_ref);
+        m_pacer.SetRate (r_ref, Simulator::Now ());
     }
 }
 
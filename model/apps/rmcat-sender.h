@@ -29,11 +29,18 @@
 #define RMCAT_SENDER_H
 
 #include "rmcat-constants.h"
+#include "rmcat-pacer.h"
+#include "rmcat-packet-pool.h"
 #include "ns3/syncodecs.h"
 #include "ns3/sender-based-controller.h"
+#include "ns3/flow-state-exchange.h"
+#include "ns3/packet-trace.h"
 #include "ns3/socket.h"
 #include "ns3/application.h"
 #include <memory>
+#include <deque>
+#include <vector>
+#include <utility>
 
 namespace ns3 {
 
@@ -49,7 +56,22 @@ public:
     void SetCodec (std::shared_ptr<syncodecs::Codec> codec);
     void SetCodecType (SyncodecType codecType);
 
+    /**
+     * Add a media stream (e.g., audio or screen sharing) to the one set
+     * with #SetCodec or #SetCodecType. All the streams share the rate
+     * shaping buffer, the sequence space and the congestion controller;
+     * the controller's rate is split among them in proportion to their
+     * priority weights (as in the coupled congestion control framework,
+     * RFC 8699). The first stream has weight 1. Must be called before the
+     * application starts
+     *
+     * @param [in] codec Codec producing the stream's packets
+     * @param [in] weight Priority weight of the stream; must be positive
+     */
+    void AddStream (std::shared_ptr<syncodecs::Codec> codec, double weight);
+
     void SetController (std::shared_ptr<rmcat::SenderBasedController> controller);
+    std::shared_ptr<rmcat::SenderBasedController> GetController () const;
 
     void SetRinit (float Rinit);
     void SetRmin (float Rmin);
@@ -57,19 +79,109 @@ public:
 
     void Setup (Ipv4Address dest_ip, uint16_t dest_port);
 
+    /**
+     * Record the packets sent and the feedback received, as seen by the
+     * controller, to a binary trace file that can be replayed offline
+     * (see packet-trace.h). The file is closed when the application stops
+     */
+    void EnablePacketTrace (const std::string& filename);
+
+    /**
+     * Let up to the given number of bytes leave the rate shaping buffer
+     * back to back after an idle period, rather than strictly paced at the
+     * sending rate (default: 0)
+     */
+    void SetPacingBurst (uint32_t bytes);
+
+    /**
+     * Pull a whole frame interval's worth of packets from the codec at
+     * once, and plan their departures up front (default: off). A single
+     * timer then sends each packet, oversleep included, and only wakes up
+     * at the next departure or packet release, instead of scheduling
+     * separate enqueue, send and oversleep events for every packet.
+     * Must be called before the application starts
+     */
+    void SetBurstMode (bool enable);
+
+    /** Number of media packets sent so far */
+    uint64_t GetSentPackets () const;
+
+    /**
+     * Number of simulator events scheduled so far to produce and send the
+     * media packets, oversleep included (see #SetBurstMode )
+     */
+    uint64_t GetScheduledEvents () const;
+
+    /** Pool the media packets sent are taken from */
+    const RmcatPacketPool& GetPacketPool () const;
+
+    /**
+     * Send media packets with an RTP header (see #RtpHeader ) rather than
+     * a #MediaHeader (default: off). The receiver must be configured
+     * likewise (see #RmcatReceiver::SetRtpHeader ). Either header's bytes
+     * count towards the sending rate and the sizes the controller sees;
+     * the codec's target rate is lowered accordingly
+     */
+    void SetRtpHeader (bool enable);
+
+    /**
+     * Send media packets as ECN-capable, with the ECT(0) codepoint
+     * (default: off). Congestion marks are reported back by the receiver
+     * and fed to the controller. Must be called before the application
+     * starts
+     */
+    void SetEcn (bool enable);
+
+    /**
+     * Couple this flow's controller with those of other flows known to
+     * share its bottleneck (see #rmcat::FlowStateExchange ). The flow is
+     * registered while the application runs and is not paused. Must be
+     * called before the application starts
+     *
+     * @param [in] fse Flow state exchange shared by the coupled flows
+     * @param [in] priority Priority of this flow; must be positive
+     */
+    void SetFlowStateExchange (std::shared_ptr<rmcat::FlowStateExchange> fse,
+                               float priority);
+
 private:
     virtual void StartApplication ();
     virtual void StopApplication ();
 
-    void EnqueuePacket ();
-    void SendPacket (uint64_t msSlept);
+    void EnqueuePacket (size_t stream);
+    void ScheduleEnqueue (size_t stream, Time delay);
+    double GetStreamRate (size_t stream) const;
+    void SendPacket (Time slept);
     void SendOverSleep (uint32_t seq, uint32_t bytesToSend);
     void RecvPacket (Ptr<Socket> socket);
     void CalcBufferParams (uint64_t now);
+    void RegisterFlow ();
+    void DeregisterFlow ();
+    uint32_t UnwrapSequence (uint32_t sequence) const;
+
+    // Burst mode
+    void EnqueueFrame (size_t stream);
+    void RunSendTimer ();
+    void ReleaseFramePackets (Time until);
+    void SendPlannedPacket ();
+    void ClearBuffers ();
 
 private:
-    std::shared_ptr<syncodecs::Codec> m_codec;
+    struct MediaStream {
+        std::shared_ptr<syncodecs::Codec> codec;
+        double weight;
+        EventId enqueueEvent;
+        uint64_t packets; // produced so far
+        uint64_t bytes;
+    };
+
+    std::vector<MediaStream> m_streams; // the first one is set with SetCodec
+    double m_totalWeight;
     std::shared_ptr<rmcat::SenderBasedController> m_controller;
+    std::shared_ptr<rmcat::FlowStateExchange> m_fse;
+    float m_fsePriority;
+    uint32_t m_fseFlowId;
+    bool m_fseRegistered;
     Ipv4Address m_destIP;
     uint16_t m_destPort;
     float m_initBw;
@@ -79,15 +191,27 @@ private:
     uint32_t m_flowId;
     uint32_t m_sequence;
     Ptr<Socket> m_socket;
-    EventId m_enqueueEvent;
     EventId m_sendEvent;
     EventId m_sendOversleepEvent;
 
     double m_rVin; //bps
-    double m_rSend; //bps
-    std::deque<uint32_t> m_rateShapingBuf;
-    uint32_t m_rateShapingBytes;
-    uint64_t m_nextSendTstmp;
+    RmcatPacer m_pacer; // rate shaping buffer, sending at rSend
+
+    bool m_burstMode;
+    bool m_rtpHeader;
+    bool m_ecn;
+    // packets of the current frame not yet released: (release time, bytes)
+    std::deque<std::pair<Time, uint32_t> > m_framePackets;
+    bool m_departurePlanned; // of the packet at the head of m_pacer
+    Time m_nextDeparture;    // as seen by the controller
+    Time m_nextWireTime;     // m_nextDeparture plus oversleep
+    uint64_t m_sentPackets;
+    uint64_t m_scheduledEvents; // by the enqueue and send paths
+
+    rmcat::PacketTraceRecorder m_traceRecorder;
+    RmcatPacketPool m_packetPool;
+    // feedback report being processed; kept to reuse its storage
+    std::vector<rmcat::SenderBasedController::FeedbackEntry> m_feedbackBatch;
 };
 
 }
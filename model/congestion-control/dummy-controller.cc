@@ -25,7 +25,6 @@
  * @author Xiaoqing Zhu
  */
 #include "dummy-controller.h"
-#include <sstream>
 #include <cassert>
 
 namespace rmcat {
@@ -64,10 +63,25 @@ bool DummyController::processFeedback(uint64_t now,
     // First of all, call the superclass
     const bool res = SenderBasedController::processFeedback(now, sequence,
                                                             rxTimestamp, ecn);
-    const uint64_t calcIntervalMs = 200;
+    onFeedback(now);
+    return res;
+}
+
+bool DummyController::processFeedbackBatch(uint64_t now,
+                                           const FeedbackEntry* entries,
+                                           size_t n) {
+    // First of all, call the superclass
+    const bool res = SenderBasedController::processFeedbackBatch(now, entries,
+                                                                 n);
+    onFeedback(now);
+    return res;
+}
+
+void DummyController::onFeedback(uint64_t now) {
+    const uint64_t calcInterval = 200 * RMCAT_US_PER_MS;
     if (m_lastTimeCalcValid) {
         assert(lessThan(m_lastTimeCalc, now + 1));
-        if (now - m_lastTimeCalc >= calcIntervalMs) {
+        if (now - m_lastTimeCalc >= calcInterval) {
             updateMetrics(now);
             logStats(now);
             m_lastTimeCalc = now;
@@ -76,7 +90,6 @@ bool DummyController::processFeedback(uint64_t now,
         m_lastTimeCalc = now;
         m_lastTimeCalcValid = true;
     }
-    return res;
 }
 
 float DummyController::getBandwidth(uint64_t now) const {
@@ -104,19 +117,22 @@ void DummyController::updateMetrics(uint64_t now) {
 
 void DummyController::logStats(uint64_t now) const {
 
-    std::ostringstream os;
-    os << std::fixed;
-    os.precision(RMCAT_LOG_PRINT_PRECISION);
-
-    os  << " algo:dummy " << m_id
-        << " ts: "     << now
-        << " loglen: " << m_packetHistory.size()
-        << " qdel: "   << m_Qdelay
-        << " ploss: "  << m_ploss
-        << " plr: "    << m_plr
-        << " rrate: "  << m_RecvR
-        << " srate: "  << m_initBw;
-    logMessage(os.str());
+    StatsRecord record;
+    record.algo = "dummy";
+    record.id = m_id.c_str();
+    record.fields = 0;
+    record.ts = now;
+    record.loglen = m_packetHistory.size();
+    record.qdel = m_Qdelay;
+    record.rtt = 0;
+    record.ploss = m_ploss;
+    record.plr = m_plr;
+    record.xcurr = 0.f;
+    record.rrate = m_RecvR;
+    record.srate = m_initBw;
+    record.avgint = 0.f;
+    record.curint = 0;
+    reportStats(record);
 }
 
 }
@@ -66,6 +66,15 @@ public:
                                  uint32_t sequence,
                                  uint64_t rxTimestamp,
                                  uint8_t ecn=0);
+
+    /**
+     * Batched counterpart of #processFeedback : metrics are printed at most
+     * once per batch
+     */
+    virtual bool processFeedbackBatch(uint64_t now,
+                                      const FeedbackEntry* entries,
+                                      size_t n);
+
     /**
      * Simplistic implementation of bandwidth getter. It returns a hard-coded
      * bandwidth value in bits per second
@@ -73,13 +82,14 @@ public:
     virtual float getBandwidth(uint64_t now) const;
 
 private:
+    void onFeedback(uint64_t now);
     void updateMetrics(uint64_t now);
     void logStats(uint64_t now) const;
 
     uint64_t m_lastTimeCalc;
     bool m_lastTimeCalcValid;
 
-    uint64_t m_Qdelay; /* estimated queuing delay in ms */
+    uint64_t m_Qdelay; /* estimated queuing delay in us */
     uint32_t m_ploss; /**< packet loss count within configured window */
     float m_plr;     /* packet loss ratio within packet history window */
     float m_RecvR;  /* updated receiving rate in bps */
@@ -0,0 +1,158 @@
+/******************************************************************************
+ * Copyright 2016-2017 Cisco Systems, Inc.                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ *                                                                            *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+/**
+ * @file
+ * Flow state exchange implementation.
+ *
+ * @version 0.1.0
+ * @author Jiantao Fu
+ * @author Sergio Mena
+ * @author Xiaoqing Zhu
+ */
+#include "flow-state-exchange.h"
+#include <algorithm>
+#include <cassert>
+
+namespace rmcat {
+
+FlowStateExchange::FlowStateExchange()
+: m_flows{},
+  m_capped{},
+  m_sumRates{0.f},
+  m_nextId{0} {}
+
+uint32_t FlowStateExchange::registerFlow(std::shared_ptr<SenderBasedController> controller,
+                                         float priority,
+                                         float minRate,
+                                         float maxRate,
+                                         float initRate) {
+    assert(controller);
+    assert(priority > 0.f);
+    assert(minRate <= maxRate);
+    Flow flow;
+    flow.id = m_nextId++;
+    flow.controller = controller;
+    flow.priority = priority;
+    flow.minRate = minRate;
+    flow.maxRate = maxRate;
+    flow.rate = initRate;
+    m_flows.push_back(flow);
+    m_sumRates += initRate;
+    allocate();
+    return flow.id;
+}
+
+void FlowStateExchange::deregisterFlow(uint32_t id) {
+    auto it = findFlow(id);
+    assert(it != m_flows.end());
+    m_sumRates = std::max(0.f, m_sumRates - it->rate);
+    m_flows.erase(it);
+    allocate();
+}
+
+float FlowStateExchange::updateRate(uint32_t id, float calculatedRate) {
+    auto it = findFlow(id);
+    assert(it != m_flows.end());
+    // The controller started off the rate it was last assigned
+    m_sumRates = std::max(0.f, m_sumRates + calculatedRate - it->rate);
+    allocate();
+    return getRate(id);
+}
+
+float FlowStateExchange::getRate(uint32_t id) const {
+    auto it = findFlow(id);
+    assert(it != m_flows.end());
+    return it->rate;
+}
+
+float FlowStateExchange::getAggregateRate() const {
+    return m_sumRates;
+}
+
+size_t FlowStateExchange::getNumFlows() const {
+    return m_flows.size();
+}
+
+std::vector<FlowStateExchange::Flow>::iterator FlowStateExchange::findFlow(uint32_t id) {
+    return std::find_if(m_flows.begin(), m_flows.end(),
+                        [id](const Flow& flow) { return flow.id == id; });
+}
+
+std::vector<FlowStateExchange::Flow>::const_iterator FlowStateExchange::findFlow(uint32_t id) const {
+    return std::find_if(m_flows.begin(), m_flows.end(),
+                        [id](const Flow& flow) { return flow.id == id; });
+}
+
+/**
+ * Split the aggregate among the flows. Each flow first gets its minimum
+ * rate; what is left is split in proportion to the priorities. Flows whose
+ * share takes them above their maximum rate get their maximum, and the
+ * rest is split again among the others, until no share needs capping
+ */
+void FlowStateExchange::allocate() {
+    // The aggregate can neither go below what the flows are guaranteed nor
+    // grow beyond what they can take
+    float sumMinRates = 0.f;
+    float sumMaxRates = 0.f;
+    for (const auto& flow : m_flows) {
+        sumMinRates += flow.minRate;
+        sumMaxRates += flow.maxRate;
+    }
+    m_sumRates = std::max(sumMinRates, std::min(m_sumRates, sumMaxRates));
+
+    m_capped.assign(m_flows.size(), false);
+    float remaining = m_sumRates - sumMinRates;
+    bool done = false;
+    while (!done) {
+        float sumPriorities = 0.f;
+        for (size_t i = 0; i < m_flows.size(); ++i) {
+            if (!m_capped[i]) {
+                sumPriorities += m_flows[i].priority;
+            }
+        }
+        if (sumPriorities <= 0.f) {
+            break; // all capped
+        }
+        done = true;
+        for (size_t i = 0; i < m_flows.size(); ++i) {
+            if (m_capped[i]) {
+                continue;
+            }
+            Flow& flow = m_flows[i];
+            const float share = remaining * flow.priority / sumPriorities;
+            const float headroom = flow.maxRate - flow.minRate;
+            if (share > headroom) {
+                flow.rate = flow.maxRate;
+                remaining -= headroom;
+                m_capped[i] = true;
+                done = false;
+            } else {
+                flow.rate = flow.minRate + share;
+            }
+        }
+    }
+
+    for (auto& flow : m_flows) {
+        auto controller = flow.controller.lock();
+        if (controller) {
+            controller->setCurrentBw(flow.rate);
+        }
+    }
+}
+
+}
@@ -0,0 +1,127 @@
+/******************************************************************************
+ * Copyright 2016-2017 Cisco Systems, Inc.                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ *                                                                            *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+/**
+ * @file
+ * Flow state exchange interface: coupled congestion control of the flows
+ * sharing a bottleneck.
+ *
+ * @version 0.1.0
+ * @author Jiantao Fu
+ * @author Sergio Mena
+ * @author Xiaoqing Zhu
+ */
+
+#ifndef FLOW_STATE_EXCHANGE_H
+#define FLOW_STATE_EXCHANGE_H
+
+#include "sender-based-controller.h"
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace rmcat {
+
+/**
+ * Flow state exchange (FSE) of the coupled congestion control framework
+ * (RFC 8699, active algorithm). The flows registered with one FSE are
+ * known to share a bottleneck; each keeps its own controller and feedback
+ * processing, but the sum of their calculated rates is split among them
+ * in proportion to their priorities.
+ *
+ * Whenever the controller of a flow calculates a new rate, the flow calls
+ * #updateRate: the change with respect to the rate it was last assigned
+ * is applied to the aggregate, which is then reallocated. Every flow is
+ * first assigned its minimum rate, and the rest of the aggregate is split.
+ * Flows whose share exceeds their maximum rate are capped, and the
+ * leftover goes to the others. Every registered controller is told its
+ * new rate through #SenderBasedController::setCurrentBw , so any
+ * controller can be coupled
+ */
+class FlowStateExchange {
+public:
+    /** Class constructor: no flows registered */
+    FlowStateExchange();
+
+    /**
+     * Register a flow. Its initial rate is added to the aggregate, and the
+     * aggregate is reallocated
+     *
+     * @param [in] controller Controller of the flow; the FSE does not keep
+     *                        it alive
+     * @param [in] priority Priority of the flow; must be positive
+     * @param [in] minRate Rate the flow is never assigned less than, in bps
+     * @param [in] maxRate Rate the flow is never assigned more than, in bps
+     * @param [in] initRate Current rate of the flow's controller, in bps
+     * @retval Id of the flow in this FSE
+     */
+    uint32_t registerFlow(std::shared_ptr<SenderBasedController> controller,
+                          float priority,
+                          float minRate,
+                          float maxRate,
+                          float initRate);
+
+    /**
+     * Remove a flow (e.g., when it stops or pauses). Its assigned rate is
+     * removed from the aggregate, and the aggregate is reallocated
+     *
+     * @param [in] id Id returned by #registerFlow
+     */
+    void deregisterFlow(uint32_t id);
+
+    /**
+     * Account for a new rate calculated by a flow's controller
+     *
+     * @param [in] id Id returned by #registerFlow
+     * @param [in] calculatedRate Rate the controller calculated, in bps
+     * @retval Rate assigned to the flow, in bps
+     */
+    float updateRate(uint32_t id, float calculatedRate);
+
+    /** Rate currently assigned to a flow, in bps */
+    float getRate(uint32_t id) const;
+
+    /** Sum of the calculated rates of all flows, in bps */
+    float getAggregateRate() const;
+
+    /** Number of registered flows */
+    size_t getNumFlows() const;
+
+private:
+    struct Flow {
+        uint32_t id;
+        std::weak_ptr<SenderBasedController> controller;
+        float priority;
+        float minRate;
+        float maxRate;
+        float rate; /**< rate assigned (FSE_R in RFC 8699), in bps */
+    };
+
+    std::vector<Flow>::iterator findFlow(uint32_t id);
+    std::vector<Flow>::const_iterator findFlow(uint32_t id) const;
+    void allocate();
+
+    std::vector<Flow> m_flows;
+    std::vector<bool> m_capped; /**< scratch of #allocate , one per flow */
+    float m_sumRates; /**< sum of calculated rates (S_CR in RFC 8699) */
+    uint32_t m_nextId;
+};
+
+}
+
+#endif /* FLOW_STATE_EXCHANGE_H */
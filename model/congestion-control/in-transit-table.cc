@@ -0,0 +1,71 @@
+/******************************************************************************
+ * Copyright 2016-2017 Cisco Systems, Inc.                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ *                                                                            *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+/**
+ * @file
+ * Table of in-transit packets implementation.
+ *
+ * @version 0.1.0
+ * @author Jiantao Fu
+ * @author Sergio Mena
+ * @author Xiaoqing Zhu
+ */
+#include "in-transit-table.h"
+
+namespace rmcat {
+
+const size_t IN_TRANSIT_TABLE_MIN_CAPACITY = 16; /**< initial capacity, in sequences */
+
+InTransitTable::InTransitTable()
+: m_slots{},
+  m_first{0},
+  m_count{0},
+  m_mask{0} {
+    resize(IN_TRANSIT_TABLE_MIN_CAPACITY);
+}
+
+void InTransitTable::reserve(size_t n) {
+    size_t newCapacity = capacity();
+    while (newCapacity < n) {
+        newCapacity <<= 1;
+    }
+    if (newCapacity != capacity()) {
+        resize(newCapacity);
+    }
+}
+
+void InTransitTable::grow() {
+    resize(capacity() << 1);
+}
+
+void InTransitTable::resize(size_t newCapacity) {
+    // Power of two
+    assert(newCapacity > 0 && (newCapacity & (newCapacity - 1)) == 0);
+    assert(newCapacity >= m_count);
+
+    std::vector<Slot> slots(newCapacity);
+    const size_t newMask = newCapacity - 1;
+    // Slots are remapped with the new mask
+    for (size_t i = 0; i < m_count; ++i) {
+        const uint32_t sequence = uint32_t(m_first + i);
+        slots[sequence & newMask] = m_slots[sequence & m_mask];
+    }
+    m_slots.swap(slots);
+    m_mask = newMask;
+}
+
+}
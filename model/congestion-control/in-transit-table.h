@@ -0,0 +1,170 @@
+/******************************************************************************
+ * Copyright 2016-2017 Cisco Systems, Inc.                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ *                                                                            *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+/**
+ * @file
+ * Table of in-transit packets, indexed by sequence number, used by
+ * sender-based controllers.
+ *
+ * @version 0.1.0
+ * @author Jiantao Fu
+ * @author Sergio Mena
+ * @author Xiaoqing Zhu
+ */
+
+#ifndef IN_TRANSIT_TABLE_H
+#define IN_TRANSIT_TABLE_H
+
+#include "packet-ring.h"
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <cassert>
+
+namespace rmcat {
+
+/**
+ * Packets sent and not yet moved to the packet history, covering a range
+ * of consecutive sequence numbers. The record of sequence s lives in slot
+ * (s & mask) of a direct-mapped table whose capacity is a power of two, so
+ * feedback about any packet in the range is matched in O(1), whatever
+ * order it arrives in. Should the range ever become larger than the
+ * table, the capacity is doubled.
+ *
+ * Each packet is either still in transit, or acknowledged (feedback has
+ * arrived, with the one way delay and round trip time filled in) and
+ * waiting for the packets before it to be settled.
+ */
+class InTransitTable {
+public:
+    /** Class constructor: the table is empty, with a small initial capacity */
+    InTransitTable();
+
+    /**
+     * Make sure the table can cover a range of at least n sequences without
+     * growing. The capacity is rounded up to a power of two; it never
+     * shrinks. Records currently stored are preserved
+     *
+     * @param [in] n Minimum number of sequences the table should cover
+     */
+    void reserve(size_t n);
+
+    /** Number of sequences the table can cover before growing */
+    size_t capacity() const { return m_mask + 1; }
+
+    /** Number of sequences in the range covered */
+    size_t size() const { return m_count; }
+
+    /** Whether the table covers no sequences */
+    bool empty() const { return m_count == 0; }
+
+    /** Remove all records. Capacity is kept */
+    void clear() { m_count = 0; }
+
+    /** Oldest sequence in the range; the table must not be empty */
+    uint32_t firstSequence() const {
+        assert(m_count > 0);
+        return m_first;
+    }
+
+    /**
+     * Whether a sequence is in the range covered. This comparison supports
+     * wrapping, like #SenderBasedController::lessThan
+     */
+    bool contains(uint32_t sequence) const {
+        return uint32_t(sequence - m_first) < m_count;
+    }
+
+    /**
+     * Append the record of a newly sent packet, in transit; its sequence
+     * must follow the newest one in the table, if any
+     */
+    void push_back(const PacketRecord& record) {
+        if (m_count == 0) {
+            m_first = record.sequence;
+        }
+        assert(record.sequence == uint32_t(m_first + m_count));
+        if (m_count == capacity()) {
+            grow();
+        }
+        Slot& slot = m_slots[record.sequence & m_mask];
+        slot.record = record;
+        slot.acked = false;
+        ++m_count;
+    }
+
+    /** Remove the oldest sequence from the range */
+    void pop_front() {
+        assert(m_count > 0);
+        ++m_first;
+        --m_count;
+    }
+
+    /** Record of a sequence in the range */
+    const PacketRecord& record(uint32_t sequence) const {
+        assert(contains(sequence));
+        return m_slots[sequence & m_mask].record;
+    }
+
+    /** Whether feedback about a sequence in the range has arrived */
+    bool isAcked(uint32_t sequence) const {
+        assert(contains(sequence));
+        return m_slots[sequence & m_mask].acked;
+    }
+
+    /**
+     * Store the feedback about a packet still in transit
+     *
+     * @param [in] sequence Sequence of the packet, in the range
+     * @param [in] owd One way delay of the packet
+     * @param [in] rtt Round trip time of the packet
+     * @param [in] ecn ECN codepoint seen by the receiver
+     */
+    void ack(uint32_t sequence, uint64_t owd, uint64_t rtt, uint8_t ecn) {
+        assert(contains(sequence));
+        Slot& slot = m_slots[sequence & m_mask];
+        assert(!slot.acked);
+        slot.record.owd = owd;
+        slot.record.rtt = rtt;
+        slot.record.ecn = ecn;
+        slot.acked = true;
+    }
+
+    /** Record of the oldest sequence */
+    const PacketRecord& front() const { return record(m_first); }
+
+    /** Whether feedback about the oldest sequence has arrived */
+    bool frontAcked() const { return isAcked(m_first); }
+
+private:
+    struct Slot {
+        PacketRecord record;
+        bool acked;
+    };
+
+    void grow();
+    void resize(size_t newCapacity);
+
+    std::vector<Slot> m_slots;
+    uint32_t m_first; /**< oldest sequence in the range */
+    size_t m_count;   /**< number of sequences in the range */
+    size_t m_mask;    /**< capacity - 1; capacity is a power of two */
+};
+
+}
+
+#endif /* IN_TRANSIT_TABLE_H */
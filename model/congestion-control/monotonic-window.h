@@ -0,0 +1,158 @@
+/******************************************************************************
+ * Copyright 2016-2017 Cisco Systems, Inc.                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ *                                                                            *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+/**
+ * @file
+ * Sliding window minimum/maximum filter for rmcat ns3 module.
+ *
+ * @version 0.1.0
+ * @author Jiantao Fu
+ * @author Sergio Mena
+ * @author Xiaoqing Zhu
+ */
+
+#ifndef MONOTONIC_WINDOW_H
+#define MONOTONIC_WINDOW_H
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <cassert>
+
+namespace rmcat {
+
+/**
+ * "Less than" comparison of uint64_t values that supports wrapping, see
+ * #SenderBasedController::lessThan
+ */
+struct WrapLess {
+    bool operator()(uint64_t lhs, uint64_t rhs) const {
+        return (rhs - lhs) < (lhs - rhs);
+    }
+};
+
+/** "Greater than" counterpart of #WrapLess */
+struct WrapGreater {
+    bool operator()(uint64_t lhs, uint64_t rhs) const {
+        return WrapLess{}(rhs, lhs);
+    }
+};
+
+/**
+ * Minimum (or maximum) of the samples in a sliding window, maintained
+ * incrementally with a monotonic queue.
+ *
+ * Each sample is pushed along with an index that must increase from one
+ * sample to the next (e.g., a packet counter). The window is moved forward
+ * by expiring all samples with an index lower than a given one. Each sample
+ * is inserted and removed at most once, so both updating and querying the
+ * filter are O(1) (amortized for updates).
+ *
+ * @tparam BETTER Strict ordering; the filter returns the sample that is
+ *                "better" than all others in the window: #WrapLess for a
+ *                minimum filter, #WrapGreater for a maximum filter
+ */
+template <typename BETTER>
+class MonotonicWindow {
+public:
+    /** Class constructor: the window is empty */
+    MonotonicWindow()
+    : m_indices(MIN_CAPACITY),
+      m_values(MIN_CAPACITY),
+      m_head{0},
+      m_count{0},
+      m_mask{MIN_CAPACITY - 1} {}
+
+    /**
+     * Add a new sample to the window
+     *
+     * @param [in] index Index of the sample, greater than that of
+     *                   all previously pushed samples
+     * @param [in] value Value of the sample
+     */
+    void push(uint64_t index, uint64_t value) {
+        assert(m_count == 0 || m_indices[slot(m_count - 1)] < index);
+        // Samples that can no longer be the best one are dropped
+        while (m_count > 0 && !BETTER{}(m_values[slot(m_count - 1)], value)) {
+            --m_count;
+        }
+        if (m_count == m_mask + 1) {
+            grow();
+        }
+        const size_t s = slot(m_count);
+        m_indices[s] = index;
+        m_values[s] = value;
+        ++m_count;
+    }
+
+    /**
+     * Move the window forward
+     *
+     * @param [in] firstIndex Index of the oldest sample still in the window;
+     *                        samples with lower indices are removed
+     */
+    void expire(uint64_t firstIndex) {
+        while (m_count > 0 && m_indices[m_head] < firstIndex) {
+            m_head = (m_head + 1) & m_mask;
+            --m_count;
+        }
+    }
+
+    /** Remove all samples */
+    void clear() {
+        m_head = 0;
+        m_count = 0;
+    }
+
+    /** Whether there are no samples in the window */
+    bool empty() const { return m_count == 0; }
+
+    /** Best (minimum or maximum) sample in the window; must not be empty */
+    uint64_t get() const {
+        assert(m_count > 0);
+        return m_values[m_head];
+    }
+
+private:
+    static const size_t MIN_CAPACITY = 16;
+
+    size_t slot(size_t i) const { return (m_head + i) & m_mask; }
+
+    void grow() {
+        const size_t capacity = m_mask + 1;
+        std::vector<uint64_t> indices(capacity * 2);
+        std::vector<uint64_t> values(capacity * 2);
+        for (size_t i = 0; i < m_count; ++i) {
+            indices[i] = m_indices[slot(i)];
+            values[i] = m_values[slot(i)];
+        }
+        m_indices.swap(indices);
+        m_values.swap(values);
+        m_head = 0;
+        m_mask = capacity * 2 - 1;
+    }
+
+    std::vector<uint64_t> m_indices;
+    std::vector<uint64_t> m_values;
+    size_t m_head;  /**< slot of the oldest sample */
+    size_t m_count; /**< number of samples in the queue */
+    size_t m_mask;  /**< capacity - 1; capacity is a power of two */
+};
+
+}
+
+#endif /* MONOTONIC_WINDOW_H */
@@ -34,8 +34,6 @@
 
 #include "nada-controller.h"
 #include <iostream>
-#include <sstream>
-#include <iomanip>
 #include <cassert>
 #include <cmath>
 
@@ -55,15 +53,15 @@ const float NADA_PARAM_TAU = 500.; /**< Upper bound of RTT (in ms) in gradual ra
 
 /**
  * Target interval for receiving feedback from receiver
- * or update rate calculation (in ms)
+ * or update rate calculation (in us)
  */
-const uint64_t NADA_PARAM_DELTA = 100;
+const uint64_t NADA_PARAM_DELTA = 100 * rmcat::RMCAT_US_PER_MS;
 
 /* default parameters for accelerated ramp-up */
 
 /**  Threshold for allowed queuing dealy build up at receiver during accelerated ramp-up mode */
-const uint64_t NADA_PARAM_QEPS = 10;
-const uint64_t NADA_PARAM_DFILT = 120; /**< Bound on filtering delay (in ms) */
+const uint64_t NADA_PARAM_QEPS = 10 * rmcat::RMCAT_US_PER_MS; /**< in us */
+const uint64_t NADA_PARAM_DFILT = 120 * rmcat::RMCAT_US_PER_MS; /**< Bound on filtering delay (in us) */
 /** Upper bound on rate increase ratio in accelerated ramp-up mode (dimensionless) */
 const float NADA_PARAM_GAMMA_MAX = 0.5;
 /** Upper bound on self-inflicted queuing delay during ramp up (in ms) */
@@ -87,6 +85,12 @@ const float NADA_PARAM_LAMBDA = 0.5; /**< Exponent of the non-linear warpming (d
  */
 const float NADA_PARAM_DLOSS = 10.;
 const float NADA_PARAM_PLRREF = 0.01; /**> Reference packet loss ratio (dimensionless) */
+/**
+ * Reference delay penalty (in ms) in terms of value
+ * of congestion price when packet marking ratio is at PMRREF
+ */
+const float NADA_PARAM_DMARK = 2.;
+const float NADA_PARAM_PMRREF = 0.01; /**> Reference packet marking ratio (dimensionless) */
 const float NADA_PARAM_XMAX = 500.; /**> Maximum value of aggregate congestion signal (in ms) */
 
 /** Smoothing factor in exponential smoothing of packet loss and marking ratios */
@@ -94,10 +98,20 @@ const float NADA_PARAM_ALPHA = 0.1;
 
 namespace rmcat {
 
+/*
+ * Delays are measured in us, whereas the algorithm's
+ * parameters above are expressed in ms as in the draft
+ */
+static float usToMs(uint64_t us) {
+    return float(us) / float(RMCAT_US_PER_MS);
+}
+
 NadaController::NadaController() :
     SenderBasedController{},
     m_ploss{0},
     m_plr{0.f},
+    m_pmark{0},
+    m_pmr{0.f},
     m_warpMode{false},
     m_lastTimeCalc{0},
     m_lastTimeCalcValid{false},
@@ -124,6 +138,8 @@ void NadaController::setCurrentBw(float newBw) {
 void NadaController::reset() {
     m_ploss = 0;
     m_plr = 0.f;
+    m_pmark = 0;
+    m_pmr = 0.f;
     m_warpMode = false;
     m_lastTimeCalc = 0;
     m_lastTimeCalcValid = false;
@@ -141,9 +157,9 @@ void NadaController::reset() {
 
 /**
  * Implementation of the #processFeedback API
- * in the SenderBasedController class
- *
- * TODO: (deferred) Add support for ECN marking
+ * in the SenderBasedController class. ECN marks
+ * are accounted for by the superclass, and taken
+ * into account at the next rate update
  */
 bool NadaController::processFeedback(uint64_t now,
                                      uint32_t sequence,
@@ -154,16 +170,37 @@ bool NadaController::processFeedback(uint64_t now,
                                                             sequence,
                                                             rxTimestamp,
                                                             ecn);
+    onFeedback(now);
+    return res;
+}
+
+/**
+ * Implementation of the #processFeedbackBatch API
+ * in the SenderBasedController class: the whole
+ * batch is ingested before the reference rate is
+ * (possibly) updated, once
+ */
+bool NadaController::processFeedbackBatch(uint64_t now,
+                                          const FeedbackEntry* entries,
+                                          size_t n) {
+    /* First of all, call the superclass */
+    const bool res = SenderBasedController::processFeedbackBatch(now,
+                                                                 entries,
+                                                                 n);
+    onFeedback(now);
+    return res;
+}
 
+void NadaController::onFeedback(uint64_t now) {
     /* Update calculation of reference rate (r_ref)
      * if last calculation occurred more than NADA_PARAM_DELTA
-     * (target update interval in ms) ago
+     * (target update interval in us) ago
      */
     if (!m_lastTimeCalcValid) {
         /* First time receiving a feedback message */
         m_lastTimeCalc = now;
         m_lastTimeCalcValid = true;
-        return res;
+        return;
     }
 
     assert(lessThan(m_lastTimeCalc, now + 1));
@@ -177,7 +214,6 @@ bool NadaController::processFeedback(uint64_t now,
 
         m_lastTimeCalc = now;
     }
-    return res;
 }
 
 /**
@@ -240,6 +276,15 @@ void NadaController::updateMetrics(uint64_t now) {
         m_plr += NADA_PARAM_ALPHA * (plr - m_plr);
     }
 
+    float pmr = 0.f;
+    uint32_t nMarked = 0;
+    bool pmrOK = getPktMarkingInfo(nMarked, pmr);
+    if (pmrOK) {
+        m_pmark = nMarked;
+        // Exponential filtering of marking stats
+        m_pmr += NADA_PARAM_ALPHA * (pmr - m_pmr);
+    }
+
     float avgInt;
     uint32_t currentInt;
     float avgIntOK = getLossIntervalInfo(avgInt, currentInt);
@@ -257,27 +302,27 @@ void NadaController::updateMetrics(uint64_t now) {
 
 void NadaController::logStats(uint64_t now) const {
 
-    std::ostringstream os;
-    os << std::fixed;
-    os.precision(RMCAT_LOG_PRINT_PRECISION);
-
     /* log packet stats: including common stats
      * (e.g., receiving rate, loss, delay) needed
      * by all controllers and algorithm-specific
      * ones (e.g., xcurr for NADA) */
-    os << " algo:nada " << m_id
-       << " ts: "     << now
-       << " loglen: " << m_packetHistory.size()
-       << " qdel: "   << m_Qdelay
-       << " rtt: "    << m_Rtt
-       << " ploss: "  << m_ploss
-       << " plr: "    << m_plr
-       << " xcurr: "  << m_Xcurr
-       << " rrate: "  << m_RecvR
-       << " srate: "  << m_currBw
-       << " avgint: " << m_avgInt
-       << " curint: " << m_currInt;
-    logMessage(os.str());
+    StatsRecord record;
+    record.algo = "nada";
+    record.id = m_id.c_str();
+    record.fields = STATS_FIELD_RTT | STATS_FIELD_XCURR |
+                    STATS_FIELD_LOSS_INTERVAL;
+    record.ts = now;
+    record.loglen = m_packetHistory.size();
+    record.qdel = m_Qdelay;
+    record.rtt = m_Rtt;
+    record.ploss = m_ploss;
+    record.plr = m_plr;
+    record.xcurr = m_Xcurr;
+    record.rrate = m_RecvR;
+    record.srate = m_currBw;
+    record.avgint = m_avgInt;
+    record.curint = m_currInt;
+    reportStats(record);
 }
 
 /**
@@ -293,10 +338,10 @@ void NadaController::logStats(uint64_t now) const {
  *                                    QTH
  */
 float NadaController::calcDtilde() const {
-    const float qDelay = float(m_Qdelay);
+    const float qDelay = usToMs(m_Qdelay);
     float xval = qDelay;
 
-    if (m_Qdelay > NADA_PARAM_QTH) {
+    if (qDelay > NADA_PARAM_QTH) {
         float ratio = (qDelay - NADA_PARAM_QTH) / NADA_PARAM_QTH;
         ratio = NADA_PARAM_LAMBDA * ratio;
         xval = float(NADA_PARAM_QTH * exp(-ratio));
@@ -314,7 +359,7 @@ float NadaController::calcDtilde() const {
  */
 void NadaController::updateXcurr(uint64_t now) {
 
-    float xdel = float(m_Qdelay);           // pure delay-based
+    float xdel = usToMs(m_Qdelay);        // pure delay-based
     float xtilde = calcDtilde();          // warped version
     const float currInt = float(m_currInt);
 
@@ -354,9 +399,11 @@ void NadaController::updateXcurr(uint64_t now) {
         m_warpMode = false;
     }
 
-    /* Add additional loss penalty for the aggregate
-     * congestion signal, following Eq.(2) in Sec.4.2 of
-     * rmcat-nada draft */
+    /* Add additional marking and loss penalties for the
+     * aggregate congestion signal, following Eq.(2) in
+     * Sec.4.2 of rmcat-nada draft */
+    float pmr0 = m_pmr / NADA_PARAM_PMRREF;
+    m_Xcurr += NADA_PARAM_DMARK * pmr0 * pmr0;
     float plr0 = m_plr / NADA_PARAM_PLRREF;
     m_Xcurr += NADA_PARAM_DLOSS * plr0 * plr0;
 
@@ -398,7 +445,7 @@ void NadaController::calcGradualRateUpdate(uint64_t delta) {
     x_offset -= NADA_PARAM_PRIO * NADA_PARAM_XREF * m_maxBw / m_currBw;
 
     r_offset *= NADA_PARAM_KAPPA;
-    r_offset *= float(delta) / NADA_PARAM_TAU;
+    r_offset *= usToMs(delta) / NADA_PARAM_TAU;
     r_offset *= x_offset / NADA_PARAM_TAU;
 
     r_diff *= NADA_PARAM_KAPPA;
@@ -427,7 +474,7 @@ void NadaController::calcAcceleratedRampUp( ) {
     denom += NADA_PARAM_DELTA;
     denom += NADA_PARAM_DFILT;
 
-    gamma = NADA_PARAM_QBOUND / float(denom);
+    gamma = NADA_PARAM_QBOUND / usToMs(denom);
 
     if (gamma > NADA_PARAM_GAMMA_MAX) {
         gamma = NADA_PARAM_GAMMA_MAX;
@@ -449,21 +496,23 @@ void NadaController::calcAcceleratedRampUp( ) {
  *
  * o No build-up of queuing delay: d_fwd-d_base < QEPS for all previous
  *   delay samples within the observation window LOGWIN.
+ *
+ * ECN marks are taken as losses: an AQM marking packets does so before
+ * queuing delay reaches QEPS, and the bottleneck is then not underused.
  */
 int NadaController::getRampUpMode() {
     int rmode = 0;
 
-    /* If losses are observed, stay with gradual update */
-    if (m_ploss > 0) rmode = 1;
+    /* If losses or marks are observed, stay with gradual update */
+    if (m_ploss > 0 || m_pmark > 0) rmode = 1;
 
     /* check all raw queuing delay samples in
-     * packet history log */
-    for (auto rit = m_packetHistory.rbegin();
-              rit != m_packetHistory.rend() && rmode == 0;
-              ++rit) {
-
-        const uint64_t qDelayCurrent = rit->owd - m_baseDelay;
-        if (qDelayCurrent > NADA_PARAM_QEPS ) {
+     * packet history log: it suffices to check
+     * the largest one, which is tracked by the
+     * base class as packets enter/leave the log */
+    uint64_t qDelayMax = 0;
+    if (rmode == 0 && getMaxQdelay(qDelayMax)) {
+        if (qDelayMax > NADA_PARAM_QEPS) {
             rmode = 1;  /* Gradual update if queuing delay exceeds threshold*/
         }
     }
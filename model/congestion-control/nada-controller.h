@@ -70,25 +70,53 @@ public:
                                  uint64_t rxTimestamp,
                                  uint8_t ecn=0);
 
+    /** NADA's implementation of the #processFeedbackBatch API */
+    virtual bool processFeedbackBatch(uint64_t now,
+                                      const FeedbackEntry* entries,
+                                      size_t n);
+
     /** NADA's realization of the #getBandwidth API */
     virtual float getBandwidth(uint64_t now) const;
 
+protected:
+    /**
+     * Function for determining wether the sender should
+     * operate in accelerated ramp-up mode or gradual
+     * update model.
+     *
+     * @retval 0 if the sender should operate in accelerated
+     *         ramp-up mode (rmode == 0 as in draft-rmcat-nada)
+     *         and 1 if the sender should operate in
+     *         gradual update mode (rmode == 1 as in
+     *         draft-rmcat-nada)
+     */
+    int getRampUpMode();
+
 private:
 
+    /**
+     * Function for triggering the periodic update of
+     * the reference rate (and logging of metrics),
+     * once every NADA_PARAM_DELTA, upon feedback
+     *
+     * @param [in] now  current timestamp in us
+     */
+    void onFeedback(uint64_t now);
+
     /**
      * Function for retrieving updated estimates
      * (by the base class SenderBasedController) of
      * delay, loss, and receiving rate metrics and
      * copying them to local member variables
      *
-     * @param [in] now  current timestamp in ms
+     * @param [in] now  current timestamp in us
      */
     void updateMetrics(uint64_t now);
 
     /**
      * Function for printing losss, delay, and rate
      * metrics to log in a pre-formatted manner
-     * @param [in] now  current timestamp in ms
+     * @param [in] now  current timestamp in us
      */
     void logStats(uint64_t now) const;
 
@@ -96,8 +124,8 @@ private:
      * Function for calculating the target bandwidth
      * following the NADA algorithm
      *
-     * @param [in] now   current timestamp in ms
-     * @param [in] delta interval from last bandwidth calculation
+     * @param [in] now   current timestamp in us
+     * @param [in] delta interval from last bandwidth calculation, in us
      */
     void updateBw(uint64_t now, uint64_t delta);
 
@@ -109,7 +137,7 @@ private:
      * See Section 4.3 and Eq.(5)-(7) in the rmcat-nada draft
      * for greater detail.
      *
-     * @param [in] delta interval from last bandwidth calculation
+     * @param [in] delta interval from last bandwidth calculation, in us
      */
     void calcGradualRateUpdate(uint64_t delta);
 
@@ -127,25 +155,12 @@ private:
      */
     void calcAcceleratedRampUp();
 
-    /**
-     * Function for determining wether the sender should
-     * operate in accelerated ramp-up mode or gradual
-     * update model.
-     *
-     * @retval 0 if the sender should operate in accelerated
-     *         ramp-up mode (rmode == 0 as in draft-rmcat-nada)
-     *         and 1 if the sender should operate in
-     *         gradual update mode (rmode == 1 as in
-     *         draft-rmcat-nada)
-     */
-    int getRampUpMode();
-
     /**
      * Function for calculating the aggregated congestion
      * signal (x_curr) based on packet statistics both
      * in terms of loss and delay.
      *
-     * @param [in] now   current timestamp in ms  (t_curr in rmcat-nada)
+     * @param [in] now   current timestamp in us  (t_curr in rmcat-nada)
      */
     void updateXcurr(uint64_t now);
 
@@ -167,17 +182,19 @@ private:
      */
     uint32_t m_ploss; /**< packet loss count within configured window */
     float m_plr;     /**< packet loss ratio within packet history window */
+    uint32_t m_pmark; /**< ECN marked packet count within packet history window */
+    float m_pmr;     /**< packet marking ratio within packet history window */
     bool m_warpMode;  /**< whether to perform non-linear warping of queuing delay */
 
-    /** timestamp of when r_ref is last calculated (t_last in rmcat-nada), in ms  */
+    /** timestamp of when r_ref is last calculated (t_last in rmcat-nada), in us  */
     uint64_t m_lastTimeCalc;
     /** whether value m_lastTimeCalc is valid: not valid before first rate update */
     bool m_lastTimeCalcValid;
 
     float m_currBw; /**< calculated reference rate (r_ref in rmcat-nada) */
 
-    uint64_t m_Qdelay; /**< estimated queuing delay in ms */
-    uint64_t m_Rtt; /**< estimated RTT value in ms */
+    uint64_t m_Qdelay; /**< estimated queuing delay in us */
+    uint64_t m_Rtt; /**< estimated RTT value in us */
     float m_Xcurr;  /**< aggregated congestion signal (x_curr in rmcat-nada) in ms */
     float m_Xprev;  /**< previous value of the aggregated congestion signal (x_prev in rmcat-nada), in ms */
     float m_RecvR;  /**< updated receiving rate in bps */
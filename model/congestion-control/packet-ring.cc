@@ -0,0 +1,93 @@
+/******************************************************************************
+ * Copyright 2016-2017 Cisco Systems, Inc.                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ *                                                                            *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+/**
+ * @file
+ * Ring buffer of packet records implementation.
+ *
+ * @version 0.1.0
+ * @author Jiantao Fu
+ * @author Sergio Mena
+ * @author Xiaoqing Zhu
+ */
+#include "packet-ring.h"
+
+namespace rmcat {
+
+const size_t PACKET_RING_MIN_CAPACITY = 16; /**< initial capacity, in records */
+
+PacketRing::PacketRing()
+: m_sequences{},
+  m_txTimestamps{},
+  m_sizes{},
+  m_owds{},
+  m_rtts{},
+  m_ecns{},
+  m_head{0},
+  m_count{0},
+  m_mask{0} {
+    resize(PACKET_RING_MIN_CAPACITY);
+}
+
+void PacketRing::reserve(size_t n) {
+    size_t newCapacity = capacity();
+    while (newCapacity < n) {
+        newCapacity <<= 1;
+    }
+    if (newCapacity != capacity()) {
+        resize(newCapacity);
+    }
+}
+
+void PacketRing::grow() {
+    resize(capacity() << 1);
+}
+
+void PacketRing::resize(size_t newCapacity) {
+    // Power of two
+    assert(newCapacity > 0 && (newCapacity & (newCapacity - 1)) == 0);
+    assert(newCapacity >= m_count);
+
+    std::vector<uint32_t> sequences(newCapacity);
+    std::vector<uint64_t> txTimestamps(newCapacity);
+    std::vector<uint32_t> sizes(newCapacity);
+    std::vector<uint64_t> owds(newCapacity);
+    std::vector<uint64_t> rtts(newCapacity);
+    std::vector<uint8_t> ecns(newCapacity);
+
+    // Unroll the records, the oldest one lands at slot 0
+    for (size_t i = 0; i < m_count; ++i) {
+        const size_t s = slot(i);
+        sequences[i] = m_sequences[s];
+        txTimestamps[i] = m_txTimestamps[s];
+        sizes[i] = m_sizes[s];
+        owds[i] = m_owds[s];
+        rtts[i] = m_rtts[s];
+        ecns[i] = m_ecns[s];
+    }
+
+    m_sequences.swap(sequences);
+    m_txTimestamps.swap(txTimestamps);
+    m_sizes.swap(sizes);
+    m_owds.swap(owds);
+    m_rtts.swap(rtts);
+    m_ecns.swap(ecns);
+    m_head = 0;
+    m_mask = newCapacity - 1;
+}
+
+}
@@ -0,0 +1,179 @@
+/******************************************************************************
+ * Copyright 2016-2017 Cisco Systems, Inc.                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ *                                                                            *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+/**
+ * @file
+ * Ring buffer of packet records used by sender-based controllers.
+ *
+ * @version 0.1.0
+ * @author Jiantao Fu
+ * @author Sergio Mena
+ * @author Xiaoqing Zhu
+ */
+
+#ifndef PACKET_RING_H
+#define PACKET_RING_H
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <cassert>
+
+namespace rmcat {
+
+/**
+ * Timestamps and delays handled by controllers (including those in
+ * #PacketRecord ) are in microseconds: at high rates, several packets are
+ * sent, and received, within the same millisecond
+ */
+const uint64_t RMCAT_US_PER_MS = 1000;
+const uint64_t RMCAT_US_PER_SEC = 1000 * RMCAT_US_PER_MS;
+
+/** To avoid future complexity and defects, we make the following
+ *  assumptions regarding wrapping of unsigned integers:
+ *    - sequences, uint32_t, can wrap (just like TCP)
+ *    - timestamps, uint64_t, can wrap (despite being 64 bits long)
+ *    - delays, uint64_t, can wrap (easily), as they are obtained from
+ *      subtraction of timestamps obtained at different endpoints,
+ *      which may have non-synchronized clocks.
+ */
+struct PacketRecord {
+    uint32_t sequence;
+    uint64_t txTimestamp;
+    uint32_t size;
+    uint64_t owd;
+    uint64_t rtt;
+    uint8_t ecn; /**< ECN codepoint seen by the receiver (2 bits) */
+};
+
+/**
+ * First-in first-out container of #PacketRecord elements, implemented as a
+ * ring buffer whose capacity is a power of two.
+ *
+ * Controllers push records at the back and pop them at the front on every
+ * packet sent and every feedback received. A std::deque allocates and frees
+ * a chunk of memory every few hundred operations in that usage pattern; this
+ * container does not allocate at all once it has been dimensioned with
+ * #reserve . Should it ever become full, its capacity is doubled.
+ *
+ * The fields of the records are stored in separate arrays (struct of
+ * arrays), so that metrics scanning a single field (e.g., one way delays)
+ * walk contiguous memory.
+ */
+class PacketRing {
+public:
+    /** Class constructor: the ring is empty, with a small initial capacity */
+    PacketRing();
+
+    /**
+     * Make sure the ring can hold at least n records without growing.
+     * The capacity is rounded up to a power of two; it never shrinks.
+     * Records currently stored are preserved
+     *
+     * @param [in] n Minimum number of records the ring should hold
+     */
+    void reserve(size_t n);
+
+    /** Number of records the ring can hold before growing */
+    size_t capacity() const { return m_mask + 1; }
+
+    /** Number of records currently stored */
+    size_t size() const { return m_count; }
+
+    /** Whether the ring contains no records */
+    bool empty() const { return m_count == 0; }
+
+    /** Remove all records. Capacity is kept */
+    void clear() {
+        m_head = 0;
+        m_count = 0;
+    }
+
+    /** Append a record at the back (newest position) */
+    void push_back(const PacketRecord& record) {
+        if (m_count == capacity()) {
+            grow();
+        }
+        const size_t s = (m_head + m_count) & m_mask;
+        m_sequences[s] = record.sequence;
+        m_txTimestamps[s] = record.txTimestamp;
+        m_sizes[s] = record.size;
+        m_owds[s] = record.owd;
+        m_rtts[s] = record.rtt;
+        m_ecns[s] = record.ecn;
+        ++m_count;
+    }
+
+    /** Remove the record at the front (oldest position) */
+    void pop_front() {
+        assert(m_count > 0);
+        m_head = (m_head + 1) & m_mask;
+        --m_count;
+    }
+
+    /** Oldest record */
+    PacketRecord front() const { return at(0); }
+
+    /** Newest record */
+    PacketRecord back() const { return at(m_count - 1); }
+
+    /**
+     * Access a record by its position
+     *
+     * @param [in] i Position of the record, 0 being the oldest record
+     * @retval A copy of the record
+     */
+    PacketRecord at(size_t i) const {
+        const size_t s = slot(i);
+        return PacketRecord{m_sequences[s],
+                            m_txTimestamps[s],
+                            m_sizes[s],
+                            m_owds[s],
+                            m_rtts[s],
+                            m_ecns[s]};
+    }
+
+    /* Single-field accessors; i is the position, 0 being the oldest record */
+    uint32_t sequence(size_t i) const { return m_sequences[slot(i)]; }
+    uint64_t txTimestamp(size_t i) const { return m_txTimestamps[slot(i)]; }
+    uint32_t pktSize(size_t i) const { return m_sizes[slot(i)]; }
+    uint64_t owd(size_t i) const { return m_owds[slot(i)]; }
+    uint64_t rtt(size_t i) const { return m_rtts[slot(i)]; }
+    uint8_t ecn(size_t i) const { return m_ecns[slot(i)]; }
+
+private:
+    size_t slot(size_t i) const {
+        assert(i < m_count);
+        return (m_head + i) & m_mask;
+    }
+    void grow();
+    void resize(size_t newCapacity);
+
+    std::vector<uint32_t> m_sequences;
+    std::vector<uint64_t> m_txTimestamps;
+    std::vector<uint32_t> m_sizes;
+    std::vector<uint64_t> m_owds;
+    std::vector<uint64_t> m_rtts;
+    std::vector<uint8_t> m_ecns;
+    size_t m_head;  /**< slot of the oldest record */
+    size_t m_count; /**< number of records stored */
+    size_t m_mask;  /**< capacity - 1; capacity is a power of two */
+};
+
+}
+
+#endif /* PACKET_RING_H */
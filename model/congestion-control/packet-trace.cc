@@ -0,0 +1,301 @@
+/******************************************************************************
+ * Copyright 2016-2017 Cisco Systems, Inc.                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ *                                                                            *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+/**
+ * @file
+ * Binary packet trace files implementation.
+ *
+ * @version 0.1.0
+ * @author Jiantao Fu
+ * @author Sergio Mena
+ * @author Xiaoqing Zhu
+ */
+#include "packet-trace.h"
+#include "packet-ring.h"
+#include <cstring>
+#include <cassert>
+
+namespace rmcat {
+
+static const char TRACE_MAGIC[4] = {'R', 'M', 'T', 'R'};
+const uint8_t TRACE_VERSION = 2;
+const uint8_t TRACE_FLAG_RECEIVED = 0x01;
+const unsigned TRACE_ECN_SHIFT = 1; /**< position of the ECN codepoint in the flags */
+const uint8_t TRACE_ECN_MASK = 0x03;
+const size_t TRACE_BUFFER_SIZE = 1 << 16; /**< bytes written/read at once */
+const size_t TRACE_MAX_RECORD_SIZE = 1 + 5 * 10; /**< flags + 5 varints */
+/**
+ * Packets whose feedback has not arrived after this time (in us) are
+ * recorded as lost. Same as the controllers' in-transit packet timeout
+ */
+const uint64_t TRACE_MAX_FEEDBACK_DELAY = 5000 * RMCAT_US_PER_MS;
+
+static uint64_t zigzag(int64_t value) {
+    return (uint64_t(value) << 1) ^ uint64_t(value >> 63);
+}
+
+static int64_t unzigzag(uint64_t value) {
+    return int64_t(value >> 1) ^ -int64_t(value & 1);
+}
+
+static void putVarint(std::vector<uint8_t>& buf, uint64_t value) {
+    while (value >= 0x80) {
+        buf.push_back(uint8_t(value) | 0x80);
+        value >>= 7;
+    }
+    buf.push_back(uint8_t(value));
+}
+
+PacketTraceWriter::PacketTraceWriter()
+: m_file{NULL},
+  m_buffer{},
+  m_lastTxTimestamp{0},
+  m_lastSequence{0} {}
+
+PacketTraceWriter::~PacketTraceWriter() {
+    close();
+}
+
+bool PacketTraceWriter::open(const std::string& path) {
+    close();
+    m_file = std::fopen(path.c_str(), "wb");
+    if (m_file == NULL) {
+        return false;
+    }
+    m_buffer.reserve(TRACE_BUFFER_SIZE + TRACE_MAX_RECORD_SIZE);
+    m_buffer.insert(m_buffer.end(), TRACE_MAGIC, TRACE_MAGIC + sizeof(TRACE_MAGIC));
+    m_buffer.push_back(TRACE_VERSION);
+    m_lastTxTimestamp = 0;
+    m_lastSequence = 0;
+    return true;
+}
+
+bool PacketTraceWriter::isOpen() const {
+    return m_file != NULL;
+}
+
+void PacketTraceWriter::write(const TraceRecord& record) {
+    assert(m_file != NULL);
+    m_buffer.push_back(record.received
+                       ? uint8_t(TRACE_FLAG_RECEIVED
+                                 | (record.ecn & TRACE_ECN_MASK) << TRACE_ECN_SHIFT)
+                       : 0);
+    // Subtractions wrap as needed; zigzag keeps small negative values short
+    putVarint(m_buffer, zigzag(int64_t(record.txTimestamp - m_lastTxTimestamp)));
+    putVarint(m_buffer, zigzag(int32_t(record.sequence - m_lastSequence)));
+    putVarint(m_buffer, record.size);
+    if (record.received) {
+        putVarint(m_buffer, zigzag(int64_t(record.rxTimestamp - record.txTimestamp)));
+        putVarint(m_buffer, zigzag(int64_t(record.fbTimestamp - record.rxTimestamp)));
+    }
+    m_lastTxTimestamp = record.txTimestamp;
+    m_lastSequence = record.sequence;
+    if (m_buffer.size() >= TRACE_BUFFER_SIZE) {
+        flush();
+    }
+}
+
+void PacketTraceWriter::close() {
+    if (m_file == NULL) {
+        return;
+    }
+    flush();
+    std::fclose(m_file);
+    m_file = NULL;
+}
+
+void PacketTraceWriter::flush() {
+    if (!m_buffer.empty()) {
+        std::fwrite(m_buffer.data(), 1, m_buffer.size(), m_file);
+        m_buffer.clear();
+    }
+}
+
+PacketTraceReader::PacketTraceReader()
+: m_file{NULL},
+  m_buffer(TRACE_BUFFER_SIZE),
+  m_pos{0},
+  m_end{0},
+  m_lastTxTimestamp{0},
+  m_lastSequence{0} {}
+
+PacketTraceReader::~PacketTraceReader() {
+    close();
+}
+
+bool PacketTraceReader::open(const std::string& path) {
+    close();
+    m_file = std::fopen(path.c_str(), "rb");
+    if (m_file == NULL) {
+        return false;
+    }
+    m_pos = 0;
+    m_end = 0;
+    m_lastTxTimestamp = 0;
+    m_lastSequence = 0;
+
+    char magic[sizeof(TRACE_MAGIC)];
+    for (size_t i = 0; i < sizeof(magic); ++i) {
+        uint8_t byte;
+        if (!readByte(byte)) {
+            close();
+            return false;
+        }
+        magic[i] = char(byte);
+    }
+    uint8_t version;
+    if (std::memcmp(magic, TRACE_MAGIC, sizeof(magic)) != 0 ||
+        !readByte(version) ||
+        version != TRACE_VERSION) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool PacketTraceReader::read(TraceRecord& record) {
+    if (m_file == NULL) {
+        return false;
+    }
+    uint8_t flags;
+    if (!readByte(flags)) {
+        return false;
+    }
+    uint64_t txDelta, seqDelta, size;
+    if (!readVarint(txDelta) || !readVarint(seqDelta) || !readVarint(size)) {
+        return false;
+    }
+    record.txTimestamp = m_lastTxTimestamp + uint64_t(unzigzag(txDelta));
+    record.sequence = m_lastSequence + uint32_t(unzigzag(seqDelta));
+    record.size = uint32_t(size);
+    record.received = (flags & TRACE_FLAG_RECEIVED) != 0;
+    record.rxTimestamp = 0;
+    record.fbTimestamp = 0;
+    record.ecn = 0;
+    if (record.received) {
+        uint64_t owd, fbDelay;
+        if (!readVarint(owd) || !readVarint(fbDelay)) {
+            return false;
+        }
+        record.rxTimestamp = record.txTimestamp + uint64_t(unzigzag(owd));
+        record.fbTimestamp = record.rxTimestamp + uint64_t(unzigzag(fbDelay));
+        record.ecn = (flags >> TRACE_ECN_SHIFT) & TRACE_ECN_MASK;
+    }
+    m_lastTxTimestamp = record.txTimestamp;
+    m_lastSequence = record.sequence;
+    return true;
+}
+
+void PacketTraceReader::close() {
+    if (m_file != NULL) {
+        std::fclose(m_file);
+        m_file = NULL;
+    }
+}
+
+bool PacketTraceReader::readByte(uint8_t& byte) {
+    if (m_pos == m_end) {
+        m_end = std::fread(m_buffer.data(), 1, m_buffer.size(), m_file);
+        m_pos = 0;
+        if (m_end == 0) {
+            return false;
+        }
+    }
+    byte = m_buffer[m_pos++];
+    return true;
+}
+
+bool PacketTraceReader::readVarint(uint64_t& value) {
+    value = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+        uint8_t byte;
+        if (!readByte(byte)) {
+            return false;
+        }
+        value |= uint64_t(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false; // Malformed: too long
+}
+
+PacketTraceRecorder::PacketTraceRecorder()
+: m_writer{},
+  m_pending{} {}
+
+bool PacketTraceRecorder::open(const std::string& path) {
+    m_pending.clear();
+    return m_writer.open(path);
+}
+
+bool PacketTraceRecorder::isOpen() const {
+    return m_writer.isOpen();
+}
+
+void PacketTraceRecorder::onSend(uint64_t txTimestamp,
+                                 uint32_t sequence,
+                                 uint32_t size) {
+    if (!isOpen()) {
+        return;
+    }
+    if (!m_pending.empty() && sequence != m_pending.back().sequence + 1) {
+        // Sequence restarted: nothing pending will be matched any more
+        writeSettled(txTimestamp + TRACE_MAX_FEEDBACK_DELAY + 1);
+    }
+    m_pending.push_back(TraceRecord{txTimestamp, sequence, size, false, 0, 0, 0});
+    writeSettled(txTimestamp);
+}
+
+void PacketTraceRecorder::onFeedback(uint64_t now,
+                                     uint32_t sequence,
+                                     uint64_t rxTimestamp,
+                                     uint8_t ecn) {
+    if (!isOpen() || m_pending.empty()) {
+        return;
+    }
+    const uint32_t index = sequence - m_pending.front().sequence;
+    if (index < m_pending.size() && !m_pending[index].received) {
+        TraceRecord& record = m_pending[index];
+        record.received = true;
+        record.rxTimestamp = rxTimestamp;
+        record.fbTimestamp = now;
+        record.ecn = ecn;
+    }
+    writeSettled(now);
+}
+
+void PacketTraceRecorder::close() {
+    while (!m_pending.empty()) {
+        m_writer.write(m_pending.front());
+        m_pending.pop_front();
+    }
+    m_writer.close();
+}
+
+void PacketTraceRecorder::writeSettled(uint64_t now) {
+    while (!m_pending.empty()) {
+        const TraceRecord& front = m_pending.front();
+        if (!front.received && now - front.txTimestamp <= TRACE_MAX_FEEDBACK_DELAY) {
+            break;
+        }
+        m_writer.write(front);
+        m_pending.pop_front();
+    }
+}
+
+}
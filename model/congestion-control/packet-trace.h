@@ -0,0 +1,192 @@
+/******************************************************************************
+ * Copyright 2016-2017 Cisco Systems, Inc.                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ *                                                                            *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+/**
+ * @file
+ * Binary packet trace files, used to replay the packets and feedback seen
+ * by a sender into congestion controllers without running a simulation.
+ *
+ * @version 0.1.0
+ * @author Jiantao Fu
+ * @author Sergio Mena
+ * @author Xiaoqing Zhu
+ */
+
+#ifndef PACKET_TRACE_H
+#define PACKET_TRACE_H
+
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <string>
+#include <vector>
+
+namespace rmcat {
+
+/**
+ * What the sender endpoint knows about one media packet once its fate is
+ * settled. Timestamps are in the controllers' time unit (us)
+ */
+struct TraceRecord {
+    uint64_t txTimestamp; /**< time at which the packet was sent */
+    uint32_t sequence;    /**< sequence number of the packet */
+    uint32_t size;        /**< size of the packet in bytes */
+    bool received;        /**< whether feedback about the packet arrived */
+    uint64_t rxTimestamp; /**< time at which the receiver got the packet */
+    uint64_t fbTimestamp; /**< time at which the feedback reached the sender */
+    uint8_t ecn;          /**< ECN codepoint seen by the receiver (2 bits) */
+};
+
+/**
+ * Writes #TraceRecord elements, in sending order, to a trace file.
+ *
+ * The file starts with a 4-byte magic string and a version byte. Each
+ * record is then encoded as a flags byte (bit 0: received; bits 1-2: ECN
+ * codepoint, if received) followed by variable-length integers (7 bits per
+ * byte, least significant first): the zigzag-encoded differences from the
+ * previous record's send timestamp and sequence, the size, and (if
+ * received) the zigzag-encoded differences rx - tx and feedback - rx, all
+ * times in us. A typical record takes 12 bytes.
+ */
+class PacketTraceWriter {
+public:
+    /** Class constructor: no file is open */
+    PacketTraceWriter();
+
+    /** Class destructor: closes the file if it is open */
+    ~PacketTraceWriter();
+
+    /**
+     * Create (or truncate) a trace file and write its header
+     *
+     * @param [in] path Name of the file
+     * @retval true if the file could be opened, false otherwise
+     */
+    bool open(const std::string& path);
+
+    /** Whether a file is open */
+    bool isOpen() const;
+
+    /** Append a record to the file */
+    void write(const TraceRecord& record);
+
+    /** Flush buffered records and close the file */
+    void close();
+
+private:
+    PacketTraceWriter(const PacketTraceWriter&);
+    PacketTraceWriter& operator=(const PacketTraceWriter&);
+
+    void flush();
+
+    std::FILE* m_file;
+    std::vector<uint8_t> m_buffer;
+    uint64_t m_lastTxTimestamp;
+    uint32_t m_lastSequence;
+};
+
+/** Reads the records of a file written by #PacketTraceWriter */
+class PacketTraceReader {
+public:
+    /** Class constructor: no file is open */
+    PacketTraceReader();
+
+    /** Class destructor: closes the file if it is open */
+    ~PacketTraceReader();
+
+    /**
+     * Open a trace file and check its header
+     *
+     * @param [in] path Name of the file
+     * @retval true if the file could be opened and is a trace file of a
+     *         supported version, false otherwise
+     */
+    bool open(const std::string& path);
+
+    /**
+     * Read the next record
+     *
+     * @param [out] record The record read
+     * @retval false at the end of the file or if the file is truncated
+     *         (output parameter is not valid). True otherwise
+     */
+    bool read(TraceRecord& record);
+
+    /** Close the file */
+    void close();
+
+private:
+    PacketTraceReader(const PacketTraceReader&);
+    PacketTraceReader& operator=(const PacketTraceReader&);
+
+    bool readByte(uint8_t& byte);
+    bool readVarint(uint64_t& value);
+
+    std::FILE* m_file;
+    std::vector<uint8_t> m_buffer;
+    size_t m_pos;  /**< next byte to read in #m_buffer */
+    size_t m_end;  /**< number of valid bytes in #m_buffer */
+    uint64_t m_lastTxTimestamp;
+    uint32_t m_lastSequence;
+};
+
+/**
+ * Builds a trace from the calls a sender makes to its controller. Packets
+ * are kept until their feedback arrives, or until they are old enough to
+ * be considered lost, and written to the trace in sending order
+ */
+class PacketTraceRecorder {
+public:
+    /** Class constructor: not recording */
+    PacketTraceRecorder();
+
+    /**
+     * Start recording to a trace file
+     *
+     * @param [in] path Name of the file
+     * @retval true if the file could be opened, false otherwise
+     */
+    bool open(const std::string& path);
+
+    /** Whether recording is in progress */
+    bool isOpen() const;
+
+    /** Record a media packet being sent (no-op if not recording); same
+     *  parameters as #SenderBasedController::processSendPacket */
+    void onSend(uint64_t txTimestamp, uint32_t sequence, uint32_t size);
+
+    /** Record feedback about a media packet (no-op if not recording); same
+     *  parameters as #SenderBasedController::processFeedback */
+    void onFeedback(uint64_t now,
+                    uint32_t sequence,
+                    uint64_t rxTimestamp,
+                    uint8_t ecn=0);
+
+    /** Write all pending packets (those without feedback as lost) and
+     *  close the file */
+    void close();
+
+private:
+    void writeSettled(uint64_t now);
+
+    PacketTraceWriter m_writer;
+    std::deque<TraceRecord> m_pending; /**< consecutive sequences */
+};
+
+}
+
+#endif /* PACKET_TRACE_H */
@@ -30,17 +30,25 @@
 #include <iostream>
 #include <sstream>
 #include <vector>
+#include <algorithm>
 #include <cassert>
 
 
 namespace rmcat {
 
 const int MIN_PACKET_LOGLEN = 5;             /**< minimum # of packets in log for stats to be meaningful */
-const uint64_t MAX_INTER_PACKET_TIME = 500;  /**< maximum interval between packets, in ms */
-const uint64_t DEFAULT_HISTORY_LENGTH = 500; /**< default time window for logging history of packets, in ms */
+const uint64_t MAX_INTER_PACKET_TIME = 500 * RMCAT_US_PER_MS;  /**< maximum interval between packets, in us */
+const uint64_t DEFAULT_HISTORY_LENGTH = 500 * RMCAT_US_PER_MS; /**< default time window for logging history of packets, in us */
+const size_t DEFAULT_MIN_FILTER_TAPS = 15;   /**< default # of taps for qdelay and rtt minimum filtering */
+const size_t DEFAULT_REORDER_WINDOW = 3;     /**< default reordering tolerated before declaring losses, in packets (as TCP's dupthresh) */
 const float RMCAT_CC_DEFAULT_RINIT = 150000.; /**< Initial BW in bps: 150Kbps */
 const float RMCAT_CC_DEFAULT_RMIN = 150000.;  /**< in bps: 150Kbps */
 const float RMCAT_CC_DEFAULT_RMAX = 1500000.; /**< in bps: 1.5Mbps */
+/**
+ * Packet size (in bytes) assumed when dimensioning the packet record buffers.
+ * Smaller than typical media packets, so that buffers rarely need to grow
+ */
+const uint32_t RING_DIMENSIONING_PKT_SIZE = 500;
 
 InterLossState::InterLossState()
 : intervals{}
@@ -57,6 +65,20 @@ void SenderBasedController::setDefaultId() {
     m_id = ss.str();
 }
 
+ControllerEventCounters::ControllerEventCounters()
+: illegalSendSequences{0},
+  inTransitTimeouts{0},
+  futureFeedback{0},
+  duplicateFeedback{0},
+  lateFeedback{0},
+  staleFeedback{0},
+  stalePurges{0},
+  decreasingTimestamps{0},
+  obsoleteHistoryResets{0},
+  emptyHistoryQueries{0},
+  shortHistoryQueries{0},
+  simultaneousReceptions{0} {}
+
 SenderBasedController::SenderBasedController()
 : m_firstSend{true},
   m_lastSequence{0},
@@ -64,14 +86,27 @@ SenderBasedController::SenderBasedController()
   m_inTransitPackets{},
   m_packetHistory{},
   m_pktSizeSum{0},
+  m_pktMarkedSum{0},
   m_id{},
   m_initBw{RMCAT_CC_DEFAULT_RINIT},
   m_minBw{RMCAT_CC_DEFAULT_RMIN},
   m_maxBw{RMCAT_CC_DEFAULT_RMAX},
   m_logCallback{NULL},
+  m_logEnabledCallback{NULL},
+  m_statsSink{},
   m_ilState{},
-  m_historyLengthMs{DEFAULT_HISTORY_LENGTH} {
+  m_events{},
+  m_historyLength{DEFAULT_HISTORY_LENGTH},
+  m_historyPushCount{0},
+  m_minFilterTaps{DEFAULT_MIN_FILTER_TAPS},
+  m_reorderWindow{DEFAULT_REORDER_WINDOW},
+  m_highestAcked{0},
+  m_highestAckedValid{false},
+  m_owdMinFilter{},
+  m_rttMinFilter{},
+  m_owdMaxFilter{} {
       setDefaultId();
+      dimensionPacketRings();
 }
 
 SenderBasedController::~SenderBasedController() {}
@@ -90,10 +125,34 @@ void SenderBasedController::setMinBw(float minBw) {
 
 void SenderBasedController::setMaxBw(float maxBw) {
     m_maxBw = maxBw;
+    dimensionPacketRings();
 }
 
-void SenderBasedController::setLogCallback(logCallback f) {
+void SenderBasedController::setReorderWindow(size_t npkts) {
+    m_reorderWindow = npkts;
+}
+
+void SenderBasedController::setMinFilterTaps(size_t ntaps) {
+    assert(ntaps > 0);
+    m_minFilterTaps = ntaps;
+    // Rebuild the filters from the samples in the history
+    m_owdMinFilter.clear();
+    m_rttMinFilter.clear();
+    const size_t n = m_packetHistory.size();
+    for (size_t i = (n > ntaps) ? n - ntaps : 0; i < n; ++i) {
+        const uint64_t index = m_historyPushCount - n + i;
+        m_owdMinFilter.push(index, m_packetHistory.owd(i));
+        m_rttMinFilter.push(index, m_packetHistory.rtt(i));
+    }
+}
+
+void SenderBasedController::setLogCallback(logCallback f, logEnabledCallback enabled) {
     m_logCallback = f;
+    m_logEnabledCallback = enabled;
+}
+
+void SenderBasedController::setStatsSink(std::shared_ptr<StatsSink> sink) {
+    m_statsSink = sink;
 }
 
 void SenderBasedController::reset() {
@@ -103,13 +162,34 @@ void SenderBasedController::reset() {
     m_inTransitPackets.clear();
     m_packetHistory.clear();
     m_pktSizeSum = 0;
+    m_pktMarkedSum = 0;
     m_initBw = RMCAT_CC_DEFAULT_RINIT;
     m_minBw = RMCAT_CC_DEFAULT_RMIN;
     m_maxBw = RMCAT_CC_DEFAULT_RMAX;
     m_logCallback = NULL;
+    m_logEnabledCallback = NULL;
+    m_statsSink.reset();
     m_ilState = InterLossState{};
-    m_historyLengthMs = DEFAULT_HISTORY_LENGTH;
+    m_events = ControllerEventCounters{};
+    m_historyLength = DEFAULT_HISTORY_LENGTH;
+    m_historyPushCount = 0;
+    m_minFilterTaps = DEFAULT_MIN_FILTER_TAPS;
+    m_reorderWindow = DEFAULT_REORDER_WINDOW;
+    m_highestAcked = 0;
+    m_highestAckedValid = false;
+    m_owdMinFilter.clear();
+    m_rttMinFilter.clear();
+    m_owdMaxFilter.clear();
     setDefaultId();
+    dimensionPacketRings();
+}
+
+void SenderBasedController::dimensionPacketRings() {
+    // Number of packets sent at the maximal rate during a given time span
+    const float pktsPerUs = m_maxBw / 8.f / float(RMCAT_US_PER_SEC) / float(RING_DIMENSIONING_PKT_SIZE);
+    // In-transit packets are kept for up to (10 * MAX_INTER_PACKET_TIME)
+    m_inTransitPackets.reserve(size_t(pktsPerUs * float(10 * MAX_INTER_PACKET_TIME)) + 1);
+    m_packetHistory.reserve(size_t(pktsPerUs * float(m_historyLength)) + 1);
 }
 
 //TODO (deferred): This logic is to be encapsulated within class InterLossState
@@ -146,9 +226,7 @@ bool SenderBasedController::processSendPacket(uint64_t txTimestamp,
     ++m_lastSequence;
 
     if (sequence != m_lastSequence) {
-        std::cerr << "SenderBasedController::ProcessSendPacket,"
-                  << " illegal sequence: " << sequence
-                  << ", should be " << m_lastSequence << std::endl;
+        ++m_events.illegalSendSequences;
         return false;
     }
 
@@ -157,17 +235,28 @@ bool SenderBasedController::processSendPacket(uint64_t txTimestamp,
                                               txTimestamp,
                                               size,
                                               0,
-                                              0});
+                                              0,
+                                              ECN_NOT_ECT});
     // Memory safety: timestamps of in-transit packets must be
     //  within (10 * MAX_INTER_PACKET_TIME)
+    bool appended = false;
     while (true) {
-        const uint64_t firstTimestamp = m_inTransitPackets.front().txTimestamp;
-        if (lessThan(firstTimestamp + 10 * MAX_INTER_PACKET_TIME,
-                     txTimestamp)) {
-            m_inTransitPackets.pop_front();
-        } else {
+        const PacketRecord& first = m_inTransitPackets.front();
+        if (!lessThan(first.txTimestamp + 10 * MAX_INTER_PACKET_TIME,
+                      txTimestamp)) {
             break;
         }
+        if (m_inTransitPackets.frontAcked()) {
+            // Waiting for older packets that timed out already
+            appended = appendToHistory(first) || appended;
+        } else {
+            ++m_events.inTransitTimeouts;
+        }
+        m_inTransitPackets.pop_front();
+    }
+    if (appended) {
+        // Same as after feedback: history length within limits
+        garbageCollectHistory();
     }
     return true;
 }
@@ -176,71 +265,118 @@ bool SenderBasedController::processFeedback(uint64_t now,
                                             uint32_t sequence,
                                             uint64_t rxTimestamp,
                                             uint8_t ecn) {
+    const bool res = ingestFeedback(now, sequence, rxTimestamp, ecn);
+    garbageCollectHistory();
+    return res;
+}
+
+bool SenderBasedController::processFeedbackBatch(uint64_t now,
+                                                 const FeedbackEntry* entries,
+                                                 size_t n) {
+    bool res = true;
+    for (size_t i = 0; i < n; ++i) {
+        const FeedbackEntry& entry = entries[i];
+        res = ingestFeedback(now,
+                             entry.sequence,
+                             entry.rxTimestamp,
+                             entry.ecn) && res;
+    }
+    // History length only needs to be enforced once per feedback packet
+    garbageCollectHistory();
+    return res;
+}
+
+bool SenderBasedController::ingestFeedback(uint64_t now,
+                                           uint32_t sequence,
+                                           uint64_t rxTimestamp,
+                                           uint8_t ecn) {
     if (lessThan(m_lastSequence, sequence)) {
-        std::cerr << "SenderBasedController::ProcessFeedback,"
-                  << " strange sequence: " << sequence
-                  << " from the future" << std::endl;
+        ++m_events.futureFeedback;
         return false;
     }
 
-    if (m_inTransitPackets.empty()) {
-        std::cerr << "SenderBasedController::ProcessFeedback,"
-                  << " sequence: " << sequence
-                  << " duplicate or out of order" << std::endl;
+    if (!m_inTransitPackets.contains(sequence)) {
+        // The packet already left the in-transit table: this is either
+        // feedback about a packet declared lost, or a duplicate
+        ++m_events.staleFeedback;
         // Returning true because it is considered valid to process
         // duplicate/out of order sequences
         return true;
     }
 
-    assert(m_inTransitPackets.back().sequence == m_lastSequence);
+    assert(uint32_t(m_inTransitPackets.firstSequence()
+                    + m_inTransitPackets.size() - 1) == m_lastSequence);
 
-    while (lessThan(m_inTransitPackets.front().sequence, sequence)) {
-        // Packet lost or out of order. Remove stale entry
-        m_inTransitPackets.pop_front();
-        // Note: we can't tell whether the media (forward path) packet
-        //     or the feedback (backward path) packet was lost.
-        // Assuming media packet was lost for the time being
+    if (m_inTransitPackets.isAcked(sequence)) {
+        ++m_events.duplicateFeedback;
+        return true;
     }
 
-    if (lessThan(sequence, m_inTransitPackets.front().sequence)) {
-        std::cerr << "SenderBasedController::ProcessFeedback,"
-                  << " sequence: " << sequence
-                  << " out of order" << std::endl;
-        return true;
+    const PacketRecord& packet = m_inTransitPackets.record(sequence);
+    // Sanity check
+    assert(packet.owd == 0);
+    assert(packet.rtt == 0);
+
+    // This subtraction can wrap if clocks aren't synchronized, but it's OK
+    m_inTransitPackets.ack(sequence,
+                           rxTimestamp - packet.txTimestamp,
+                           now - packet.txTimestamp,
+                           uint8_t(ecn & ECN_CE));
+
+    if (!m_highestAckedValid || lessThan(m_highestAcked, sequence)) {
+        m_highestAcked = sequence;
+        m_highestAckedValid = true;
+    } else {
+        // Feedback about a later packet arrived first, but this packet
+        // is still within the reorder window
+        ++m_events.lateFeedback;
     }
 
-    PacketRecord packet = m_inTransitPackets.front();
-    m_inTransitPackets.pop_front();
-    assert(sequence == packet.sequence);
+    return releaseSettledPackets();
+}
+
+bool SenderBasedController::releaseSettledPackets() {
+    bool res = true;
+    while (!m_inTransitPackets.empty()) {
+        const uint32_t first = m_inTransitPackets.firstSequence();
+        if (m_inTransitPackets.frontAcked()) {
+            res = appendToHistory(m_inTransitPackets.front()) && res;
+        } else if (lessThan(uint32_t(first + m_reorderWindow), m_highestAcked)) {
+            // Feedback about packets more than m_reorderWindow sequences
+            // later has arrived: packet lost. Remove stale entry
+            // Note: we can't tell whether the media (forward path) packet
+            //     or the feedback (backward path) packet was lost.
+            // Assuming media packet was lost for the time being
+            ++m_events.stalePurges;
+        } else {
+            break;
+        }
+        m_inTransitPackets.pop_front();
+    }
+    return res;
+}
 
+bool SenderBasedController::appendToHistory(const PacketRecord& packet) {
     if (!m_packetHistory.empty()) {
         const PacketRecord& lastPacket = m_packetHistory.back();
         if (lessThan(packet.txTimestamp, lastPacket.txTimestamp)) {
-            std::cerr << "SenderBasedController::ProcessFeedback,"
-                      << " sequence: " << sequence
-                      << " has decreasing timestamp " << packet.txTimestamp
-                      << " w.r.t. sequence " << lastPacket.sequence
-                      << " with timestamp " << lastPacket.txTimestamp
-                      << std::endl;
+            ++m_events.decreasingTimestamps;
             return false;
         }
         if (lessThan(lastPacket.txTimestamp + MAX_INTER_PACKET_TIME,
                      packet.txTimestamp)) {
             // It's been too long without receiving any feedback packet
             // Packet history is obsolete
+            ++m_events.obsoleteHistoryResets;
             m_packetHistory.clear();
             m_pktSizeSum = 0;
+            m_pktMarkedSum = 0;
+            m_owdMinFilter.clear();
+            m_rttMinFilter.clear();
+            m_owdMaxFilter.clear();
         }
     }
 
-    // Sanity check
-    assert(packet.owd == 0);
-    assert(packet.rtt == 0);
-
-    // This subtraction can wrap if clocks aren't synchronized, but it's OK
-    packet.owd = rxTimestamp - packet.txTimestamp;
-    packet.rtt = now - packet.txTimestamp;
-
     if (m_packetHistory.empty() || lessThan(packet.owd, m_baseDelay)) {
         m_baseDelay = packet.owd;
     }
@@ -249,29 +385,61 @@ bool SenderBasedController::processFeedback(uint64_t now,
 
     m_packetHistory.push_back(packet);
     m_pktSizeSum += packet.size;
+    if (packet.ecn == ECN_CE) {
+        ++m_pktMarkedSum;
+    }
+    m_owdMinFilter.push(m_historyPushCount, packet.owd);
+    m_rttMinFilter.push(m_historyPushCount, packet.rtt);
+    m_owdMaxFilter.push(m_historyPushCount, packet.owd);
+    ++m_historyPushCount;
+    // Minimum filters never cover more than m_minFilterTaps samples, even
+    // before the history is garbage collected
+    updateDelayFilters();
+    return true;
+}
 
+void SenderBasedController::garbageCollectHistory() {
+    if (m_packetHistory.empty()) {
+        return;
+    }
     // Garbage collect history to keep its length within limits
+    const uint64_t lastTimestamp = m_packetHistory.back().txTimestamp;
     while (true) {
-        const uint64_t lastTimestamp = m_packetHistory.back().txTimestamp;
-        const uint64_t firstTimestamp = m_packetHistory.front().txTimestamp;
+        const uint64_t firstTimestamp = m_packetHistory.txTimestamp(0);
         assert (!lessThan(lastTimestamp, firstTimestamp));
-        if (lessThan(lastTimestamp, firstTimestamp + m_historyLengthMs)) {
+        if (lessThan(lastTimestamp, firstTimestamp + m_historyLength)) {
             break;
         }
-        const uint32_t firstSize = m_packetHistory.front().size;
+        const uint32_t firstSize = m_packetHistory.pktSize(0);
+        const bool firstMarked = (m_packetHistory.ecn(0) == ECN_CE);
         m_packetHistory.pop_front();
         assert(m_pktSizeSum >= firstSize);
         m_pktSizeSum -= firstSize;
+        if (firstMarked) {
+            assert(m_pktMarkedSum > 0);
+            --m_pktMarkedSum;
+        }
     }
-    return true;
+    updateDelayFilters();
+}
+
+void SenderBasedController::updateDelayFilters() {
+    // Minimum filters cover the last m_minFilterTaps packets still in the
+    // history; the maximum filter covers the whole history
+    const uint64_t nHistory = m_packetHistory.size();
+    const uint64_t nSamples = std::min<uint64_t>(m_minFilterTaps, nHistory);
+    m_owdMinFilter.expire(m_historyPushCount - nSamples);
+    m_rttMinFilter.expire(m_historyPushCount - nSamples);
+    m_owdMaxFilter.expire(m_historyPushCount - nHistory);
 }
 
-void SenderBasedController::setHistoryLength(uint64_t lenMs) {
-    m_historyLengthMs = lenMs;
+void SenderBasedController::setHistoryLength(uint64_t len) {
+    m_historyLength = len;
+    dimensionPacketRings();
 }
 
 uint64_t SenderBasedController::getHistoryLength() const {
-    return m_historyLengthMs;
+    return m_historyLength;
 }
 
 // These functions calculate different metrics based on the feedback received.
@@ -279,70 +447,42 @@ uint64_t SenderBasedController::getHistoryLength() const {
 // defined them in the superclass because they could also be useful to other
 // algorithms
 bool SenderBasedController::getCurrentQdelay(uint64_t& qdelay) const {
-    // 15-tab minimum filtering
-    const size_t ntab = 15;
     if (m_packetHistory.empty()) {
-        std::cerr << "SenderBasedController::getCurrentQdelay,"
-                  << " cannot calculate qdelay, packet history is empty"
-                  << std::endl;
+        ++m_events.emptyHistoryQueries;
         return false;
     }
 
-    uint64_t qDelayMin;
-    size_t iter = 0;
-    for (auto rit = m_packetHistory.rbegin();
-            rit != m_packetHistory.rend();
-            ++rit) {
-        const uint64_t qDelayCurrent = rit->owd - m_baseDelay;
-        if (iter > 0) {
-            qDelayMin = std::min(qDelayMin, qDelayCurrent);
-        } else {
-            qDelayMin = qDelayCurrent;
-        }
-        if (++iter >= ntab) {
-            break;
-        }
-    }
-    qdelay = qDelayMin;
+    // Minimum filtering: all samples share the same base delay
+    assert(!m_owdMinFilter.empty());
+    qdelay = m_owdMinFilter.get() - m_baseDelay;
     return true;
 }
 
 bool SenderBasedController::getCurrentRTT(uint64_t& rtt) const {
-    // 15-tab minimum filtering
-    const size_t ntab = 15;
     if (m_packetHistory.empty()) {
-        std::cerr << "SenderBasedController::getCurrentRTT,"
-                  << " cannot calculate rtt, packet history is empty"
-                  << std::endl;
+        ++m_events.emptyHistoryQueries;
         return false;
     }
 
-    uint64_t rttMin = 0;
-    size_t iter = 0;
-    for (auto rit = m_packetHistory.rbegin();
-            rit != m_packetHistory.rend();
-            ++rit) {
-        const uint64_t rttCurrent = rit->rtt;
-        if (iter > 0) {
-            rttMin = std::min(rttMin, rttCurrent);
-        } else {
-            rttMin = rttCurrent;
-        }
-        if (++iter >= ntab) {
-            break;
-        }
+    // Minimum filtering
+    assert(!m_rttMinFilter.empty());
+    rtt = m_rttMinFilter.get();
+    return true;
+}
+
+bool SenderBasedController::getMaxQdelay(uint64_t& qdelayMax) const {
+    if (m_packetHistory.empty()) {
+        return false;
     }
 
-    rtt = rttMin;
+    assert(!m_owdMaxFilter.empty());
+    qdelayMax = m_owdMaxFilter.get() - m_baseDelay;
     return true;
 }
 
 bool SenderBasedController::getPktLossInfo(uint32_t& nLoss, float& plr) const {
     if (m_packetHistory.size() < MIN_PACKET_LOGLEN) {
-        std::cerr << "SenderBasedController::getPktLossInfo,"
-                  << "packet history too short: "
-                  << m_packetHistory.size()
-                  << " < " << MIN_PACKET_LOGLEN << std::endl;
+        ++m_events.shortHistoryQueries;
         return false;
     }
 
@@ -355,12 +495,21 @@ bool SenderBasedController::getPktLossInfo(uint32_t& nLoss, float& plr) const {
     return true;
 }
 
+bool SenderBasedController::getPktMarkingInfo(uint32_t& nMarked, float& pmr) const {
+    if (m_packetHistory.size() < MIN_PACKET_LOGLEN) {
+        ++m_events.shortHistoryQueries;
+        return false;
+    }
+
+    assert(m_pktMarkedSum <= m_packetHistory.size());
+    nMarked = m_pktMarkedSum;
+    pmr = float(nMarked) / float(m_packetHistory.size());
+    return true;
+}
+
 bool SenderBasedController::getCurrentRecvRate(float& rrateBps) const {
     if (m_packetHistory.size() < MIN_PACKET_LOGLEN) {
-        std::cerr << "SenderBasedController::getCurrentRecvRate,"
-                  << "packet history too short: "
-                  << m_packetHistory.size()
-                  << " < " << MIN_PACKET_LOGLEN << std::endl;
+        ++m_events.shortHistoryQueries;
         return false;
     }
 
@@ -372,16 +521,14 @@ bool SenderBasedController::getCurrentRecvRate(float& rrateBps) const {
     uint64_t timeSpan = lastRx - firstRx;
 
     if (timeSpan == 0) {
-        std::cerr << "SenderBasedController::getCurrentRecvRate,"
-                  << " cannot calculate receive rate,"
-                  << " all packets were received simultaneously" << std::endl;
+        ++m_events.simultaneousReceptions;
         return false;
     }
 
     // Technically, the first packet is out of the calculated time span
     assert(front.size <= m_pktSizeSum);
     const uint32_t bytes = m_pktSizeSum - front.size;
-    rrateBps = float(bytes * 8) * 1000.f / float(timeSpan);
+    rrateBps = float(bytes * 8) * float(RMCAT_US_PER_SEC) / float(timeSpan);
     return true;
 }
 
@@ -424,4 +571,35 @@ void SenderBasedController::logMessage(const std::string& log) const {
     }
 }
 
+const ControllerEventCounters& SenderBasedController::getEventCounters() const {
+    return m_events;
+}
+
+void SenderBasedController::logEventCounters() const {
+    std::ostringstream os;
+    os << "DEBUG: events " << m_id
+       << " illegal_send: "     << m_events.illegalSendSequences
+       << " transit_timeout: "  << m_events.inTransitTimeouts
+       << " future_fb: "        << m_events.futureFeedback
+       << " duplicate_fb: "     << m_events.duplicateFeedback
+       << " late_fb: "          << m_events.lateFeedback
+       << " stale_fb: "         << m_events.staleFeedback
+       << " stale_purge: "      << m_events.stalePurges
+       << " decreasing_ts: "    << m_events.decreasingTimestamps
+       << " history_reset: "    << m_events.obsoleteHistoryResets
+       << " empty_history: "    << m_events.emptyHistoryQueries
+       << " short_history: "    << m_events.shortHistoryQueries
+       << " simultaneous_rx: "  << m_events.simultaneousReceptions;
+    logMessage(os.str());
+}
+
+void SenderBasedController::reportStats(const StatsRecord& record) const {
+    if (m_statsSink) {
+        m_statsSink->write(record);
+    } else if (m_logEnabledCallback == NULL || m_logEnabledCallback()) {
+        // Formatting is most of the cost: skip it if the line is dropped
+        logMessage(formatStatsRecord(record));
+    }
+}
+
 }
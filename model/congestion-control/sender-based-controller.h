@@ -29,7 +29,12 @@
 #ifndef SENDER_BASED_CONTROLLER_H
 #define SENDER_BASED_CONTROLLER_H
 
+#include "packet-ring.h"
+#include "in-transit-table.h"
+#include "monotonic-window.h"
+#include "stats-sink.h"
 #include <cstdint>
+#include <memory>
 #include <string>
 #include <deque>
 #include <utility>
@@ -39,6 +44,14 @@ namespace rmcat {
 
 const uint32_t RMCAT_LOG_PRINT_PRECISION = 2;  /* default precision for logs */
 
+/** ECN codepoints (RFC 3168), as seen by the receiver endpoint */
+enum EcnCodepoint {
+    ECN_NOT_ECT = 0x00, /**< not ECN-capable transport */
+    ECN_ECT1 = 0x01,    /**< ECN-capable transport, ECT(1) */
+    ECN_ECT0 = 0x02,    /**< ECN-capable transport, ECT(0) */
+    ECN_CE = 0x03,      /**< congestion experienced */
+};
+
 /**
  * This class keeps track of the length of intervals between two packet
  * loss events, in the way TCP-friendly Rate Control (TFRC) calculates it
@@ -51,6 +64,41 @@ public:
     bool initialized; // did the first loss happen?
 };
 
+/**
+ * Number of times the common controller logic came across unusual input or
+ * could not calculate a metric. Most of these events are routine under
+ * packet loss or reordering, or early in a flow, so they are counted rather
+ * than reported one by one
+ */
+class ControllerEventCounters {
+public:
+    ControllerEventCounters();
+    /** #processSendPacket calls with a non-consecutive sequence */
+    uint64_t illegalSendSequences;
+    /** In-transit packets dropped after (10 * MAX_INTER_PACKET_TIME) */
+    uint64_t inTransitTimeouts;
+    /** Feedback about sequences not sent yet */
+    uint64_t futureFeedback;
+    /** Feedback about packets whose feedback had already been received */
+    uint64_t duplicateFeedback;
+    /** Feedback arriving after feedback about a later packet, within the reorder window */
+    uint64_t lateFeedback;
+    /** Feedback about packets already considered lost, or moved to the history */
+    uint64_t staleFeedback;
+    /** In-transit packets considered lost, as feedback about packets beyond the reorder window arrived */
+    uint64_t stalePurges;
+    /** Feedback about packets sent earlier than those in the history */
+    uint64_t decreasingTimestamps;
+    /** Histories discarded after too long without feedback */
+    uint64_t obsoleteHistoryResets;
+    /** Delay metrics queried with an empty history */
+    uint64_t emptyHistoryQueries;
+    /** Loss or receive rate metrics queried with too short a history */
+    uint64_t shortHistoryQueries;
+    /** Receive rate queried with all packets in the history received at once */
+    uint64_t simultaneousReceptions;
+};
+
 /**
  * This is the base class to all congestion controllers. Any congestion
  * controller that is to use this NS3 component has to inherit from this
@@ -90,20 +138,25 @@ public:
      */
     typedef void (*logCallback) (const std::string&);
 
-    /** To avoid future complexity and defects, we make the following
-     *  assumptions regarding wrapping of unsigned integers:
-     *    - sequences, uint32_t, can wrap (just like TCP)
-     *    - timestamps, uint64_t, can wrap (despite being 64 bits long)
-     *    - delays, uint64_t, can wrap (easily), as they are obtained from
-     *      subtraction of timestamps obtained at different endpoints,
-     *      which may have non-synchronized clocks.
-     */
-    struct PacketRecord {
-        uint32_t sequence;
-        uint64_t txTimestamp;
-        uint32_t size;
-        uint64_t owd;
-        uint64_t rtt;
+    /**
+     * Callback telling whether the logging callback would output anything
+     * (e.g., whether the logging level is high enough), so that messages
+     * needn't be formatted in vain
+     */
+    typedef bool (*logEnabledCallback) ();
+
+    /** See #rmcat::PacketRecord for the assumptions on wrapping */
+    typedef rmcat::PacketRecord PacketRecord;
+
+    /**
+     * Information the receiver endpoint reports about one media packet;
+     * feedback reports covering several packets are delivered to the
+     * controller as an array of these (see #processFeedbackBatch)
+     */
+    struct FeedbackEntry {
+        uint32_t sequence;    /**< sequence number of the media packet */
+        uint64_t rxTimestamp; /**< time at which it was received, in us */
+        uint8_t ecn;          /**< ECN marking seen by the receiver */
     };
 
     /** Class constructor */
@@ -139,9 +192,35 @@ public:
      * a bandwidth greater than this one
      *
      * @param [in] initBw Maximal bandwidth
+     *
+     * @note The maximal bandwidth is also used to dimension the packet
+     *       record buffers, so that they do not need to grow at run time
      */
     void setMaxBw(float maxBw);
 
+    /**
+     * Set the number of taps of the minimum filters applied to queuing
+     * delay and round trip time samples (see #getCurrentQdelay and
+     * #getCurrentRTT). The filters are updated incrementally, so longer
+     * filters cost nothing extra per feedback packet
+     *
+     * @param [in] ntaps Number of most recent samples the minimum is taken
+     *                   over; must be greater than zero
+     */
+    void setMinFilterTaps(size_t ntaps);
+
+    /**
+     * Set how much reordering is tolerated before in-transit packets are
+     * considered lost. A packet is declared lost once feedback has arrived
+     * about a packet more than npkts sequences later; until then, its
+     * feedback is still accepted, and the packets after it wait to be moved
+     * to the history in sequence order. With zero, a packet is declared lost
+     * as soon as feedback about any later packet arrives
+     *
+     * @param [in] npkts Reorder window, in packets
+     */
+    void setReorderWindow(size_t npkts);
+
     /**
      * Set the current bandwidth estimation. This can be useful in test environments
      * to temporarily disrupt the current bandwidth estimation
@@ -156,8 +235,18 @@ public:
      *
      * @param [in] f Logging function to be called from the congestion
      *               controller implementation
+     * @param [in] enabled Whether @p f currently logs; if NULL, it always does
+     */
+    void setLogCallback(logCallback f, logEnabledCallback enabled = NULL);
+
+    /**
+     * Set the destination of the statistics records the controller reports
+     * at each rate update. If no sink is set, the records are formatted as
+     * text lines and passed to the logging callback (see #setLogCallback )
+     *
+     * @param [in] sink The sink; it can be shared by several controllers
      */
-    void setLogCallback(logCallback f);
+    void setStatsSink(std::shared_ptr<StatsSink> sink);
 
     /**
      * This API call will reset the internal state of the congestion
@@ -176,7 +265,8 @@ public:
      * the superclass's method to ensure the proper operation of the common
      * logic implemented by the superclass
      *
-     * @param [in] txTimestamp The time at which the packet is sent
+     * @param [in] txTimestamp The time at which the packet is sent, in us
+     *                         (see #RMCAT_US_PER_MS )
      * @param [in] sequence The sequence number in the packet, which will be
      *                      used to identify the corresponding feedback from
      *                      the receiver endpoint
@@ -205,11 +295,11 @@ public:
      * the superclass's method to ensure the proper operation of the common
      * logic implemented by the superclass
      *
-     * @param [in] now The time at which this function is called
+     * @param [in] now The time at which this function is called, in us
      * @param [in] sequence The sequence number of the media packet that this
      *                      feedback refers to
      * @param [in] rxTimestamp The time at which this the media packet was
-     *                         received at the receiver endpoint
+     *                         received at the receiver endpoint, in us
      * @param [in] ecn The Explicit Congestion Notification (ECN) marking value
      *                 (specified in rfc3168), as seen by the receiver endpoint
      * @retval true if all went well, false if there was an error
@@ -226,17 +316,47 @@ public:
                                  uint64_t rxTimestamp,
                                  uint8_t ecn=0);
 
+    /**
+     * Deliver the contents of a feedback packet reporting on several media
+     * packets at once. The result is the same as calling #processFeedback
+     * on each entry in turn, but the work that does not depend on individual
+     * packets (history garbage collection, metric and rate updates) is done
+     * only once per batch
+     *
+     * As with #processFeedback , subclasses overriding this member function
+     * should call the superclass's method
+     *
+     * @param [in] now The time at which this function is called, in us
+     * @param [in] entries Per-packet feedback, in the order reported by the
+     *                     receiver endpoint
+     * @param [in] n Number of elements in entries
+     * @retval true if all entries were processed well, false if there was an
+     *         error in any of them (see #processFeedback)
+     */
+    virtual bool processFeedbackBatch(uint64_t now,
+                                      const FeedbackEntry* entries,
+                                      size_t n);
+
     /**
      * The sender application will call this function every time it needs to
      * know what is the current bandwidth as estimated by the congestion
      * controller. The bandwidth information is typically used to have the
      * media codecs adapted to the current (estimated) available bandwidth
      *
-     * @param [in] now The time at which this function is called
+     * @param [in] now The time at which this function is called, in us
      * @retval the congestion controller's bandwidth estimation, in bps
      */
     virtual float getBandwidth(uint64_t now) const =0;
 
+    /** Event counters accumulated since construction or the last #reset */
+    const ControllerEventCounters& getEventCounters() const;
+
+    /**
+     * Log the event counters as a single "DEBUG:" line (ignored by
+     * tools/process_test_logs.py). Intended to be called at teardown
+     */
+    void logEventCounters() const;
+
 protected:
     /** A "less than" operator for unsigned integers that supports wrapping */
     template <typename UINT>
@@ -247,20 +367,20 @@ protected:
     }
 
     /**
-     * Set the history length, in ms, for calculating metrics. Information from
-     * packets sent more than lenMs milliseconds ago will be garbage collected
+     * Set the history length, in us, for calculating metrics. Information from
+     * packets sent more than len microseconds ago will be garbage collected
      * and thus not used for metric calculation
      *
-     * @param [in] lenMs New history length (in ms)
+     * @param [in] len New history length (in us)
      */
-    void setHistoryLength(uint64_t lenMs);
+    void setHistoryLength(uint64_t len);
 
     /**
-     * Get the current history length, in ms. Any packet that was sent more
-     * than this length milliseconds in the past is garbage collected and is
+     * Get the current history length, in us. Any packet that was sent more
+     * than this length microseconds in the past is garbage collected and is
      * not used for calculating any metric
      *
-     * @retval The current history length (in ms)
+     * @retval The current history length (in us)
      */
     uint64_t getHistoryLength() const;
 
@@ -270,6 +390,13 @@ protected:
      */
     void logMessage(const std::string& log) const;
 
+    /**
+     * Function used to report statistics. It passes the record to the stats
+     * sink if one has been set, otherwise it logs the record as a text line
+     * with #logMessage , unless logging is disabled
+     */
+    void reportStats(const StatsRecord& record) const;
+
     /*
      * The functions below calculate different delay and loss
      * metrics based on the received feedback. Although they can
@@ -279,7 +406,8 @@ protected:
      * */
 
     /*
-     * Calculate current queuing delay (qdelay)
+     * Calculate current queuing delay (qdelay), as the minimum of the
+     * queuing delay of the last few packets (see #setMinFilterTaps )
      *
      * @param [out] qdelay Queuing delay during current history length
      * @retval False if the current history is empty (output parameter is not
@@ -288,7 +416,8 @@ protected:
     bool getCurrentQdelay(uint64_t& qdelay) const;
 
     /**
-     * Calculate current round trip time (rtt)
+     * Calculate current round trip time (rtt), as the minimum of the
+     * round trip time of the last few packets (see #setMinFilterTaps )
      *
      * @param [out] rtt Round trip time during current history length
      * @retval False if the current history is empty (output parameter is not
@@ -296,6 +425,20 @@ protected:
      */
     bool getCurrentRTT(uint64_t& rtt) const;
 
+    /**
+     * Calculate the maximum queuing delay among all packets in the current
+     * history. The maximum one way delay is tracked incrementally as packets
+     * enter and leave the history, and the queuing delay is derived from it
+     * with the current base delay, so this call is O(1) and stays correct
+     * when the base delay changes
+     *
+     * @param [out] qdelayMax Maximum queuing delay during current history
+     *                        length
+     * @retval False if the current history is empty (output parameter is not
+     *         valid). True otherwise
+     */
+    bool getMaxQdelay(uint64_t& qdelayMax) const;
+
     /**
      * Calculate current info on packet losses
      *
@@ -308,6 +451,19 @@ protected:
      */
     bool getPktLossInfo(uint32_t& nLoss, float& plr) const;
 
+    /**
+     * Calculate current info on ECN congestion marks
+     *
+     * @param [out] nMarked Number of packets received with the CE codepoint
+     *                      during current history length
+     * @param [out] pmr Marking ratio (marks per packet received) for the
+     *                  current history length
+     * @retval False if the current history does not contain enough packets to
+     *         calculate the metrics (output parameter is not valid). True
+     *         otherwise
+     */
+    bool getPktMarkingInfo(uint32_t& nMarked, float& pmr) const;
+
     /**
      * Calculate current rate at which the receiver is receiving the media
      * packets (receive rate), in bits per second
@@ -343,20 +499,24 @@ protected:
      */
     uint64_t m_baseDelay;
     /**
-     * Sent packets for which feedback has not been received yet
+     * Sent packets not moved to #m_packetHistory yet: either feedback has
+     * not been received, or it has but some earlier packets are still
+     * within the reorder window (see #setReorderWindow )
      */
-    std::deque<PacketRecord> m_inTransitPackets;
+    InTransitTable m_inTransitPackets;
     /**
      * Packets for which feedback has already been received. Information
      * contained in these records will be used to calculate the different
      * metrics that congestion controllers use
      */
-    std::deque<PacketRecord> m_packetHistory;
+    PacketRing m_packetHistory;
     /**
      * Maintains the sum of the size of all packets in #m_packetHistory .
      * This is done for efficiency reasons
      */
     uint32_t m_pktSizeSum;
+    /** Number of packets in #m_packetHistory received with the CE codepoint */
+    uint32_t m_pktMarkedSum;
 
     std::string m_id; /**< Id used for logging, and can be used for plotting */
 
@@ -365,13 +525,40 @@ protected:
     float m_maxBw;
 
     logCallback m_logCallback;
+    logEnabledCallback m_logEnabledCallback;
+    std::shared_ptr<StatsSink> m_statsSink;
 
     InterLossState m_ilState;
 
+    /** Mutable, as metric getters count failed queries */
+    mutable ControllerEventCounters m_events;
+
 private:
-    uint64_t m_historyLengthMs; // in ms
+    uint64_t m_historyLength; // in us
+
+    /** Number of packets ever appended to #m_packetHistory */
+    uint64_t m_historyPushCount;
+    size_t m_minFilterTaps; /**< number of taps of the minimum filters */
+    size_t m_reorderWindow; /**< reordering tolerated, in packets */
+    uint32_t m_highestAcked; /**< highest sequence feedback was received for */
+    bool m_highestAckedValid; /**< whether #m_highestAcked is meaningful */
+    /** Minimum one way delay over the last #m_minFilterTaps packets */
+    MonotonicWindow<WrapLess> m_owdMinFilter;
+    /** Minimum round trip time over the last #m_minFilterTaps packets */
+    MonotonicWindow<WrapLess> m_rttMinFilter;
+    /** Maximum one way delay over the whole #m_packetHistory */
+    MonotonicWindow<WrapGreater> m_owdMaxFilter;
 
     void setDefaultId();
+    void dimensionPacketRings();
+    bool ingestFeedback(uint64_t now,
+                        uint32_t sequence,
+                        uint64_t rxTimestamp,
+                        uint8_t ecn);
+    bool releaseSettledPackets();
+    bool appendToHistory(const PacketRecord& packet);
+    void garbageCollectHistory();
+    void updateDelayFilters();
     void updateInterLossData(const PacketRecord& packet);
 };
 
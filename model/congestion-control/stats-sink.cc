@@ -0,0 +1,281 @@
+/******************************************************************************
+ * Copyright 2016-2017 Cisco Systems, Inc.                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ *                                                                            *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+/**
+ * @file
+ * Statistics sinks implementation.
+ *
+ * @version 0.1.0
+ * @author Jiantao Fu
+ * @author Sergio Mena
+ * @author Xiaoqing Zhu
+ */
+#include "stats-sink.h"
+#include "sender-based-controller.h"
+#include <iostream>
+#include <sstream>
+#include <algorithm>
+#include <cstring>
+#include <cassert>
+
+namespace rmcat {
+
+static const char STATS_MAGIC[4] = {'R', 'M', 'S', 'T'};
+const uint8_t STATS_VERSION = 2;
+const size_t STATS_BUFFER_SIZE = 1 << 16; /**< bytes written at once */
+const size_t STATS_MAX_FLOWS = 0xffff;
+
+std::string formatStatsRecord(const StatsRecord& record) {
+    std::ostringstream os;
+    os << std::fixed;
+    os.precision(RMCAT_LOG_PRINT_PRECISION);
+
+    os << " algo:" << record.algo << " " << record.id
+       << " ts: "     << record.ts / RMCAT_US_PER_MS
+       << " loglen: " << record.loglen
+       << " qdel: "   << record.qdel / RMCAT_US_PER_MS;
+    if (record.fields & STATS_FIELD_RTT) {
+        os << " rtt: " << record.rtt / RMCAT_US_PER_MS;
+    }
+    os << " ploss: " << record.ploss
+       << " plr: "   << record.plr;
+    if (record.fields & STATS_FIELD_XCURR) {
+        os << " xcurr: " << record.xcurr;
+    }
+    os << " rrate: " << record.rrate
+       << " srate: " << record.srate;
+    if (record.fields & STATS_FIELD_LOSS_INTERVAL) {
+        os << " avgint: " << record.avgint
+           << " curint: " << record.curint;
+    }
+    return os.str();
+}
+
+/*
+ * Index of the flow a record belongs to, or algos.size() if it is new.
+ * Flows are few, a linear search does not allocate any string
+ */
+static size_t findFlow(const std::vector<std::string>& algos,
+                       const std::vector<std::string>& ids,
+                       const StatsRecord& record) {
+    assert(algos.size() == ids.size());
+    for (size_t i = 0; i < ids.size(); ++i) {
+        if (ids[i] == record.id && algos[i] == record.algo) {
+            return i;
+        }
+    }
+    return ids.size();
+}
+
+StatsSink::~StatsSink() {}
+
+TextStatsSink::TextStatsSink(lineCallback f)
+: m_callback{f} {}
+
+TextStatsSink::~TextStatsSink() {}
+
+void TextStatsSink::write(const StatsRecord& record) {
+    const std::string line = formatStatsRecord(record);
+    if (m_callback != NULL) {
+        m_callback(line);
+    } else {
+        std::cout << line << std::endl;
+    }
+}
+
+ColumnarStatsSink::ColumnarStatsSink() {}
+
+ColumnarStatsSink::~ColumnarStatsSink() {}
+
+void ColumnarStatsSink::write(const StatsRecord& record) {
+    size_t index = findFlow(algos, ids, record);
+    if (index == ids.size()) {
+        assert(index < STATS_MAX_FLOWS);
+        algos.push_back(record.algo);
+        ids.push_back(record.id);
+    }
+    flow.push_back(uint16_t(index));
+    fields.push_back(record.fields);
+    ts.push_back(record.ts);
+    loglen.push_back(record.loglen);
+    qdel.push_back(record.qdel);
+    rtt.push_back(record.rtt);
+    ploss.push_back(record.ploss);
+    plr.push_back(record.plr);
+    xcurr.push_back(record.xcurr);
+    rrate.push_back(record.rrate);
+    srate.push_back(record.srate);
+    avgint.push_back(record.avgint);
+    curint.push_back(record.curint);
+}
+
+void ColumnarStatsSink::reserve(size_t n) {
+    flow.reserve(n);
+    fields.reserve(n);
+    ts.reserve(n);
+    loglen.reserve(n);
+    qdel.reserve(n);
+    rtt.reserve(n);
+    ploss.reserve(n);
+    plr.reserve(n);
+    xcurr.reserve(n);
+    rrate.reserve(n);
+    srate.reserve(n);
+    avgint.reserve(n);
+    curint.reserve(n);
+}
+
+size_t ColumnarStatsSink::size() const {
+    return ts.size();
+}
+
+void ColumnarStatsSink::clear() {
+    algos.clear();
+    ids.clear();
+    flow.clear();
+    fields.clear();
+    ts.clear();
+    loglen.clear();
+    qdel.clear();
+    rtt.clear();
+    ploss.clear();
+    plr.clear();
+    xcurr.clear();
+    rrate.clear();
+    srate.clear();
+    avgint.clear();
+    curint.clear();
+}
+
+/* Little-endian serialization helpers */
+static void putU8(std::vector<uint8_t>& buf, uint8_t value) {
+    buf.push_back(value);
+}
+
+static void putU16(std::vector<uint8_t>& buf, uint16_t value) {
+    buf.push_back(uint8_t(value));
+    buf.push_back(uint8_t(value >> 8));
+}
+
+static void putU32(std::vector<uint8_t>& buf, uint32_t value) {
+    for (unsigned i = 0; i < 4; ++i) {
+        buf.push_back(uint8_t(value >> (8 * i)));
+    }
+}
+
+static void putU64(std::vector<uint8_t>& buf, uint64_t value) {
+    for (unsigned i = 0; i < 8; ++i) {
+        buf.push_back(uint8_t(value >> (8 * i)));
+    }
+}
+
+static void putF32(std::vector<uint8_t>& buf, float value) {
+    uint32_t bits;
+    static_assert(sizeof(bits) == sizeof(value), "float must be 32 bits long");
+    std::memcpy(&bits, &value, sizeof(bits));
+    putU32(buf, bits);
+}
+
+static void putString(std::vector<uint8_t>& buf, const std::string& str) {
+    const size_t len = std::min<size_t>(str.size(), 0xff);
+    putU8(buf, uint8_t(len));
+    buf.insert(buf.end(), str.begin(), str.begin() + len);
+}
+
+BinaryStatsSink::BinaryStatsSink()
+: m_file{NULL},
+  m_buffer{},
+  m_algos{},
+  m_ids{} {}
+
+BinaryStatsSink::~BinaryStatsSink() {
+    close();
+}
+
+bool BinaryStatsSink::open(const std::string& path) {
+    close();
+    m_file = std::fopen(path.c_str(), "wb");
+    if (m_file == NULL) {
+        return false;
+    }
+    m_algos.clear();
+    m_ids.clear();
+    m_buffer.reserve(STATS_BUFFER_SIZE + 2 * 0x100 + 8);
+    m_buffer.insert(m_buffer.end(), STATS_MAGIC, STATS_MAGIC + sizeof(STATS_MAGIC));
+    putU8(m_buffer, STATS_VERSION);
+    return true;
+}
+
+bool BinaryStatsSink::isOpen() const {
+    return m_file != NULL;
+}
+
+void BinaryStatsSink::close() {
+    if (m_file == NULL) {
+        return;
+    }
+    flush();
+    std::fclose(m_file);
+    m_file = NULL;
+}
+
+uint16_t BinaryStatsSink::flowIndex(const StatsRecord& record) {
+    const size_t index = findFlow(m_algos, m_ids, record);
+    if (index == m_ids.size()) {
+        assert(index < STATS_MAX_FLOWS);
+        m_algos.push_back(record.algo);
+        m_ids.push_back(record.id);
+        putU8(m_buffer, 'F');
+        putU16(m_buffer, uint16_t(index));
+        putString(m_buffer, m_algos.back());
+        putString(m_buffer, m_ids.back());
+    }
+    return uint16_t(index);
+}
+
+void BinaryStatsSink::write(const StatsRecord& record) {
+    if (m_file == NULL) {
+        return;
+    }
+    const uint16_t index = flowIndex(record);
+    putU8(m_buffer, 'R');
+    putU16(m_buffer, index);
+    putU32(m_buffer, record.fields);
+    putU64(m_buffer, record.ts);
+    putU64(m_buffer, record.loglen);
+    putU64(m_buffer, record.qdel);
+    putU64(m_buffer, record.rtt);
+    putU32(m_buffer, record.ploss);
+    putF32(m_buffer, record.plr);
+    putF32(m_buffer, record.xcurr);
+    putF32(m_buffer, record.rrate);
+    putF32(m_buffer, record.srate);
+    putF32(m_buffer, record.avgint);
+    putU32(m_buffer, record.curint);
+    if (m_buffer.size() >= STATS_BUFFER_SIZE) {
+        flush();
+    }
+}
+
+void BinaryStatsSink::flush() {
+    if (!m_buffer.empty()) {
+        std::fwrite(m_buffer.data(), 1, m_buffer.size(), m_file);
+        m_buffer.clear();
+    }
+}
+
+}
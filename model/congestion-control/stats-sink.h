@@ -0,0 +1,202 @@
+/******************************************************************************
+ * Copyright 2016-2017 Cisco Systems, Inc.                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ *                                                                            *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+/**
+ * @file
+ * Typed statistics records periodically reported by congestion controllers,
+ * and the sinks they can be sent to.
+ *
+ * @version 0.1.0
+ * @author Jiantao Fu
+ * @author Sergio Mena
+ * @author Xiaoqing Zhu
+ */
+
+#ifndef STATS_SINK_H
+#define STATS_SINK_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace rmcat {
+
+/** Bits of #StatsRecord::fields , telling which optional fields are valid */
+enum StatsField {
+    STATS_FIELD_RTT = 0x01,         /**< rtt */
+    STATS_FIELD_XCURR = 0x02,       /**< xcurr */
+    STATS_FIELD_LOSS_INTERVAL = 0x04, /**< avgint and curint */
+};
+
+/**
+ * Metrics a controller reports at each rate update. Fields not covered by
+ * #fields are always valid; the others depend on the algorithm
+ */
+struct StatsRecord {
+    const char* algo;   /**< algorithm name, e.g., "nada" */
+    const char* id;     /**< controller id, see #SenderBasedController::setId */
+    uint32_t fields;    /**< valid optional fields, see #StatsField */
+    uint64_t ts;        /**< time of the update, in us */
+    uint64_t loglen;    /**< number of packets in the history */
+    uint64_t qdel;      /**< queuing delay, in us */
+    uint64_t rtt;       /**< round trip time, in us */
+    uint32_t ploss;     /**< packets lost in the history */
+    float plr;          /**< packet loss ratio in the history */
+    float xcurr;        /**< aggregate congestion signal, in ms */
+    float rrate;        /**< receive rate, in bps */
+    float srate;        /**< sending (target) rate, in bps */
+    float avgint;       /**< average inter-loss interval, in packets */
+    uint32_t curint;    /**< current inter-loss interval, in packets */
+};
+
+/**
+ * Format a record as the text line controllers have always logged, e.g.,
+ * " algo:nada <id> ts: 1200 loglen: 60 qdel: 12 rtt: 112 ploss: 0 ..."
+ * (as expected by tools/process_test_logs.py). ts, qdel and rtt are
+ * printed in whole ms
+ */
+std::string formatStatsRecord(const StatsRecord& record);
+
+/**
+ * Destination of the statistics records reported by controllers
+ * (see #SenderBasedController::setStatsSink ). A sink can be shared by
+ * several controllers
+ */
+class StatsSink {
+public:
+    virtual ~StatsSink();
+
+    /**
+     * Consume a record. The strings the record points to are only
+     * valid during the call
+     */
+    virtual void write(const StatsRecord& record) = 0;
+};
+
+/** Sink passing records, formatted as legacy text lines, to a callback */
+class TextStatsSink: public StatsSink {
+public:
+    typedef void (*lineCallback) (const std::string&);
+
+    /**
+     * Class constructor
+     *
+     * @param [in] f Function receiving each line; if NULL, lines are
+     *               printed to stdout
+     */
+    explicit TextStatsSink(lineCallback f);
+    virtual ~TextStatsSink();
+
+    virtual void write(const StatsRecord& record);
+
+private:
+    lineCallback m_callback;
+};
+
+/**
+ * Sink keeping records in memory, one vector per field. Nothing is
+ * allocated per record once enough room has been reserved
+ */
+class ColumnarStatsSink: public StatsSink {
+public:
+    ColumnarStatsSink();
+    virtual ~ColumnarStatsSink();
+
+    virtual void write(const StatsRecord& record);
+
+    /** Make room for n records */
+    void reserve(size_t n);
+
+    /** Number of records stored */
+    size_t size() const;
+
+    /** Remove all records */
+    void clear();
+
+    /* Algorithm and controller id of each flow, indexed by #flow */
+    std::vector<std::string> algos;
+    std::vector<std::string> ids;
+
+    std::vector<uint16_t> flow; /**< flow index of each record */
+    std::vector<uint32_t> fields;
+    std::vector<uint64_t> ts;
+    std::vector<uint64_t> loglen;
+    std::vector<uint64_t> qdel;
+    std::vector<uint64_t> rtt;
+    std::vector<uint32_t> ploss;
+    std::vector<float> plr;
+    std::vector<float> xcurr;
+    std::vector<float> rrate;
+    std::vector<float> srate;
+    std::vector<float> avgint;
+    std::vector<uint32_t> curint;
+};
+
+/**
+ * Sink writing records to a binary file, in little-endian byte order.
+ *
+ * The file starts with the magic string "RMST" and a version byte,
+ * followed by entries starting with a type byte:
+ *  - 'F' (flow): uint16 flow index, then the algorithm name and the
+ *    controller id, each as a uint8 length and the characters. Written
+ *    before the first record of a flow
+ *  - 'R' (record): uint16 flow index, uint32 fields, uint64 ts, loglen,
+ *    qdel and rtt, uint32 ploss, float32 plr, xcurr, rrate, srate and
+ *    avgint, uint32 curint (67 bytes in total). Times are in us
+ *
+ * tools/process_test_logs.py reads these files
+ */
+class BinaryStatsSink: public StatsSink {
+public:
+    BinaryStatsSink();
+
+    /** Class destructor: closes the file if it is open */
+    virtual ~BinaryStatsSink();
+
+    /**
+     * Create (or truncate) a stats file and write its header
+     *
+     * @param [in] path Name of the file
+     * @retval true if the file could be opened, false otherwise
+     */
+    bool open(const std::string& path);
+
+    /** Whether a file is open */
+    bool isOpen() const;
+
+    /** Flush buffered records and close the file */
+    void close();
+
+    virtual void write(const StatsRecord& record);
+
+private:
+    BinaryStatsSink(const BinaryStatsSink&);
+    BinaryStatsSink& operator=(const BinaryStatsSink&);
+
+    uint16_t flowIndex(const StatsRecord& record);
+    void flush();
+
+    std::FILE* m_file;
+    std::vector<uint8_t> m_buffer;
+    std::vector<std::string> m_algos; /**< algorithm, per flow index */
+    std::vector<std::string> m_ids;   /**< controller id, per flow index */
+};
+
+}
+
+#endif /* STATS_SINK_H */
@@ -0,0 +1,137 @@
+/******************************************************************************
+ * Copyright 2016-2017 Cisco Systems, Inc.                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ *                                                                            *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+/**
+ * @file
+ * Point-to-point channel with delay jitter, implementation for rmcat ns3 module.
+ *
+ * @version 0.1.0
+ * @author Jiantao Fu
+ * @author Sergio Mena
+ * @author Xiaoqing Zhu
+ */
+
+#include "jitter-channel.h"
+#include "ns3/point-to-point-net-device.h"
+#include "ns3/simulator.h"
+#include "ns3/node.h"
+#include "ns3/pointer.h"
+#include "ns3/string.h"
+#include "ns3/boolean.h"
+#include "ns3/log.h"
+#include "ns3/abort.h"
+
+#include <fstream>
+#include <algorithm>
+
+NS_LOG_COMPONENT_DEFINE ("JitterChannel");
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED (JitterChannel);
+
+TypeId JitterChannel::GetTypeId (void)
+{
+    static TypeId tid = TypeId ("ns3::JitterChannel")
+      .SetParent<PointToPointChannel> ()
+      .AddConstructor<JitterChannel> ()
+      .AddAttribute ("Jitter",
+                     "Random variable giving each packet's extra delay, in ms",
+                     PointerValue (),
+                     MakePointerAccessor (&JitterChannel::m_jitter),
+                     MakePointerChecker<RandomVariableStream> ())
+      .AddAttribute ("JitterTrace",
+                     "File with one extra delay, in ms, per line; used instead of Jitter if set",
+                     StringValue (""),
+                     MakeStringAccessor (&JitterChannel::m_jitterTraceFile),
+                     MakeStringChecker ())
+      .AddAttribute ("Reorder",
+                     "Whether packets may overtake those sent earlier",
+                     BooleanValue (false),
+                     MakeBooleanAccessor (&JitterChannel::m_reorder),
+                     MakeBooleanChecker ())
+    ;
+    return tid;
+}
+
+JitterChannel::JitterChannel ()
+: PointToPointChannel ()
+, m_jitter{}
+, m_jitterTraceFile{}
+, m_reorder{false}
+, m_jitterTrace{}
+, m_jitterTracePos{0}
+, m_jitterTraceRead{false}
+, m_lastArrival{}
+{}
+
+JitterChannel::~JitterChannel () {}
+
+bool JitterChannel::TransmitStart (Ptr<const Packet> p,
+                                   Ptr<PointToPointNetDevice> src,
+                                   Time txTime)
+{
+    NS_ASSERT (GetNDevices () == 2);
+    const uint32_t wire = (src == GetPointToPointDevice (0)) ? 0 : 1;
+    Ptr<PointToPointNetDevice> dst = GetPointToPointDevice (1 - wire);
+
+    const auto now = Simulator::Now ();
+    auto arrival = now + txTime + GetDelay () + NextJitter ();
+    if (!m_reorder) {
+        // FIFO: not before the previous packet sent this way
+        arrival = std::max (arrival, m_lastArrival[wire]);
+        m_lastArrival[wire] = arrival;
+    }
+
+    Simulator::ScheduleWithContext (dst->GetNode ()->GetId (), arrival - now,
+                                    &PointToPointNetDevice::Receive, dst, p->Copy ());
+    return true;
+}
+
+Time JitterChannel::NextJitter ()
+{
+    if (!m_jitterTraceFile.empty ()) {
+        if (!m_jitterTraceRead) {
+            ReadJitterTrace ();
+        }
+        const auto jitter = m_jitterTrace[m_jitterTracePos];
+        m_jitterTracePos = (m_jitterTracePos + 1) % m_jitterTrace.size ();
+        return jitter;
+    }
+    if (m_jitter) {
+        // Negative values (e.g., from a normal distribution) add no delay
+        return MicroSeconds (std::max<int64_t> (0, m_jitter->GetValue () * 1000.));
+    }
+    return Time{0};
+}
+
+void JitterChannel::ReadJitterTrace ()
+{
+    std::ifstream trace{m_jitterTraceFile.c_str ()};
+    NS_ABORT_MSG_UNLESS (trace.is_open (), "Cannot open jitter trace " << m_jitterTraceFile);
+    double ms = 0.;
+    while (trace >> ms) {
+        NS_ABORT_MSG_IF (ms < 0., "Negative jitter in trace " << m_jitterTraceFile);
+        m_jitterTrace.push_back (MicroSeconds (int64_t (ms * 1000.)));
+    }
+    NS_ABORT_MSG_IF (m_jitterTrace.empty (), "No jitter values in trace " << m_jitterTraceFile);
+    m_jitterTraceRead = true;
+    NS_LOG_INFO ("JitterChannel::ReadJitterTrace, " << m_jitterTrace.size ()
+                 << " values from " << m_jitterTraceFile);
+}
+
+}
@@ -0,0 +1,83 @@
+/******************************************************************************
+ * Copyright 2016-2017 Cisco Systems, Inc.                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ *                                                                            *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+/**
+ * @file
+ * Point-to-point channel with delay jitter, interface for rmcat ns3 module.
+ *
+ * @version 0.1.0
+ * @author Jiantao Fu
+ * @author Sergio Mena
+ * @author Xiaoqing Zhu
+ */
+
+#ifndef JITTER_CHANNEL_H
+#define JITTER_CHANNEL_H
+
+#include "ns3/point-to-point-channel.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/nstime.h"
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * Point-to-point channel adding a random extra delay (jitter) to the
+ * propagation delay of each packet. The jitter is drawn, in ms, either
+ * from a random variable (e.g., uniform or Pareto), or from a trace: a
+ * text file with one jitter value, in ms, per line, used in a loop.
+ *
+ * By default, a packet never arrives before one sent earlier in the same
+ * direction: it is held back until the previous one arrived, as on a
+ * link whose jitter comes from variable processing or queuing along the
+ * path. With reordering allowed, each packet gets its own delay, as when
+ * packets take different paths.
+ *
+ * Per packet, the cost is that of drawing the jitter: the trace is read
+ * into memory once, before the first packet is sent.
+ */
+class JitterChannel : public PointToPointChannel
+{
+public:
+    static TypeId GetTypeId (void);
+
+    JitterChannel ();
+    virtual ~JitterChannel ();
+
+    virtual bool TransmitStart (Ptr<const Packet> p,
+                                Ptr<PointToPointNetDevice> src,
+                                Time txTime);
+
+private:
+    Time NextJitter ();
+    void ReadJitterTrace ();
+
+    /* Attributes */
+    Ptr<RandomVariableStream> m_jitter;
+    std::string m_jitterTraceFile;
+    bool m_reorder;
+
+    std::vector<Time> m_jitterTrace;
+    size_t m_jitterTracePos;
+    bool m_jitterTraceRead;
+    Time m_lastArrival[2]; // indexed by sending device
+};
+
+}
+
+#endif /* JITTER_CHANNEL_H */
@@ -0,0 +1,193 @@
+/******************************************************************************
+ * Copyright 2016-2017 Cisco Systems, Inc.                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ *                                                                            *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+/**
+ * @file
+ * ECN-marking RED queue disc implementation for rmcat ns3 module.
+ *
+ * @version 0.1.0
+ * @author Jiantao Fu
+ * @author Sergio Mena
+ * @author Xiaoqing Zhu
+ */
+
+#include "red-ecn-queue-disc.h"
+#include "ns3/ipv4-queue-disc-item.h"
+#include "ns3/uinteger.h"
+#include "ns3/double.h"
+#include "ns3/log.h"
+
+NS_LOG_COMPONENT_DEFINE ("RedEcnQueueDisc");
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED (RedEcnQueueDisc);
+
+TypeId RedEcnQueueDisc::GetTypeId (void)
+{
+    static TypeId tid = TypeId ("ns3::RedEcnQueueDisc")
+      .SetParent<QueueDisc> ()
+      .AddConstructor<RedEcnQueueDisc> ()
+      .AddAttribute ("MaxBytes",
+                     "Capacity of the queue, in bytes",
+                     UintegerValue (100 * 1500),
+                     MakeUintegerAccessor (&RedEcnQueueDisc::m_maxBytes),
+                     MakeUintegerChecker<uint32_t> ())
+      .AddAttribute ("MinTh",
+                     "Average queue (in bytes) above which packets may be marked",
+                     UintegerValue (5 * 1500),
+                     MakeUintegerAccessor (&RedEcnQueueDisc::m_minTh),
+                     MakeUintegerChecker<uint32_t> ())
+      .AddAttribute ("MaxTh",
+                     "Average queue (in bytes) above which all packets are marked",
+                     UintegerValue (15 * 1500),
+                     MakeUintegerAccessor (&RedEcnQueueDisc::m_maxTh),
+                     MakeUintegerChecker<uint32_t> ())
+      .AddAttribute ("MaxP",
+                     "Marking probability at MaxTh",
+                     DoubleValue (0.1),
+                     MakeDoubleAccessor (&RedEcnQueueDisc::m_maxP),
+                     MakeDoubleChecker<double> (0., 1.))
+      .AddAttribute ("QueueWeight",
+                     "Weight of the current queue in its moving average",
+                     DoubleValue (0.002),
+                     MakeDoubleAccessor (&RedEcnQueueDisc::m_weight),
+                     MakeDoubleChecker<double> (0., 1.))
+    ;
+    return tid;
+}
+
+RedEcnQueueDisc::RedEcnQueueDisc ()
+: QueueDisc ()
+, m_maxBytes{0}
+, m_minTh{0}
+, m_maxTh{0}
+, m_maxP{0.}
+, m_weight{0.}
+, m_queue{}
+, m_bytes{0}
+, m_avgBytes{0.}
+, m_marks{0}
+, m_uniform{CreateObject<UniformRandomVariable> ()}
+{}
+
+RedEcnQueueDisc::~RedEcnQueueDisc () {}
+
+uint32_t RedEcnQueueDisc::GetMarks () const
+{
+    return m_marks;
+}
+
+bool RedEcnQueueDisc::DoEnqueue (Ptr<QueueDiscItem> item)
+{
+    const auto size = item->GetPacketSize ();
+    m_avgBytes += m_weight * (double (m_bytes) - m_avgBytes);
+    if (m_bytes + size > m_maxBytes) {
+        NS_LOG_INFO ("RedEcnQueueDisc::DoEnqueue, queue full, dropping packet of "
+                     << size << " bytes");
+        Drop (item);
+        return false;
+    }
+    if (IsCongested () && !Mark (item)) {
+        NS_LOG_INFO ("RedEcnQueueDisc::DoEnqueue, cannot mark, dropping packet of "
+                     << size << " bytes");
+        Drop (item);
+        return false;
+    }
+    m_queue.push_back (item);
+    m_bytes += size;
+    return true;
+}
+
+Ptr<QueueDiscItem> RedEcnQueueDisc::DoDequeue (void)
+{
+    if (m_queue.empty ()) {
+        return 0;
+    }
+    auto item = m_queue.front ();
+    m_queue.pop_front ();
+    NS_ASSERT (m_bytes >= item->GetPacketSize ());
+    m_bytes -= item->GetPacketSize ();
+    return item;
+}
+
+Ptr<const QueueDiscItem> RedEcnQueueDisc::DoPeek (void) const
+{
+    if (m_queue.empty ()) {
+        return 0;
+    }
+    return m_queue.front ();
+}
+
+bool RedEcnQueueDisc::CheckConfig (void)
+{
+    if (GetNQueueDiscClasses () > 0 || GetNPacketFilters () > 0 || GetNInternalQueues () > 0) {
+        NS_LOG_ERROR ("RedEcnQueueDisc needs no classes, filters or internal queues");
+        return false;
+    }
+    if (m_minTh >= m_maxTh) {
+        NS_LOG_ERROR ("RedEcnQueueDisc needs MinTh < MaxTh");
+        return false;
+    }
+    return true;
+}
+
+void RedEcnQueueDisc::InitializeParams (void)
+{
+    m_avgBytes = 0.;
+    m_marks = 0;
+}
+
+void RedEcnQueueDisc::DoDispose (void)
+{
+    m_queue.clear ();
+    m_bytes = 0;
+    m_uniform = 0;
+    QueueDisc::DoDispose ();
+}
+
+bool RedEcnQueueDisc::IsCongested ()
+{
+    if (m_avgBytes < m_minTh) {
+        return false;
+    }
+    if (m_avgBytes >= m_maxTh) {
+        return true;
+    }
+    const double p = m_maxP * (m_avgBytes - m_minTh) / (m_maxTh - m_minTh);
+    return m_uniform->GetValue () < p;
+}
+
+bool RedEcnQueueDisc::Mark (Ptr<QueueDiscItem> item)
+{
+    auto ipv4Item = DynamicCast<Ipv4QueueDiscItem> (item);
+    if (!ipv4Item) {
+        return false;
+    }
+    // ns-3.26's queue disc items cannot mark their packet: the IPv4
+    // header, only added to the packet when it leaves the queue disc, is
+    // changed in place
+    auto& header = const_cast<Ipv4Header&> (ipv4Item->GetHeader ());
+    if (header.GetEcn () == Ipv4Header::ECN_NotECT) {
+        return false;
+    }
+    header.SetEcn (Ipv4Header::ECN_CE);
+    ++m_marks;
+    return true;
+}
+
+}
@@ -0,0 +1,91 @@
+/******************************************************************************
+ * Copyright 2016-2017 Cisco Systems, Inc.                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ *                                                                            *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+/**
+ * @file
+ * ECN-marking RED queue disc declaration for rmcat ns3 module.
+ *
+ * @version 0.1.0
+ * @author Jiantao Fu
+ * @author Sergio Mena
+ * @author Xiaoqing Zhu
+ */
+
+#ifndef RED_ECN_QUEUE_DISC_H
+#define RED_ECN_QUEUE_DISC_H
+
+#include "ns3/queue-disc.h"
+#include "ns3/random-variable-stream.h"
+
+#include <deque>
+
+namespace ns3 {
+
+/**
+ * Byte-limited FIFO queue disc signaling congestion as RED does, but
+ * marking ECN-capable packets (ECT(0) or ECT(1)) with CE rather than
+ * dropping them. The RedQueueDisc of ns-3.26, the release this module
+ * targets, has no ECN support.
+ *
+ * At each enqueue, the average queue (an exponentially weighted moving
+ * average, in bytes) is updated. Below "MinTh", packets are let through;
+ * between "MinTh" and "MaxTh", they are marked with a probability rising
+ * linearly from 0 to "MaxP"; above "MaxTh", they are all marked. Packets
+ * that cannot be marked (not ECN-capable, or not IPv4) are dropped
+ * instead, as are packets that do not fit in "MaxBytes".
+ *
+ * Written against the ns-3.26 QueueDisc API, as #TraceDrivenQueueDisc .
+ */
+class RedEcnQueueDisc : public QueueDisc
+{
+public:
+    static TypeId GetTypeId (void);
+
+    RedEcnQueueDisc ();
+    virtual ~RedEcnQueueDisc ();
+
+    /** Number of packets marked CE so far */
+    uint32_t GetMarks () const;
+
+private:
+    virtual bool DoEnqueue (Ptr<QueueDiscItem> item);
+    virtual Ptr<QueueDiscItem> DoDequeue (void);
+    virtual Ptr<const QueueDiscItem> DoPeek (void) const;
+    virtual bool CheckConfig (void);
+    virtual void InitializeParams (void);
+    virtual void DoDispose (void);
+
+    bool IsCongested ();
+    bool Mark (Ptr<QueueDiscItem> item);
+
+    /* Attributes */
+    uint32_t m_maxBytes;
+    uint32_t m_minTh;           // in bytes
+    uint32_t m_maxTh;           // in bytes
+    double m_maxP;
+    double m_weight;            // of the last queue size in the average
+
+    std::deque<Ptr<QueueDiscItem> > m_queue;
+    uint32_t m_bytes;           // in m_queue
+    double m_avgBytes;
+    uint32_t m_marks;
+    Ptr<UniformRandomVariable> m_uniform;
+};
+
+}
+
+#endif /* RED_ECN_QUEUE_DISC_H */
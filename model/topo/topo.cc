@@ -101,6 +101,20 @@ static void PacketSinkLogging (const std::string& nameAndId,
 }
 
 
+Topo::Topo ()
+: m_rtpHeader{false}
+{}
+
+void Topo::SetRtpHeader (bool enable)
+{
+    m_rtpHeader = enable;
+}
+
+uint32_t Topo::GetMediaPacketOverhead () const
+{
+    return m_rtpHeader ? IPV4_UDP_RTP_OVERHEAD : IPV4_UDP_MEDIA_OVERHEAD;
+}
+
 /*
  * Implementations of:
  * -- InstallTCP
@@ -175,29 +189,38 @@ ApplicationContainer Topo::InstallCBR (Ptr<Node> sender,
 ApplicationContainer Topo::InstallRMCAT (const std::string& flowId,
                                          Ptr<Node> sender,
                                          Ptr<Node> receiver,
-                                         uint16_t serverPort)
+                                         uint16_t serverPort,
+                                         Ptr<Application> sharedReceiver) const
 {
 
     auto rmcatAppSend = CreateObject<RmcatSender> ();
-    auto rmcatAppRecv = CreateObject<RmcatReceiver> ();
     sender->AddApplication (rmcatAppSend);
-    receiver->AddApplication (rmcatAppRecv);
 
     Ipv4Address serverIP = GetIpv4AddressOfNode (receiver, 1, 0);
     rmcatAppSend->Setup (serverIP, serverPort);
+    rmcatAppSend->SetRtpHeader (m_rtpHeader);
 
     /* configure congestion controller */
     auto controller = std::make_shared<rmcat::NadaController> ();
-    controller->setLogCallback (logFromController);
+    controller->setLogCallback (logFromController, logFromControllerEnabled);
     controller->setId (flowId);
     rmcatAppSend->SetController (controller);
 
     rmcatAppSend->SetStartTime (Seconds (0));
     rmcatAppSend->SetStopTime (Seconds (T_MAX_S));
 
-    rmcatAppRecv->Setup (serverPort);
-    rmcatAppRecv->SetStartTime (Seconds (0));
-    rmcatAppRecv->SetStopTime (Seconds (T_MAX_S));
+    auto rmcatAppRecv = DynamicCast<RmcatReceiver> (sharedReceiver);
+    if (sharedReceiver) {
+        NS_ASSERT (rmcatAppRecv);
+        NS_ASSERT (rmcatAppRecv->GetNode () == receiver);
+    } else {
+        rmcatAppRecv = CreateObject<RmcatReceiver> ();
+        receiver->AddApplication (rmcatAppRecv);
+        rmcatAppRecv->Setup (serverPort);
+        rmcatAppRecv->SetRtpHeader (m_rtpHeader);
+        rmcatAppRecv->SetStartTime (Seconds (0));
+        rmcatAppRecv->SetStopTime (Seconds (T_MAX_S));
+    }
 
     ApplicationContainer apps;
     apps.Add (rmcatAppSend);
@@ -209,4 +232,13 @@ void Topo::logFromController (const std::string& msg) {
     NS_LOG_INFO ("controller_log: " << msg);
 }
 
+bool Topo::logFromControllerEnabled () {
+    // Same condition as NS_LOG_INFO in logFromController
+#ifdef NS3_LOG_ENABLE
+    return g_log.IsEnabled (LOG_INFO);
+#else
+    return false;
+#endif
+}
+
 }
@@ -47,7 +47,27 @@ namespace ns3 {
 
 class Topo
 {
+public:
+    /** Class constructor */
+    Topo ();
+
+    /**
+     * Have the rmcat flows installed from now on send RTP media headers
+     * rather than #MediaHeader (default: off); see
+     * #RmcatSender::SetRtpHeader . Must be called before building the
+     * topology, whose queues must fit a full-size media packet
+     *
+     * @param [in] enable Whether RTP media headers are to be used
+     */
+    void SetRtpHeader (bool enable);
+
 protected:
+    /**
+     * Bytes added by IP, UDP and the media header in use to each media
+     * packet of the rmcat flows (see #SetRtpHeader )
+     */
+    uint32_t GetMediaPacketOverhead () const;
+
     /**
      * Install two applications (sender and receiver) implementing a TCP flow.
      * The sender of application data (resp. receiver) will be installed at the
@@ -111,22 +131,32 @@ protected:
      *                          application
      * @param [in]     serverPort UDP port where the receiver application is
      *                            to read media packets
+     * @param [in]     sharedReceiver If not null, the #RmcatReceiver already
+     *                                installed at the receiver node, listening
+     *                                on serverPort, that is to sink this flow
+     *                                too; no new receiver is installed
      *
      * @retval A container with the two applications (sender and receiver)
      */
 
-    static ApplicationContainer InstallRMCAT (const std::string& flowId,
-                                              Ptr<Node> sender,
-                                              Ptr<Node> receiver,
-                                              uint16_t serverPort);
+    ApplicationContainer InstallRMCAT (const std::string& flowId,
+                                       Ptr<Node> sender,
+                                       Ptr<Node> receiver,
+                                       uint16_t serverPort,
+                                       Ptr<Application> sharedReceiver = Ptr<Application> ()) const;
 
+    bool m_rtpHeader; /**< see #SetRtpHeader */
 
+public:
     /**
      * Simple logging callback to be passed to the congestion controller
      *
      * @param [in] msg Message that the congestion controller wants to log
      */
     static void logFromController (const std::string& msg);
+
+    /** Whether #logFromController currently outputs anything */
+    static bool logFromControllerEnabled ();
 };
 
 }
@@ -0,0 +1,235 @@
+/******************************************************************************
+ * Copyright 2016-2017 Cisco Systems, Inc.                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ *                                                                            *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+/**
+ * @file
+ * Trace-driven queue disc implementation for rmcat ns3 module.
+ *
+ * @version 0.1.0
+ * @author Jiantao Fu
+ * @author Sergio Mena
+ * @author Xiaoqing Zhu
+ */
+
+#include "trace-driven-queue-disc.h"
+#include "ns3/simulator.h"
+#include "ns3/string.h"
+#include "ns3/uinteger.h"
+#include "ns3/log.h"
+#include "ns3/abort.h"
+
+#include <cstdlib>
+
+NS_LOG_COMPONENT_DEFINE ("TraceDrivenQueueDisc");
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED (TraceDrivenQueueDisc);
+
+TypeId TraceDrivenQueueDisc::GetTypeId (void)
+{
+    static TypeId tid = TypeId ("ns3::TraceDrivenQueueDisc")
+      .SetParent<QueueDisc> ()
+      .AddConstructor<TraceDrivenQueueDisc> ()
+      .AddAttribute ("TraceFile",
+                     "Packet-delivery trace (Mahimahi format)",
+                     StringValue (""),
+                     MakeStringAccessor (&TraceDrivenQueueDisc::m_traceFile),
+                     MakeStringChecker ())
+      .AddAttribute ("MaxBytes",
+                     "Capacity of the queue, in bytes",
+                     UintegerValue (100 * 1500),
+                     MakeUintegerAccessor (&TraceDrivenQueueDisc::m_maxBytes),
+                     MakeUintegerChecker<uint32_t> ())
+      .AddAttribute ("Mtu",
+                     "Bytes that can leave the queue at each delivery opportunity",
+                     UintegerValue (1500),
+                     MakeUintegerAccessor (&TraceDrivenQueueDisc::m_mtu),
+                     MakeUintegerChecker<uint32_t> (1))
+    ;
+    return tid;
+}
+
+TraceDrivenQueueDisc::TraceDrivenQueueDisc ()
+: QueueDisc ()
+, m_traceFile{}
+, m_maxBytes{0}
+, m_mtu{0}
+, m_queue{}
+, m_bytes{0}
+, m_headServed{0}
+, m_trace{}
+, m_loopOffsetMs{0}
+, m_lastTraceMs{0}
+, m_nextOpportunity{}
+, m_credit{0}
+, m_creditExpiry{}
+, m_wakeEvent{}
+{}
+
+TraceDrivenQueueDisc::~TraceDrivenQueueDisc () {}
+
+uint64_t TraceDrivenQueueDisc::GetMeanRate (const std::string& filename, uint32_t mtu)
+{
+    std::ifstream trace{filename.c_str ()};
+    NS_ABORT_MSG_UNLESS (trace.is_open (), "Cannot open packet-delivery trace " << filename);
+    uint64_t opportunities = 0;
+    uint64_t lastMs = 0;
+    std::string line;
+    while (std::getline (trace, line)) {
+        if (line.empty ()) {
+            continue;
+        }
+        ++opportunities;
+        lastMs = std::strtoull (line.c_str (), NULL, 10);
+    }
+    NS_ABORT_MSG_IF (lastMs == 0, "No usable delivery opportunities in trace " << filename);
+    return opportunities * mtu * 8 * 1000 / lastMs;
+}
+
+bool TraceDrivenQueueDisc::DoEnqueue (Ptr<QueueDiscItem> item)
+{
+    const auto size = item->GetPacketSize ();
+    if (m_bytes + size > m_maxBytes) {
+        NS_LOG_INFO ("TraceDrivenQueueDisc::DoEnqueue, queue full, dropping packet of "
+                     << size << " bytes");
+        Drop (item);
+        return false;
+    }
+    m_queue.push_back (item);
+    m_bytes += size;
+    return true;
+}
+
+Ptr<QueueDiscItem> TraceDrivenQueueDisc::DoDequeue (void)
+{
+    if (m_queue.empty ()) {
+        return 0;
+    }
+
+    const auto now = Simulator::Now ();
+    if (now >= m_creditExpiry) {
+        m_credit = 0;
+    }
+    // Collect the opportunities due; those whose ms is over went unused
+    while (m_nextOpportunity <= now) {
+        const auto expiry = m_nextOpportunity + MilliSeconds (1);
+        if (expiry > now) {
+            m_credit += m_mtu;
+            m_creditExpiry = expiry;
+        }
+        ReadNextOpportunity ();
+    }
+
+    auto item = m_queue.front ();
+    const auto size = item->GetPacketSize ();
+    NS_ASSERT (m_headServed < size);
+    const auto needed = size - m_headServed;
+    if (m_credit < needed) {
+        // Partly delivered now, the rest at the next opportunities
+        m_headServed += m_credit;
+        m_credit = 0;
+        if (!m_wakeEvent.IsRunning ()) {
+            m_wakeEvent = Simulator::Schedule (m_nextOpportunity - now,
+                                               &TraceDrivenQueueDisc::Wake, this);
+        }
+        return 0;
+    }
+
+    m_credit -= needed;
+    m_headServed = 0;
+    m_queue.pop_front ();
+    NS_ASSERT (m_bytes >= size);
+    m_bytes -= size;
+    return item;
+}
+
+Ptr<const QueueDiscItem> TraceDrivenQueueDisc::DoPeek (void) const
+{
+    if (m_queue.empty ()) {
+        return 0;
+    }
+    return m_queue.front ();
+}
+
+bool TraceDrivenQueueDisc::CheckConfig (void)
+{
+    if (GetNQueueDiscClasses () > 0 || GetNPacketFilters () > 0 || GetNInternalQueues () > 0) {
+        NS_LOG_ERROR ("TraceDrivenQueueDisc needs no classes, filters or internal queues");
+        return false;
+    }
+    if (m_traceFile.empty ()) {
+        NS_LOG_ERROR ("TraceDrivenQueueDisc needs a trace file");
+        return false;
+    }
+    return true;
+}
+
+void TraceDrivenQueueDisc::InitializeParams (void)
+{
+    m_trace.open (m_traceFile.c_str ());
+    NS_ABORT_MSG_UNLESS (m_trace.is_open (), "Cannot open packet-delivery trace " << m_traceFile);
+    m_loopOffsetMs = Simulator::Now ().GetMilliSeconds ();
+    m_lastTraceMs = 0;
+    m_credit = 0;
+    m_creditExpiry = Simulator::Now ();
+    ReadNextOpportunity ();
+}
+
+void TraceDrivenQueueDisc::DoDispose (void)
+{
+    Simulator::Cancel (m_wakeEvent);
+    m_queue.clear ();
+    m_bytes = 0;
+    m_trace.close ();
+    QueueDisc::DoDispose ();
+}
+
+void TraceDrivenQueueDisc::ReadNextOpportunity ()
+{
+    std::string line;
+    bool restarted = false;
+    while (true) {
+        if (!std::getline (m_trace, line)) {
+            // Loop the trace, shifted by its duration
+            NS_ABORT_MSG_IF (restarted || m_lastTraceMs == 0,
+                             "No usable delivery opportunities in trace " << m_traceFile);
+            m_trace.clear ();
+            m_trace.seekg (0);
+            m_loopOffsetMs += m_lastTraceMs;
+            m_lastTraceMs = 0;
+            restarted = true;
+            continue;
+        }
+        if (line.empty ()) {
+            continue;
+        }
+        const uint64_t ms = std::strtoull (line.c_str (), NULL, 10);
+        NS_ABORT_MSG_IF (ms < m_lastTraceMs,
+                         "Decreasing times in packet-delivery trace " << m_traceFile);
+        m_lastTraceMs = ms;
+        m_nextOpportunity = MilliSeconds (m_loopOffsetMs + ms);
+        return;
+    }
+}
+
+void TraceDrivenQueueDisc::Wake ()
+{
+    Run ();
+}
+
+}
@@ -0,0 +1,111 @@
+/******************************************************************************
+ * Copyright 2016-2017 Cisco Systems, Inc.                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ *                                                                            *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+/**
+ * @file
+ * Trace-driven queue disc interface for rmcat ns3 module.
+ *
+ * @version 0.1.0
+ * @author Jiantao Fu
+ * @author Sergio Mena
+ * @author Xiaoqing Zhu
+ */
+
+#ifndef TRACE_DRIVEN_QUEUE_DISC_H
+#define TRACE_DRIVEN_QUEUE_DISC_H
+
+#include "ns3/queue-disc.h"
+#include "ns3/nstime.h"
+#include "ns3/event-id.h"
+#include <deque>
+#include <fstream>
+#include <string>
+
+namespace ns3 {
+
+/**
+ * Drop-tail queue disc releasing packets only at the delivery
+ * opportunities listed in a packet-delivery trace, in the format used by
+ * the Mahimahi link emulator: one integer per line, the time (in ms,
+ * from the start of the trace) at which one MTU worth of bytes can leave
+ * the queue. Several lines with the same time give several opportunities
+ * within that ms. A packet larger than what is left of an opportunity
+ * takes the rest, and leaves at a later one.
+ *
+ * Opportunities unused before the end of their ms are lost, just as a
+ * cellular link does not save up capacity while idle. The trace is read
+ * from disk as it goes, and starts over, shifted by its last time, when
+ * it ends.
+ *
+ * The device the queue disc is installed on must be much faster than the
+ * trace's peak rate (see #WiredTopo::SetLinkTrace ); the queue disc wakes
+ * itself up at the next opportunity when it holds packets it cannot
+ * release yet.
+ *
+ * Written against the ns-3.26 QueueDisc API, the release this module
+ * targets (ns-3.27 replaced #QueueDisc::Drop with DropBeforeEnqueue).
+ */
+class TraceDrivenQueueDisc : public QueueDisc
+{
+public:
+    static TypeId GetTypeId (void);
+
+    TraceDrivenQueueDisc ();
+    virtual ~TraceDrivenQueueDisc ();
+
+    /**
+     * Mean delivery rate of a packet-delivery trace, over one loop of the
+     * trace: one MTU per opportunity, over the trace's last time
+     *
+     * @param [in] filename Packet-delivery trace
+     * @param [in] mtu Bytes that can leave the queue at each opportunity
+     * @retval Mean rate, in bps
+     */
+    static uint64_t GetMeanRate (const std::string& filename, uint32_t mtu);
+
+private:
+    virtual bool DoEnqueue (Ptr<QueueDiscItem> item);
+    virtual Ptr<QueueDiscItem> DoDequeue (void);
+    virtual Ptr<const QueueDiscItem> DoPeek (void) const;
+    virtual bool CheckConfig (void);
+    virtual void InitializeParams (void);
+    virtual void DoDispose (void);
+
+    void ReadNextOpportunity ();
+    void Wake ();
+
+    /* Attributes */
+    std::string m_traceFile;
+    uint32_t m_maxBytes;
+    uint32_t m_mtu;
+
+    std::deque<Ptr<QueueDiscItem> > m_queue;
+    uint32_t m_bytes;           // in m_queue
+    uint32_t m_headServed;      // bytes of the head packet already delivered
+
+    std::ifstream m_trace;
+    uint64_t m_loopOffsetMs;    // added to the trace's times in this loop
+    uint64_t m_lastTraceMs;     // last time read in this loop
+    Time m_nextOpportunity;
+    uint32_t m_credit;          // bytes left in the current opportunities
+    Time m_creditExpiry;
+    EventId m_wakeEvent;
+};
+
+}
+
+#endif /* TRACE_DRIVEN_QUEUE_DISC_H */
@@ -47,7 +47,7 @@ void WifiTopo::Build (uint64_t bandwidthBps,
 
     uint32_t bufSize = bandwidthBps * msQDelay / 8 / 1000;
     // At least one full packet with default size must fit
-    NS_ASSERT (bufSize >= DEFAULT_PACKET_SIZE + IPV4_UDP_OVERHEAD);
+    NS_ASSERT (bufSize >= DEFAULT_PACKET_SIZE + GetMediaPacketOverhead ());
     wiredLinkHlpr.SetQueue ("ns3::DropTailQueue",
                             "Mode", StringValue ("QUEUE_MODE_BYTES"),
                             "MaxBytes", UintegerValue (bufSize));
@@ -26,12 +26,71 @@
  */
 
 #include "wired-topo.h"
+#include "jitter-channel.h"
+#include "trace-driven-queue-disc.h"
+#include "red-ecn-queue-disc.h"
+#include <algorithm>
 
 namespace ns3 {
 
+SojournStats::SojournStats ()
+: packets{0},
+  total{},
+  max{}
+{}
+
+void SojournStats::Record (Time sojourn)
+{
+    ++packets;
+    total += sojourn;
+    if (sojourn > max) {
+        max = sojourn;
+    }
+}
+
+void SojournStats::Enqueued (Ptr<const QueueItem> item)
+{
+    enqueueTimes[PeekPointer (item)] = Simulator::Now ();
+}
+
+void SojournStats::Dequeued (Ptr<const QueueItem> item)
+{
+    // A requeued packet is only timed the first time it leaves
+    auto it = enqueueTimes.find (PeekPointer (item));
+    if (it == enqueueTimes.end ()) {
+        return;
+    }
+    Record (Simulator::Now () - it->second);
+    enqueueTimes.erase (it);
+}
+
+void SojournStats::Dropped (Ptr<const QueueItem> item)
+{
+    enqueueTimes.erase (PeekPointer (item));
+}
+
+Time SojournStats::GetMean () const
+{
+    if (packets == 0) {
+        return Time{0};
+    }
+    return NanoSeconds (total.GetNanoSeconds () / static_cast<int64_t> (packets));
+}
+
 WiredTopo::WiredTopo ()
 : m_numApps{0},
-  m_bufSize{0}
+  m_bufSize{0},
+  m_bandwidthBps{0},
+  m_aqm{AQM_DROPTAIL},
+  m_sojournStats{},
+  m_linkTraces{},
+  m_jitter{},
+  m_jitterTrace{},
+  m_jitterReorder{false},
+  m_sharedReceiver{false},
+  m_sharedRecvNodes{},
+  m_sharedRecvApps{},
+  m_sharedRecvPorts{}
 {}
 
 WiredTopo::~WiredTopo ()
@@ -47,14 +106,36 @@ void WiredTopo::Build (uint64_t bandwidthBps, uint32_t msDelay, uint32_t msQDela
     // We set the the bottleneck link's propagation delay to 90% of the total delay
     bottleneckLinkHlpr.SetChannelAttribute ("Delay", TimeValue (MicroSeconds (msDelay * 1000 * 9 / 10)));
     m_bufSize = bandwidthBps * msQDelay / 8 / 1000;
+    m_bandwidthBps = bandwidthBps;
     // At least one full packet with default size must fit
-    NS_ASSERT (m_bufSize >= DEFAULT_PACKET_SIZE + IPV4_UDP_OVERHEAD);
+    NS_ASSERT (m_bufSize >= DEFAULT_PACKET_SIZE + GetMediaPacketOverhead ());
 
     bottleneckLinkHlpr.SetQueue ("ns3::DropTailQueue",
                                  "Mode", StringValue ("QUEUE_MODE_BYTES"),
                                  "MaxBytes", UintegerValue (m_bufSize));
 
     m_bottleneckDevices = bottleneckLinkHlpr.Install (m_bottleneckNodes);
+    if (m_jitter || !m_jitterTrace.empty ()) {
+        InstallBottleneckJitter (msDelay);
+    }
+
+    for (uint32_t i = 0; i < m_bottleneckDevices.GetN (); ++i) {
+        if (!HasQueueDisc (i)) {
+            continue;
+        }
+        auto device = DynamicCast<PointToPointNetDevice> (m_bottleneckDevices.Get (i));
+        NS_ASSERT (device);
+        // The queue builds up in the queue disc, where it can be managed.
+        // With a single packet in the device queue, the flow control
+        // between both keeps the queue disc from adding any delay beyond
+        // its own limit
+        device->GetQueue ()->SetAttribute ("Mode", StringValue ("QUEUE_MODE_PACKETS"));
+        device->GetQueue ()->SetAttribute ("MaxPackets", UintegerValue (1));
+        if (!m_linkTraces[i].empty ()) {
+            // Capacity given by the trace; the device just has to keep up
+            device->SetDataRate (DataRate (WIRED_TOPO_TRACE_LINK_RATE));
+        }
+    }
 
     //Uncomment the line below to ease troubleshooting
     //bottleneckLinkHlpr.EnablePcapAll ("rmcat-wired-capture", true);
@@ -77,9 +158,11 @@ void WiredTopo::Build (uint64_t bandwidthBps, uint32_t msDelay, uint32_t msQDela
                             "Mode", StringValue ("QUEUE_MODE_BYTES"),
                             "MaxBytes", UintegerValue (m_bufSize));
 
-    // Disable tc now, some bug in ns3 causes extra delay
+    // The default queue disc (pfifo_fast, 1000 packets) would queue up
+    // in front of the device's queue, beyond the configured capacity
     TrafficControlHelper tch;
     tch.Uninstall (m_bottleneckDevices);
+    InstallBottleneckQueueDiscs (bandwidthBps, msDelay);
 
     Packet::EnablePrinting ();
 }
@@ -122,6 +205,23 @@ ApplicationContainer WiredTopo::InstallRMCAT (const std::string& flowId,
                                               uint32_t pDelayMs,
                                               bool forward)
 {
+    if (m_sharedReceiver) {
+        // Forward flows are received on the right, backward ones on the left
+        const int recvSide = forward ? 1 : 0;
+        if (!m_sharedRecvNodes[recvSide]) {
+            m_sharedRecvNodes[recvSide] = SetupSingleAppNode (recvSide, 0);
+            m_sharedRecvPorts[recvSide] = serverPort;
+        }
+        auto sender = SetupSingleAppNode (1 - recvSide, pDelayMs);
+        auto apps = Topo::InstallRMCAT (flowId,
+                                        sender,
+                                        m_sharedRecvNodes[recvSide],
+                                        m_sharedRecvPorts[recvSide],
+                                        m_sharedRecvApps[recvSide]);
+        m_sharedRecvApps[recvSide] = apps.Get (1);
+        return apps;
+    }
+
     auto appNodes = SetupAppNodes (pDelayMs, true);
 
     auto sender = appNodes.Get (1);
@@ -168,6 +268,211 @@ void WiredTopo::SetupAppNode (Ptr<Node> node, int bottleneckIdx, uint32_t pDelay
     //}
 }
 
+void WiredTopo::SetSharedReceiver (bool shared)
+{
+    m_sharedReceiver = shared;
+}
+
+void WiredTopo::SetEcnMarking (bool enable)
+{
+    SetBottleneckAqm (enable ? AQM_RED_ECN : AQM_DROPTAIL);
+}
+
+void WiredTopo::SetBottleneckAqm (BottleneckAqm aqm)
+{
+    NS_ASSERT (m_bottleneckNodes.GetN () == 0);
+    NS_ABORT_MSG_UNLESS (IsBottleneckAqmSupported (aqm),
+                         "Bottleneck AQM " << aqm << " not available in this ns-3 release");
+    m_aqm = aqm;
+}
+
+bool WiredTopo::IsBottleneckAqmSupported (BottleneckAqm aqm)
+{
+    TypeId tid;
+    switch (aqm) {
+        case AQM_DROPTAIL:
+        case AQM_RED_ECN: // this module's own queue disc
+            return true;
+        case AQM_CODEL:
+            return TypeId::LookupByNameFailSafe ("ns3::CoDelQueueDisc", &tid);
+        case AQM_FQ_CODEL:
+            return TypeId::LookupByNameFailSafe ("ns3::FqCoDelQueueDisc", &tid) &&
+                   TypeId::LookupByNameFailSafe ("ns3::FqCoDelIpv4PacketFilter", &tid);
+        case AQM_PIE:
+            return TypeId::LookupByNameFailSafe ("ns3::PieQueueDisc", &tid);
+        default:
+            return false;
+    }
+}
+
+const SojournStats& WiredTopo::GetSojournStats (bool forward) const
+{
+    // Forward traffic is queued at the left end of the bottleneck
+    return m_sojournStats[forward ? 0 : 1];
+}
+
+void WiredTopo::SetLinkTrace (const std::string& filename, bool forward)
+{
+    NS_ASSERT (m_bottleneckNodes.GetN () == 0);
+    m_linkTraces[forward ? 0 : 1] = filename;
+}
+
+void WiredTopo::SetBottleneckJitter (Ptr<RandomVariableStream> jitter, bool reorder)
+{
+    NS_ASSERT (m_bottleneckNodes.GetN () == 0);
+    NS_ASSERT (jitter);
+    m_jitter = jitter;
+    m_jitterTrace.clear ();
+    m_jitterReorder = reorder;
+}
+
+void WiredTopo::SetBottleneckJitterTrace (const std::string& filename, bool reorder)
+{
+    NS_ASSERT (m_bottleneckNodes.GetN () == 0);
+    NS_ASSERT (!filename.empty ());
+    m_jitter = 0;
+    m_jitterTrace = filename;
+    m_jitterReorder = reorder;
+}
+
+void WiredTopo::ScheduleCapacity (Time when, uint64_t bandwidthBps, bool forward)
+{
+    NS_ASSERT (m_bottleneckDevices.GetN () == 2);
+    NS_ASSERT (bandwidthBps > 0);
+    // A trace-driven direction gets its capacity from the trace only
+    NS_ASSERT (m_linkTraces[forward ? 0 : 1].empty ());
+    // Forward traffic is sent by the left end of the bottleneck
+    Simulator::Schedule (when, &WiredTopo::SetCapacity, this,
+                         forward ? 0 : 1, bandwidthBps);
+}
+
+void WiredTopo::SetCapacity (uint32_t device, uint64_t bandwidthBps)
+{
+    auto p2pDevice = DynamicCast<PointToPointNetDevice> (m_bottleneckDevices.Get (device));
+    NS_ASSERT (p2pDevice);
+    p2pDevice->SetDataRate (DataRate (bandwidthBps));
+    if (!HasQueueDisc (device)) {
+        // Same queuing delay at the new capacity
+        const uint64_t bufSize = std::max<uint64_t> (DEFAULT_PACKET_SIZE + GetMediaPacketOverhead (),
+                                                     uint64_t (m_bufSize) * bandwidthBps / m_bandwidthBps);
+        p2pDevice->GetQueue ()->SetAttribute ("MaxBytes", UintegerValue (bufSize));
+    }
+}
+
+void WiredTopo::InstallBottleneckQueueDiscs (uint64_t bandwidthBps, uint32_t msDelay)
+{
+    const uint32_t pktSize = DEFAULT_PACKET_SIZE + GetMediaPacketOverhead ();
+    TrafficControlHelper tcHlpr;
+    switch (m_aqm) {
+        case AQM_DROPTAIL:
+            break;
+        case AQM_RED_ECN: {
+            const uint32_t minTh = std::max<uint32_t> (pktSize,
+                                                       bandwidthBps * WIRED_TOPO_RED_MINTH_MS / 8 / 1000);
+            const uint32_t maxTh = std::max<uint32_t> (3 * minTh,
+                                                       bandwidthBps * WIRED_TOPO_RED_MAXTH_MS / 8 / 1000);
+            tcHlpr.SetRootQueueDisc ("ns3::RedEcnQueueDisc",
+                                     "MaxBytes", UintegerValue (m_bufSize),
+                                     "MinTh", UintegerValue (minTh),
+                                     "MaxTh", UintegerValue (maxTh));
+            break;
+        }
+        case AQM_CODEL:
+            tcHlpr.SetRootQueueDisc ("ns3::CoDelQueueDisc",
+                                     "Mode", StringValue ("QUEUE_MODE_BYTES"),
+                                     "MaxBytes", UintegerValue (m_bufSize));
+            break;
+        case AQM_FQ_CODEL: {
+            // FQ-CoDel's limit is in packets
+            const uint32_t limit = std::max<uint32_t> (1, m_bufSize / pktSize);
+            auto handle = tcHlpr.SetRootQueueDisc ("ns3::FqCoDelQueueDisc",
+                                                   "PacketLimit", UintegerValue (limit));
+            tcHlpr.AddPacketFilter (handle, "ns3::FqCoDelIpv4PacketFilter");
+            break;
+        }
+        case AQM_PIE:
+            tcHlpr.SetRootQueueDisc ("ns3::PieQueueDisc",
+                                     "Mode", StringValue ("QUEUE_MODE_BYTES"),
+                                     "MeanPktSize", UintegerValue (pktSize),
+                                     "QueueLimit", UintegerValue (m_bufSize));
+            break;
+        default:
+            NS_ABORT_MSG ("Unsupported bottleneck AQM " << m_aqm);
+    }
+
+    for (uint32_t i = 0; i < m_bottleneckDevices.GetN (); ++i) {
+        if (!HasQueueDisc (i)) {
+            continue;
+        }
+        QueueDiscContainer queueDiscs;
+        if (!m_linkTraces[i].empty ()) {
+            // The trace takes the place of the AQM in this direction. The
+            // queue holds the queuing delay given to Build at the trace's
+            // mean rate, as SetCapacity does at a new capacity
+            const uint64_t traceBps = TraceDrivenQueueDisc::GetMeanRate (m_linkTraces[i],
+                                                                         WIRED_TOPO_TRACE_MTU);
+            const uint64_t bufSize = std::max<uint64_t> (WIRED_TOPO_TRACE_MTU,
+                                                         uint64_t (m_bufSize) * traceBps / m_bandwidthBps);
+            TrafficControlHelper traceHlpr;
+            traceHlpr.SetRootQueueDisc ("ns3::TraceDrivenQueueDisc",
+                                        "TraceFile", StringValue (m_linkTraces[i]),
+                                        "MaxBytes", UintegerValue (bufSize),
+                                        "Mtu", UintegerValue (WIRED_TOPO_TRACE_MTU));
+            queueDiscs = traceHlpr.Install (m_bottleneckDevices.Get (i));
+        } else {
+            queueDiscs = tcHlpr.Install (m_bottleneckDevices.Get (i));
+        }
+        NS_ASSERT (queueDiscs.GetN () == 1);
+        m_sojournStats[i] = SojournStats{};
+        auto queueDisc = queueDiscs.Get (0);
+        if (!queueDisc->TraceConnectWithoutContext ("SojournTime",
+                                                    MakeCallback (&SojournStats::Record,
+                                                                  &m_sojournStats[i]))) {
+            // No sojourn times traced by this ns-3 release: time the
+            // packets between enqueue and dequeue
+            queueDisc->TraceConnectWithoutContext ("Enqueue",
+                                                   MakeCallback (&SojournStats::Enqueued,
+                                                                 &m_sojournStats[i]));
+            queueDisc->TraceConnectWithoutContext ("Dequeue",
+                                                   MakeCallback (&SojournStats::Dequeued,
+                                                                 &m_sojournStats[i]));
+            queueDisc->TraceConnectWithoutContext ("Drop",
+                                                   MakeCallback (&SojournStats::Dropped,
+                                                                 &m_sojournStats[i]));
+        }
+    }
+}
+
+void WiredTopo::InstallBottleneckJitter (uint32_t msDelay)
+{
+    // PointToPointHelper always creates a plain channel: move both
+    // devices over to a jitter channel with the same propagation delay
+    auto channel = CreateObject<JitterChannel> ();
+    channel->SetAttribute ("Delay", TimeValue (MicroSeconds (msDelay * 1000 * 9 / 10)));
+    channel->SetAttribute ("Jitter", PointerValue (m_jitter));
+    channel->SetAttribute ("JitterTrace", StringValue (m_jitterTrace));
+    channel->SetAttribute ("Reorder", BooleanValue (m_jitterReorder));
+    for (uint32_t i = 0; i < m_bottleneckDevices.GetN (); ++i) {
+        auto device = DynamicCast<PointToPointNetDevice> (m_bottleneckDevices.Get (i));
+        NS_ASSERT (device);
+        device->Attach (channel);
+    }
+}
+
+bool WiredTopo::HasQueueDisc (uint32_t device) const
+{
+    return m_aqm != AQM_DROPTAIL || !m_linkTraces[device].empty ();
+}
+
+Ptr<Node> WiredTopo::SetupSingleAppNode (int subnet, uint32_t pDelayMs)
+{
+    auto node = CreateObject<Node> ();
+    m_inetStackHlpr.Install (node);
+    SetupAppNode (node, subnet, pDelayMs);
+    ++m_numApps;
+    return node;
+}
+
 NodeContainer WiredTopo::SetupAppNodes (uint32_t pDelayMs, bool newNode)
 {
     if (newNode) {
@@ -29,9 +29,46 @@
 #define WIRED_TOPO_H
 
 #include "topo.h"
+#include <map>
 
 namespace ns3 {
 
+/** Active queue management at the bottleneck link (see #WiredTopo ) */
+enum BottleneckAqm {
+    AQM_DROPTAIL = 0, // byte-limited drop-tail device queue, no queue disc
+    AQM_RED_ECN,      // RED, marking ECN-capable packets (see #RedEcnQueueDisc )
+    AQM_CODEL,
+    AQM_FQ_CODEL,
+    AQM_PIE
+};
+
+/** Time packets spent in a bottleneck queue disc */
+struct SojournStats
+{
+    SojournStats ();
+    /** Trace sink for the queue disc's "SojournTime" trace source */
+    void Record (Time sojourn);
+    /**
+     * Trace sinks for the queue disc's "Enqueue", "Dequeue" and "Drop"
+     * trace sources, timing the packets through queue discs that have no
+     * "SojournTime" trace source (older ns-3 releases, e.g., ns-3.26).
+     * Packets are told apart by their queue disc item, which lives from
+     * enqueue to dequeue or drop, rather than by their uid: pooled
+     * packets (see #RmcatPacketPool ) keep theirs when reused, so two
+     * copies of one can be queued at the same time
+     */
+    void Enqueued (Ptr<const QueueItem> item);
+    void Dequeued (Ptr<const QueueItem> item);
+    void Dropped (Ptr<const QueueItem> item);
+    /** Average sojourn time; zero if no packet left the queue disc */
+    Time GetMean () const;
+
+    uint64_t packets;
+    Time total;
+    Time max;
+    std::map<const QueueItem*, Time> enqueueTimes; // by queue item, when timed by the sinks above
+};
+
 /**
  * Class implementing the network Topology for rmcat wired test cases.
  * The diagram below depicts the topology and the IP subnets configured.
@@ -132,18 +169,133 @@ public:
                                        uint32_t pDelayMs,
                                        bool forward);
 
+    /**
+     * Sink all the rmcat flows installed from now on, in each direction,
+     * at a single receiver node and #RmcatReceiver application, rather
+     * than at a new node per flow (default: off). Each flow still gets a
+     * new sender node. The shared receiver listens on the server port of
+     * the first flow installed in its direction; the server port of the
+     * others is ignored
+     *
+     * @param [in] shared Whether receivers are to be shared
+     */
+    void SetSharedReceiver (bool shared);
+
+    /**
+     * Manage the bottleneck link's queue with a RED queue disc that marks
+     * ECN-capable packets, instead of dropping them, once the average
+     * queue exceeds a few ms at link capacity (see #RedEcnQueueDisc ) (default: off, i.e.,
+     * drop-tail). Same as #SetBottleneckAqm with #AQM_RED_ECN . Must be
+     * called before #Build
+     *
+     * @param [in] enable Whether the bottleneck marks ECN-capable packets
+     */
+    void SetEcnMarking (bool enable);
+
+    /**
+     * Select the queue management of the bottleneck link, in both
+     * directions (default: #AQM_DROPTAIL ). Other than drop-tail, the
+     * queue is held by a traffic control queue disc running the AQM, and
+     * its capacity stays as given to #Build . Must be called before #Build
+     *
+     * @param [in] aqm Queue management at the bottleneck; must be
+     *                 supported by this ns-3 release
+     *                 (see #IsBottleneckAqmSupported )
+     */
+    void SetBottleneckAqm (BottleneckAqm aqm);
+
+    /**
+     * Whether this ns-3 release provides the queue disc an AQM needs. The
+     * module targets ns-3.26, which has no FQ-CoDel; ECN-marking RED is
+     * this module's own queue disc, always available
+     *
+     * @param [in] aqm Queue management at the bottleneck
+     */
+    static bool IsBottleneckAqmSupported (BottleneckAqm aqm);
+
+    /**
+     * Sojourn times at the bottleneck queue disc, for the packets sent so
+     * far. Only recorded when the bottleneck runs an AQM
+     * (see #SetBottleneckAqm )
+     *
+     * @param [in] forward Direction: left-to-right if true
+     */
+    const SojournStats& GetSojournStats (bool forward) const;
+
+    /**
+     * Change the capacity of the bottleneck link, in one direction, at a
+     * given time. With a drop-tail bottleneck, the queue's capacity in
+     * bytes is scaled along, so that it still holds the queuing delay
+     * given to #Build . Must be called after #Build
+     *
+     * @param [in] when Simulation time at which the change applies
+     * @param [in] bandwidthBps New capacity (in bps)
+     * @param [in] forward Direction: left-to-right if true
+     */
+    void ScheduleCapacity (Time when, uint64_t bandwidthBps, bool forward);
+
+    /**
+     * Make the bottleneck link, in one direction, deliver packets only at
+     * the opportunities listed in a packet-delivery trace (Mahimahi
+     * format, see #TraceDrivenQueueDisc ), e.g., recorded on a cellular
+     * link. The queue holds the queuing delay given to #Build at the
+     * trace's mean rate, and the bandwidth given to #Build is otherwise
+     * ignored in that direction, as is any AQM (see #SetBottleneckAqm ).
+     * Must be called before #Build
+     *
+     * @param [in] filename Packet-delivery trace, looped if it ends
+     * @param [in] forward Direction: left-to-right if true
+     */
+    void SetLinkTrace (const std::string& filename, bool forward);
+
+    /**
+     * Add a random extra delay (jitter, see #JitterChannel ) to the
+     * propagation delay of the bottleneck link, in both directions. Must be
+     * called before #Build
+     *
+     * @param [in] jitter Extra delay of each packet, in ms (e.g., a
+     *                    #UniformRandomVariable or #ParetoRandomVariable )
+     * @param [in] reorder Whether packets may overtake earlier ones; if
+     *                     false, they keep their order
+     */
+    void SetBottleneckJitter (Ptr<RandomVariableStream> jitter, bool reorder);
+
+    /**
+     * Same as #SetBottleneckJitter , drawing the extra delays from a
+     * trace: one value, in ms, per line, looped if it ends
+     */
+    void SetBottleneckJitterTrace (const std::string& filename, bool reorder);
+
 private:
     void SetupAppNode (Ptr<Node> node, int subnet, uint32_t pDelayMs);
     NodeContainer SetupAppNodes (uint32_t pDelayMs, bool newNode);
+    Ptr<Node> SetupSingleAppNode (int subnet, uint32_t pDelayMs);
+    void InstallBottleneckQueueDiscs (uint64_t bandwidthBps, uint32_t msDelay);
+    void SetCapacity (uint32_t device, uint64_t bandwidthBps);
+    bool HasQueueDisc (uint32_t device) const;
+    void InstallBottleneckJitter (uint32_t msDelay);
 
 protected:
     unsigned m_numApps;
     uint32_t m_bufSize;
+    uint64_t m_bandwidthBps; // bottleneck capacity given to Build
     NodeContainer m_bottleneckNodes;
     NodeContainer m_appNodes; // Last application node pair created
     NetDeviceContainer m_bottleneckDevices;
     InternetStackHelper m_inetStackHlpr;
     PointToPointHelper m_appLinkHlpr;
+    BottleneckAqm m_aqm;
+    SojournStats m_sojournStats[2]; // indexed by bottleneck device
+    std::string m_linkTraces[2];    // packet-delivery traces, same index
+    Ptr<RandomVariableStream> m_jitter;
+    std::string m_jitterTrace;
+    bool m_jitterReorder;
+
+    /* Shared receivers, indexed by the side of the bottleneck they are on */
+    bool m_sharedReceiver;
+    Ptr<Node> m_sharedRecvNodes[2];
+    Ptr<Application> m_sharedRecvApps[2];
+    uint16_t m_sharedRecvPorts[2];
 };
 
 }
@@ -0,0 +1,381 @@
+/******************************************************************************
+ * Copyright 2016-2017 Cisco Systems, Inc.                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ *                                                                            *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+/**
+ * @file
+ * Microbenchmark suite for the congestion controllers' hot path. It does
+ * not depend on ns3.
+ *
+ * Each scenario is a synthetic packet trace (loss, reordering and delay
+ * patterns) generated up front and then replayed into a controller through
+ * processSendPacket/getBandwidth (one call each per packet sent) and
+ * processFeedback or processFeedbackBatch (per received packet). One "op"
+ * is one media packet of the trace. For every controller, scenario and
+ * feedback mode, the suite reports wall-clock time, heap allocations and
+ * (on Linux, when the kernel allows it) hardware cache misses per op.
+ * Controllers report their statistics to an in-memory sink, so no log text
+ * is formatted while measuring.
+ *
+ * Usage: rmcat-controller-bench [number of packets per scenario]
+ *
+ * @version 0.1.0
+ * @author Jiantao Fu
+ * @author Sergio Mena
+ * @author Xiaoqing Zhu
+ */
+
+#include "packet-ring.h"
+#include "nada-controller.h"
+#include "dummy-controller.h"
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <random>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/* Global allocation counter, fed by the replacement operator new below */
+static uint64_t g_allocCount = 0;
+
+void* operator new (std::size_t size)
+{
+    ++g_allocCount;
+    void* p = std::malloc (size == 0 ? 1 : size);
+    if (p == NULL) {
+        throw std::bad_alloc{};
+    }
+    return p;
+}
+
+void operator delete (void* p) noexcept
+{
+    std::free (p);
+}
+
+void operator delete (void* p, std::size_t) noexcept
+{
+    std::free (p);
+}
+
+const uint32_t BENCH_PKT_SIZE = 1000;     // bytes
+const uint64_t BENCH_MS = rmcat::RMCAT_US_PER_MS; // controllers' time unit is us
+const uint64_t BENCH_PKT_INTERVAL = 5 * BENCH_MS;    // 1.6 Mbps with 1000-byte packets
+const uint64_t BENCH_OWD = 50 * BENCH_MS;            // forward path propagation delay
+const uint64_t BENCH_RETURN_DELAY = 50 * BENCH_MS;   // feedback path delay
+const uint64_t BENCH_REPORT_INTERVAL = 20 * BENCH_MS; // between batched feedback reports
+const size_t BENCH_BACKLOG = 100;         // packets in the FIFO benchmark
+const size_t BENCH_DEFAULT_NPACKETS = 200000;
+const uint32_t BENCH_SEED = 12345;
+
+static void NoLog (const std::string&) {}
+
+/**
+ * Hardware cache miss counter of the calling thread. Counting is not
+ * available on platforms other than Linux, or when the kernel does not
+ * allow it (e.g., perf_event_paranoid, virtual machines)
+ */
+class CacheMissCounter
+{
+public:
+    CacheMissCounter ()
+    : m_fd{-1}
+    {
+#ifdef __linux__
+        struct perf_event_attr attr;
+        std::memset (&attr, 0, sizeof (attr));
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof (attr);
+        attr.config = PERF_COUNT_HW_CACHE_MISSES;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        m_fd = int (syscall (__NR_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+    }
+
+    ~CacheMissCounter ()
+    {
+#ifdef __linux__
+        if (m_fd >= 0) {
+            close (m_fd);
+        }
+#endif
+    }
+
+    bool IsAvailable () const { return m_fd >= 0; }
+
+    void Start ()
+    {
+#ifdef __linux__
+        if (m_fd >= 0) {
+            ioctl (m_fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl (m_fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    /* Stop counting; returns the number of misses since #Start */
+    uint64_t Stop ()
+    {
+        uint64_t count = 0;
+#ifdef __linux__
+        if (m_fd >= 0) {
+            ioctl (m_fd, PERF_EVENT_IOC_DISABLE, 0);
+            if (read (m_fd, &count, sizeof (count)) != sizeof (count)) {
+                count = 0;
+            }
+        }
+#endif
+        return count;
+    }
+
+private:
+    int m_fd;
+};
+
+/* Parameters of a synthetic trace */
+struct Scenario
+{
+    const char* name;
+    double lossRate;      // independent losses, per packet
+    double burstEnter;    // probability of entering a loss burst, per packet
+    double burstStay;     // probability of the next packet being lost in a burst
+    double reorderRate;   // probability of a packet overtaking its predecessor
+    uint64_t jitterMs;    // uniform extra delay, FIFO order kept
+    uint64_t sawtoothMs;  // peak queuing delay of a 2-second sawtooth
+};
+
+const Scenario BENCH_SCENARIOS[] = {
+    // name              loss   bEnter bStay  reord  jit  saw
+    { "clean",           0.,    0.,    0.,    0.,    0,   0   },
+    { "loss-2%",         0.02,  0.,    0.,    0.,    0,   0   },
+    { "burst-loss",      0.,    0.005, 0.5,   0.,    0,   0   },
+    { "reorder-1%",      0.,    0.,    0.,    0.01,  0,   0   },
+    { "jitter-20ms",     0.,    0.,    0.,    0.,    20,  0   },
+    { "queue-sawtooth",  0.,    0.,    0.,    0.,    0,   200 },
+};
+
+/* A packet being sent, or feedback about it arriving at the sender */
+struct Event
+{
+    uint64_t time;        // us
+    uint64_t rxTimestamp; // us, feedback only
+    uint32_t sequence;
+    bool isFeedback;
+};
+
+static bool EventBefore (const Event& lhs, const Event& rhs)
+{
+    if (lhs.time != rhs.time) {
+        return lhs.time < rhs.time;
+    }
+    // At the same time, send before processing feedback
+    return !lhs.isFeedback && rhs.isFeedback;
+}
+
+/*
+ * Generate the time-ordered events of a scenario. In batched mode, feedback
+ * for all packets received during a report interval arrives at once
+ */
+static std::vector<Event> MakeTrace (const Scenario& sc, size_t npackets,
+                                     bool batched)
+{
+    std::mt19937 rng (BENCH_SEED);
+    std::uniform_real_distribution<double> coin (0., 1.);
+    std::uniform_int_distribution<uint64_t> jitter (0, sc.jitterMs * BENCH_MS);
+
+    std::vector<Event> events;
+    events.reserve (2 * npackets);
+    const uint64_t sawtoothPeriod = 2000 * BENCH_MS;
+    bool inBurst = false;
+    uint64_t lastRx = 0;
+    for (size_t i = 0; i < npackets; ++i) {
+        const uint64_t tx = i * BENCH_PKT_INTERVAL;
+        events.push_back (Event{tx, 0, uint32_t (i), false});
+
+        inBurst = inBurst ? coin (rng) < sc.burstStay : coin (rng) < sc.burstEnter;
+        if (inBurst || coin (rng) < sc.lossRate) {
+            continue;
+        }
+
+        uint64_t owd = BENCH_OWD + jitter (rng);
+        if (sc.sawtoothMs > 0) {
+            owd += (tx % sawtoothPeriod) * (sc.sawtoothMs * BENCH_MS) / sawtoothPeriod;
+        }
+        uint64_t rx = std::max (tx + owd, lastRx); // FIFO link
+        lastRx = rx;
+        if (coin (rng) < sc.reorderRate) {
+            // Held back, so that the next packet overtakes it
+            rx += 2 * BENCH_PKT_INTERVAL;
+        }
+
+        uint64_t fbTime = rx + BENCH_RETURN_DELAY;
+        if (batched) {
+            const uint64_t reportTime =
+                (rx / BENCH_REPORT_INTERVAL + 1) * BENCH_REPORT_INTERVAL;
+            fbTime = reportTime + BENCH_RETURN_DELAY;
+        }
+        events.push_back (Event{fbTime, rx, uint32_t (i), true});
+    }
+    std::stable_sort (events.begin (), events.end (), EventBefore);
+    return events;
+}
+
+struct Result
+{
+    double nsPerOp;
+    double allocsPerOp;
+    double missesPerOp;
+};
+
+static float g_sink = 0.f; // keeps the compiler from discarding bandwidth queries
+
+template <typename CONTROLLER>
+static Result RunTrace (const std::vector<Event>& events, size_t npackets,
+                        bool batched, CacheMissCounter& misses)
+{
+    typedef rmcat::SenderBasedController::FeedbackEntry FeedbackEntry;
+    CONTROLLER controller;
+    controller.setLogCallback (NoLog);
+    // Keep stats in memory, so that no text is formatted while measuring
+    auto stats = std::make_shared<rmcat::ColumnarStatsSink> ();
+    stats->reserve (npackets);
+    controller.setStatsSink (stats);
+    std::vector<FeedbackEntry> batch;
+    batch.reserve (1024);
+
+    const uint64_t allocsBefore = g_allocCount;
+    misses.Start ();
+    const auto start = std::chrono::steady_clock::now ();
+
+    size_t i = 0;
+    while (i < events.size ()) {
+        const Event& ev = events[i];
+        if (!ev.isFeedback) {
+            controller.processSendPacket (ev.time, ev.sequence, BENCH_PKT_SIZE);
+            g_sink += controller.getBandwidth (ev.time);
+            ++i;
+        } else if (!batched) {
+            controller.processFeedback (ev.time, ev.sequence, ev.rxTimestamp);
+            ++i;
+        } else {
+            batch.clear ();
+            for (; i < events.size () && events[i].isFeedback &&
+                   events[i].time == ev.time; ++i) {
+                batch.push_back (FeedbackEntry{events[i].sequence,
+                                               events[i].rxTimestamp,
+                                               0});
+            }
+            controller.processFeedbackBatch (ev.time, batch.data (), batch.size ());
+        }
+    }
+
+    const auto stop = std::chrono::steady_clock::now ();
+    const uint64_t missCount = misses.Stop ();
+    const uint64_t allocs = g_allocCount - allocsBefore;
+    const double ns = double (std::chrono::duration_cast<std::chrono::nanoseconds> (stop - start).count ());
+
+    return Result{ns / double (npackets),
+                  double (allocs) / double (npackets),
+                  double (missCount) / double (npackets)};
+}
+
+static void PrintResult (const char* controller, const char* scenario,
+                         const char* mode, const Result& r, bool missesAvailable)
+{
+    std::printf ("%-8s %-16s %-8s %10.1f %10.4f ", controller, scenario, mode,
+                 r.nsPerOp, r.allocsPerOp);
+    if (missesAvailable) {
+        std::printf ("%12.3f\n", r.missesPerOp);
+    } else {
+        std::printf ("%12s\n", "n/a");
+    }
+}
+
+/*
+ * Push at the back and pop at the front, as the controllers do with
+ * their packet history
+ */
+template <typename CONTAINER>
+static double FifoAllocsPerPacket (CONTAINER& c, size_t npackets)
+{
+    const uint64_t before = g_allocCount;
+    for (size_t i = 0; i < npackets; ++i) {
+        c.push_back (rmcat::PacketRecord{uint32_t (i),
+                                         i * BENCH_PKT_INTERVAL,
+                                         BENCH_PKT_SIZE,
+                                         0,
+                                         0,
+                                         0});
+        if (c.size () > BENCH_BACKLOG) {
+            c.pop_front ();
+        }
+    }
+    return double (g_allocCount - before) / double (npackets);
+}
+
+int main (int argc, char *argv[])
+{
+    size_t npackets = BENCH_DEFAULT_NPACKETS;
+    if (argc > 1) {
+        npackets = size_t (std::strtoul (argv[1], NULL, 10));
+        if (npackets == 0) {
+            std::fprintf (stderr, "Usage: %s [number of packets]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    std::deque<rmcat::PacketRecord> dq;
+    rmcat::PacketRing ring;
+    ring.reserve (BENCH_BACKLOG + 1);
+    std::printf ("%-28s %12s\n", "container", "allocs/pkt");
+    std::printf ("%-28s %12.6f\n", "fifo std::deque", FifoAllocsPerPacket (dq, npackets));
+    std::printf ("%-28s %12.6f\n", "fifo rmcat::PacketRing", FifoAllocsPerPacket (ring, npackets));
+    std::printf ("\n");
+
+    CacheMissCounter misses;
+    const bool missesAvailable = misses.IsAvailable ();
+    std::printf ("%-8s %-16s %-8s %10s %10s %12s\n", "algo", "scenario",
+                 "feedback", "ns/op", "allocs/op", "misses/op");
+
+    for (const Scenario& sc : BENCH_SCENARIOS) {
+        for (bool batched : {false, true}) {
+            const std::vector<Event> events = MakeTrace (sc, npackets, batched);
+            const char* mode = batched ? "batch" : "per-pkt";
+            PrintResult ("nada", sc.name, mode,
+                         RunTrace<rmcat::NadaController> (events, npackets,
+                                                          batched, misses),
+                         missesAvailable);
+            PrintResult ("dummy", sc.name, mode,
+                         RunTrace<rmcat::DummyController> (events, npackets,
+                                                           batched, misses),
+                         missesAvailable);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,225 @@
+/******************************************************************************
+ * Copyright 2016-2017 Cisco Systems, Inc.                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ *                                                                            *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+/**
+ * @file
+ * Offline replay of a packet trace (see packet-trace.h) into a congestion
+ * controller. It does not depend on ns3.
+ *
+ * Send events are delivered in trace order, feedback events in order of
+ * their arrival time, both merged on a single timeline. The controller's
+ * log lines are printed to stdout with the same "controller_log: " prefix
+ * as in simulation logs, so they can be processed with
+ * tools/process_test_logs.py.
+ *
+ * Usage: rmcat-trace-replay [-a nada|dummy] [-b] [-q] [-s stats file]
+ *                           [-w reorder window] <trace file>
+ *   -a  controller to replay the trace into (default: nada)
+ *   -b  deliver feedback arriving at the same time as one batch
+ *   -q  do not print the controller's log lines
+ *   -s  write the controller's statistics to a binary stats file (see
+ *       stats-sink.h) rather than printing them as log lines
+ *   -w  reordering tolerated by the controller, in packets (see
+ *       SenderBasedController::setReorderWindow)
+ *
+ * @version 0.1.0
+ * @author Jiantao Fu
+ * @author Sergio Mena
+ * @author Xiaoqing Zhu
+ */
+
+#include "packet-trace.h"
+#include "nada-controller.h"
+#include "dummy-controller.h"
+#include <chrono>
+#include <memory>
+#include <queue>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+typedef rmcat::SenderBasedController::FeedbackEntry FeedbackEntry;
+
+/* Feedback about a packet, waiting for its arrival time */
+struct PendingFeedback
+{
+    uint64_t time;
+    uint64_t order;  // ties are broken in trace order
+    FeedbackEntry entry;
+
+    bool operator> (const PendingFeedback& other) const
+    {
+        return time != other.time ? time > other.time : order > other.order;
+    }
+};
+
+typedef std::priority_queue<PendingFeedback,
+                            std::vector<PendingFeedback>,
+                            std::greater<PendingFeedback> > FeedbackQueue;
+
+static void PrintLog (const std::string& log)
+{
+    std::fputs ("controller_log: ", stdout);
+    std::fputs (log.c_str (), stdout);
+    std::fputc ('\n', stdout);
+}
+
+static void NoLog (const std::string&) {}
+
+static void Usage (const char* prog)
+{
+    std::fprintf (stderr, "Usage: %s [-a nada|dummy] [-b] [-q] [-s stats file] "
+                  "[-w reorder window] <trace file>\n", prog);
+}
+
+/*
+ * Deliver all feedback arriving before (or, if inclusive, at) the given
+ * time; returns the number of feedback entries delivered
+ */
+static uint64_t DeliverFeedback (rmcat::SenderBasedController& controller,
+                                 FeedbackQueue& queue, uint64_t until,
+                                 bool inclusive, bool batched,
+                                 std::vector<FeedbackEntry>& batch)
+{
+    uint64_t n = 0;
+    while (!queue.empty () &&
+           (queue.top ().time < until || (inclusive && queue.top ().time == until))) {
+        const uint64_t now = queue.top ().time;
+        if (!batched) {
+            const FeedbackEntry& e = queue.top ().entry;
+            controller.processFeedback (now, e.sequence, e.rxTimestamp, e.ecn);
+            queue.pop ();
+            ++n;
+            continue;
+        }
+        batch.clear ();
+        while (!queue.empty () && queue.top ().time == now) {
+            batch.push_back (queue.top ().entry);
+            queue.pop ();
+        }
+        controller.processFeedbackBatch (now, batch.data (), batch.size ());
+        n += batch.size ();
+    }
+    return n;
+}
+
+int main (int argc, char *argv[])
+{
+    std::string algo = "nada";
+    bool batched = false;
+    bool quiet = false;
+    const char* path = NULL;
+    const char* statsPath = NULL;
+    long reorderWindow = -1; // controller default
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp (argv[i], "-a") == 0 && i + 1 < argc) {
+            algo = argv[++i];
+        } else if (std::strcmp (argv[i], "-b") == 0) {
+            batched = true;
+        } else if (std::strcmp (argv[i], "-q") == 0) {
+            quiet = true;
+        } else if (std::strcmp (argv[i], "-s") == 0 && i + 1 < argc) {
+            statsPath = argv[++i];
+        } else if (std::strcmp (argv[i], "-w") == 0 && i + 1 < argc) {
+            reorderWindow = std::atol (argv[++i]);
+        } else if (argv[i][0] != '-' && path == NULL) {
+            path = argv[i];
+        } else {
+            Usage (argv[0]);
+            return 1;
+        }
+    }
+    if (path == NULL) {
+        Usage (argv[0]);
+        return 1;
+    }
+
+    std::unique_ptr<rmcat::SenderBasedController> controller;
+    if (algo == "nada") {
+        controller.reset (new rmcat::NadaController{});
+    } else if (algo == "dummy") {
+        controller.reset (new rmcat::DummyController{});
+    } else {
+        std::fprintf (stderr, "Unknown controller: %s\n", algo.c_str ());
+        return 1;
+    }
+    controller->setLogCallback (quiet ? NoLog : PrintLog);
+    if (reorderWindow >= 0) {
+        controller->setReorderWindow (size_t (reorderWindow));
+    }
+
+    std::shared_ptr<rmcat::BinaryStatsSink> statsSink;
+    if (statsPath != NULL) {
+        statsSink = std::make_shared<rmcat::BinaryStatsSink> ();
+        if (!statsSink->open (statsPath)) {
+            std::fprintf (stderr, "Cannot create stats file: %s\n", statsPath);
+            return 1;
+        }
+        controller->setStatsSink (statsSink);
+    }
+
+    rmcat::PacketTraceReader reader;
+    if (!reader.open (path)) {
+        std::fprintf (stderr, "Cannot open trace file: %s\n", path);
+        return 1;
+    }
+
+    FeedbackQueue queue;
+    std::vector<FeedbackEntry> batch;
+    uint64_t nSent = 0;
+    uint64_t nFeedback = 0;
+    double bwSum = 0.; // bandwidth is queried as a sender would, before sending
+
+    const auto start = std::chrono::steady_clock::now ();
+    rmcat::TraceRecord record;
+    while (reader.read (record)) {
+        // Feedback arriving at the same time as a send is processed after it
+        nFeedback += DeliverFeedback (*controller, queue, record.txTimestamp,
+                                      false, batched, batch);
+        bwSum += controller->getBandwidth (record.txTimestamp);
+        controller->processSendPacket (record.txTimestamp, record.sequence,
+                                       record.size);
+        if (record.received) {
+            queue.push (PendingFeedback{record.fbTimestamp, nSent,
+                                        FeedbackEntry{record.sequence,
+                                                      record.rxTimestamp,
+                                                      record.ecn}});
+        }
+        ++nSent;
+    }
+    while (!queue.empty ()) {
+        nFeedback += DeliverFeedback (*controller, queue, queue.top ().time,
+                                      true, batched, batch);
+    }
+    const auto stop = std::chrono::steady_clock::now ();
+    controller->logEventCounters ();
+
+    std::fflush (stdout);
+    if (statsSink) {
+        statsSink->close ();
+    }
+    const double secs = std::chrono::duration<double> (stop - start).count ();
+    const uint64_t nEvents = nSent + nFeedback;
+    std::fprintf (stderr, "replayed %llu packets, %llu feedback entries "
+                  "in %.3f s (%.0f events/s), mean bandwidth %.0f bps\n",
+                  (unsigned long long) nSent, (unsigned long long) nFeedback,
+                  secs, secs > 0. ? double (nEvents) / secs : 0.,
+                  nSent > 0 ? bwSum / double (nSent) : 0.);
+    return 0;
+}
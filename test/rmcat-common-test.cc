@@ -27,6 +27,9 @@
 
 #include "rmcat-common-test.h"
 #include "ns3/log.h"
+#include "ns3/abort.h"
+#include <cstdio>
+#include <cstdlib>
 
 using namespace ns3;
 
@@ -78,3 +81,36 @@ void RmcatTestCase::DoTeardown ()
     std::clog.rdbuf (m_sb);
     m_ofs.close ();
 }
+
+/* Base class of sharded RMCAT test suites: constructor */
+RmcatShardedTestSuite::RmcatShardedTestSuite (std::string name,
+                                              TestSuite::Type type)
+: TestSuite{name, type}
+, m_shard{0}
+, m_numShards{1}
+, m_numCases{0}
+{
+    const char* shard = std::getenv ("RMCAT_TC_SHARD");
+    if (shard == NULL || *shard == '\0') {
+        return;
+    }
+    unsigned k = 0;
+    unsigned n = 0;
+    char extra = '\0';
+    NS_ABORT_MSG_UNLESS (std::sscanf (shard, "%u/%u%c", &k, &n, &extra) == 2 && k < n,
+                         "RMCAT_TC_SHARD must be k/N with 0 <= k < N, not " << shard);
+    m_shard = k;
+    m_numShards = n;
+}
+
+void RmcatShardedTestSuite::AddShardedTestCase (TestCase * testCase,
+                                                TestCase::TestDuration duration)
+{
+    // Round robin: consecutive (often similar) test cases
+    // go to different shards, which balances their load
+    if (m_numCases++ % m_numShards == m_shard) {
+        AddTestCase (testCase, duration);
+    } else {
+        delete testCase;
+    }
+}
@@ -44,6 +44,18 @@ const uint32_t RMCAT_TC_RINIT = 150 * (1u << 10);  // R_init: 150 Kbps
 const uint32_t RMCAT_TC_RMIN = 150 * (1u << 10);   // R_min:  150 Kbps
 const uint32_t RMCAT_TC_RMAX = 1500 * (1u << 10);  // R_max: 1500 Kbps
 
+const double RMCAT_TC_AUDIO_FPS = 50.;       // audio: one packet every 20 ms
+const double RMCAT_TC_AUDIO_WEIGHT = 0.0625; // audio:video priority 1:16
+
+const double RMCAT_TC_JITTER_MAX_MS = 10.;        // uniform jitter: 0-10 ms
+const double RMCAT_TC_JITTER_PARETO_MEAN_MS = 2.; // Pareto jitter: heavy tail,
+const double RMCAT_TC_JITTER_PARETO_SHAPE = 1.5;  //   bounded at 50 ms
+const double RMCAT_TC_JITTER_PARETO_BOUND_MS = 50.;
+
+// checks after the simulation: rates are only compared once
+// they had time to settle after a change (flows, capacity)
+const uint32_t RMCAT_TC_CHECK_SETTLE = 10; // in seconds
+
 // default port assignment: base numbers
 const uint32_t RMCAT_TC_CBR_UDP_PORT   = 4000;
 const uint32_t RMCAT_TC_LONG_TCP_PORT  = 6000;
@@ -82,4 +94,30 @@ protected:
     uint32_t m_qdelay;     // bottleneck queue depth (in ms)
 };
 
+/*
+ * Base class of RMCAT test suites whose test cases
+ * can be split among several processes running the
+ * same suite (see tools/run_parallel.py)
+ *
+ * Environment variable RMCAT_TC_SHARD=k/N (0 <= k < N)
+ * makes the suite keep only every N-th test case,
+ * starting with the k-th, in the order they are added.
+ * If not set, all test cases are kept.
+ */
+class RmcatShardedTestSuite : public ns3::TestSuite
+{
+public:
+    RmcatShardedTestSuite (std::string name, ns3::TestSuite::Type type);
+
+protected:
+    /* Add test case if in this process's shard, else delete it */
+    void AddShardedTestCase (ns3::TestCase * testCase,
+                             ns3::TestCase::TestDuration duration);
+
+private:
+    uint32_t m_shard;       // k: index of this process's shard
+    uint32_t m_numShards;   // N: 1 if not sharded
+    uint32_t m_numCases;    // test cases seen so far, kept or not
+};
+
 #endif /* RMCAT_COMMON_TEST_H */
@@ -0,0 +1,944 @@
+/******************************************************************************
+ * Copyright 2016-2017 Cisco Systems, Inc.                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ *                                                                            *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+/**
+ * @file
+ * Unit tests of the congestion controllers and the flow state exchange,
+ * driven directly, without a simulated network.
+ *
+ * @version 0.1.0
+ * @author Jiantao Fu
+ * @author Sergio Mena
+ * @author Xiaoqing Zhu
+ */
+
+#include "ns3/test.h"
+#include "ns3/dummy-controller.h"
+#include "ns3/nada-controller.h"
+#include "ns3/flow-state-exchange.h"
+#include "ns3/stats-sink.h"
+#include "ns3/packet-ring.h"
+#include "ns3/in-transit-table.h"
+
+#include <algorithm>
+#include <deque>
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace ns3;
+
+/* Rates are compared to the bps */
+static const double RMCAT_TC_RATE_TOL = 1.;
+
+/* Queuing delay beyond which NADA leaves accelerated ramp-up (QEPS, see Sec. 4.3 of rmcat-nada) */
+static const uint64_t RMCAT_TC_NADA_QEPS = 10 * 1000;  // us
+
+/* Marking penalty of NADA's x_curr (see Sec. 4.2 of rmcat-nada) */
+static const float RMCAT_TC_NADA_DMARK = 2.;     // ms
+static const float RMCAT_TC_NADA_PMRREF = 0.01;
+
+/*
+ * Flow state exchange: split of the aggregate by
+ * priority, capping at the maximum rates, minimum
+ * rates reserved, and deregistration
+ */
+class FlowStateExchangeTestCase : public TestCase
+{
+public:
+    FlowStateExchangeTestCase ();
+
+private:
+    typedef std::shared_ptr<rmcat::DummyController> Controller;
+
+    virtual void DoRun ();
+    void CheckRate (const rmcat::FlowStateExchange& fse, uint32_t id,
+                    const Controller& controller, double expected);
+    void CheckSum (const rmcat::FlowStateExchange& fse, uint32_t id1, uint32_t id2);
+};
+
+FlowStateExchangeTestCase::FlowStateExchangeTestCase ()
+: TestCase{"rmcat-controller-fse"}
+{}
+
+/* The rate assigned is the expected one, and the controller was told */
+void FlowStateExchangeTestCase::CheckRate (const rmcat::FlowStateExchange& fse, uint32_t id,
+                                           const Controller& controller, double expected)
+{
+    NS_TEST_ASSERT_MSG_EQ_TOL (fse.getRate (id), expected, RMCAT_TC_RATE_TOL,
+                               "Wrong rate assigned to flow " << id);
+    NS_TEST_ASSERT_MSG_EQ_TOL (controller->getBandwidth (0), expected, RMCAT_TC_RATE_TOL,
+                               "Controller of flow " << id << " not told its rate");
+}
+
+/* The rates assigned add up to the aggregate */
+void FlowStateExchangeTestCase::CheckSum (const rmcat::FlowStateExchange& fse,
+                                          uint32_t id1, uint32_t id2)
+{
+    NS_TEST_ASSERT_MSG_EQ_TOL (fse.getRate (id1) + fse.getRate (id2), fse.getAggregateRate (),
+                               RMCAT_TC_RATE_TOL, "Rates assigned do not add up to the aggregate");
+}
+
+void FlowStateExchangeTestCase::DoRun ()
+{
+    const float maxRate = 10e6;
+
+    // Split by priority, 1:3
+    {
+        rmcat::FlowStateExchange fse;
+        Controller c1 = std::make_shared<rmcat::DummyController> ();
+        Controller c2 = std::make_shared<rmcat::DummyController> ();
+        const auto id1 = fse.registerFlow (c1, 1.f, 0.f, maxRate, 3e6);
+        CheckRate (fse, id1, c1, 3e6);
+        const auto id2 = fse.registerFlow (c2, 3.f, 0.f, maxRate, 1e6);
+        NS_TEST_ASSERT_MSG_EQ (fse.getNumFlows (), 2, "Wrong number of flows");
+        NS_TEST_ASSERT_MSG_EQ_TOL (fse.getAggregateRate (), 4e6, RMCAT_TC_RATE_TOL,
+                                   "Wrong aggregate");
+        CheckRate (fse, id1, c1, 1e6);
+        CheckRate (fse, id2, c2, 3e6);
+
+        // Flow 1's controller goes from 1 to 2 Mbps: the aggregate grows
+        // by 1 Mbps, still split 1:3
+        const auto rate = fse.updateRate (id1, 2e6);
+        NS_TEST_ASSERT_MSG_EQ_TOL (rate, 1.25e6, RMCAT_TC_RATE_TOL, "Wrong rate returned");
+        CheckRate (fse, id1, c1, 1.25e6);
+        CheckRate (fse, id2, c2, 3.75e6);
+        CheckSum (fse, id1, id2);
+
+        // Same rate calculated again: nothing changes
+        fse.updateRate (id2, 3.75e6);
+        CheckRate (fse, id1, c1, 1.25e6);
+        CheckRate (fse, id2, c2, 3.75e6);
+
+        // Flow 2 leaves with its share; flow 1 gets the rest
+        fse.deregisterFlow (id2);
+        NS_TEST_ASSERT_MSG_EQ (fse.getNumFlows (), 1, "Wrong number of flows");
+        NS_TEST_ASSERT_MSG_EQ_TOL (fse.getAggregateRate (), 1.25e6, RMCAT_TC_RATE_TOL,
+                                   "Share of the flow deregistered not removed");
+        CheckRate (fse, id1, c1, 1.25e6);
+        fse.updateRate (id1, 2e6);
+        CheckRate (fse, id1, c1, 2e6);
+
+        fse.deregisterFlow (id1);
+        NS_TEST_ASSERT_MSG_EQ (fse.getNumFlows (), 0, "Wrong number of flows");
+        NS_TEST_ASSERT_MSG_EQ_TOL (fse.getAggregateRate (), 0., RMCAT_TC_RATE_TOL,
+                                   "Aggregate left with no flows");
+    }
+
+    // Capping: flow 1's equal share is above its maximum, flow 2 gets
+    // the leftover
+    {
+        rmcat::FlowStateExchange fse;
+        Controller c1 = std::make_shared<rmcat::DummyController> ();
+        Controller c2 = std::make_shared<rmcat::DummyController> ();
+        const auto id1 = fse.registerFlow (c1, 1.f, 0.f, 1e6, 1e6);
+        const auto id2 = fse.registerFlow (c2, 1.f, 0.f, maxRate, 3e6);
+        CheckRate (fse, id1, c1, 1e6);
+        CheckRate (fse, id2, c2, 3e6);
+        CheckSum (fse, id1, id2);
+
+        // The aggregate does not grow beyond the sum of the maximum rates
+        fse.updateRate (id2, 20e6);
+        CheckRate (fse, id1, c1, 1e6);
+        CheckRate (fse, id2, c2, maxRate);
+        NS_TEST_ASSERT_MSG_EQ_TOL (fse.getAggregateRate (), 11e6, RMCAT_TC_RATE_TOL,
+                                   "Aggregate above the sum of the maximum rates");
+    }
+
+    // Minimum rates are reserved first, the rest is split 1:3
+    {
+        rmcat::FlowStateExchange fse;
+        Controller c1 = std::make_shared<rmcat::DummyController> ();
+        Controller c2 = std::make_shared<rmcat::DummyController> ();
+        const auto id1 = fse.registerFlow (c1, 1.f, 1e6, maxRate, 1.5e6);
+        const auto id2 = fse.registerFlow (c2, 3.f, 0.f, maxRate, 0.5e6);
+        CheckRate (fse, id1, c1, 1.25e6);
+        CheckRate (fse, id2, c2, 0.75e6);
+        CheckSum (fse, id1, id2);
+    }
+
+    // Capping applies to the share on top of the minimum rate
+    {
+        rmcat::FlowStateExchange fse;
+        Controller c1 = std::make_shared<rmcat::DummyController> ();
+        Controller c2 = std::make_shared<rmcat::DummyController> ();
+        const auto id1 = fse.registerFlow (c1, 1.f, 1e6, 2e6, 2e6);
+        const auto id2 = fse.registerFlow (c2, 1.f, 0.f, maxRate, 4e6);
+        CheckRate (fse, id1, c1, 2e6);
+        CheckRate (fse, id2, c2, 4e6);
+        CheckSum (fse, id1, id2);
+    }
+
+    // Aggregate below the sum of the minimum rates: raised to it
+    {
+        rmcat::FlowStateExchange fse;
+        Controller c1 = std::make_shared<rmcat::DummyController> ();
+        Controller c2 = std::make_shared<rmcat::DummyController> ();
+        const auto id1 = fse.registerFlow (c1, 1.f, 1e6, maxRate, 0.2e6);
+        const auto id2 = fse.registerFlow (c2, 3.f, 1e6, maxRate, 0.2e6);
+        CheckRate (fse, id1, c1, 1e6);
+        CheckRate (fse, id2, c2, 1e6);
+        CheckSum (fse, id1, id2);
+
+        fse.updateRate (id1, 0.f);
+        CheckRate (fse, id1, c1, 1e6);
+        CheckRate (fse, id2, c2, 1e6);
+    }
+}
+
+/*
+ * Packet ring: same contents as a std::deque through
+ * wrap-around, growth while wrapped, reservation and
+ * pops across the power-of-two boundary; and buffers
+ * dimensioned after the controller's maximal rate
+ */
+class PacketRingTestCase : public TestCase
+{
+public:
+    PacketRingTestCase ();
+
+private:
+    typedef std::deque<rmcat::PacketRecord> Reference;
+
+    virtual void DoRun ();
+    void Push (rmcat::PacketRing& ring, Reference& ref, uint32_t n);
+    void Pop (rmcat::PacketRing& ring, Reference& ref, uint32_t n);
+    void CheckContents (const rmcat::PacketRing& ring, const Reference& ref);
+};
+
+/* Controller whose packet record buffers can be checked */
+class RingNadaController : public rmcat::NadaController
+{
+public:
+    using rmcat::SenderBasedController::m_inTransitPackets;
+    using rmcat::SenderBasedController::m_packetHistory;
+};
+
+PacketRingTestCase::PacketRingTestCase ()
+: TestCase{"rmcat-controller-packet-ring"}
+{}
+
+/* Append n records, sequences going on from the newest one, across the uint32_t wrap */
+void PacketRingTestCase::Push (rmcat::PacketRing& ring, Reference& ref, uint32_t n)
+{
+    for (uint32_t i = 0; i < n; ++i) {
+        const uint32_t seq = ref.empty () ? 0xfffffff0u : ref.back ().sequence + 1;
+        const uint64_t tx = uint64_t (seq) * 1000;
+        const rmcat::PacketRecord record{seq, tx, 1000 + seq % 7, tx % 97, tx % 89,
+                                         uint8_t (seq & rmcat::ECN_CE)};
+        ring.push_back (record);
+        ref.push_back (record);
+    }
+}
+
+void PacketRingTestCase::Pop (rmcat::PacketRing& ring, Reference& ref, uint32_t n)
+{
+    for (uint32_t i = 0; i < n; ++i) {
+        ring.pop_front ();
+        ref.pop_front ();
+    }
+}
+
+void PacketRingTestCase::CheckContents (const rmcat::PacketRing& ring, const Reference& ref)
+{
+    NS_TEST_ASSERT_MSG_EQ (ring.size (), ref.size (), "Wrong size");
+    NS_TEST_ASSERT_MSG_EQ (ring.empty (), ref.empty (), "Wrong emptiness");
+    NS_TEST_ASSERT_MSG_EQ (ring.capacity () >= ring.size (), true, "Size beyond capacity");
+    const size_t capacity = ring.capacity ();
+    NS_TEST_ASSERT_MSG_EQ (capacity & (capacity - 1), 0, "Capacity not a power of two");
+    for (size_t i = 0; i < ref.size (); ++i) {
+        const rmcat::PacketRecord record = ring.at (i);
+        NS_TEST_ASSERT_MSG_EQ (record.sequence, ref[i].sequence, "Wrong sequence at " << i);
+        NS_TEST_ASSERT_MSG_EQ (record.txTimestamp, ref[i].txTimestamp, "Wrong timestamp at " << i);
+        NS_TEST_ASSERT_MSG_EQ (record.size, ref[i].size, "Wrong size at " << i);
+        NS_TEST_ASSERT_MSG_EQ (record.owd, ref[i].owd, "Wrong owd at " << i);
+        NS_TEST_ASSERT_MSG_EQ (record.rtt, ref[i].rtt, "Wrong rtt at " << i);
+        NS_TEST_ASSERT_MSG_EQ (record.ecn, ref[i].ecn, "Wrong ecn at " << i);
+        NS_TEST_ASSERT_MSG_EQ (ring.sequence (i), ref[i].sequence, "Wrong sequence field at " << i);
+        NS_TEST_ASSERT_MSG_EQ (ring.owd (i), ref[i].owd, "Wrong owd field at " << i);
+    }
+    if (!ref.empty ()) {
+        NS_TEST_ASSERT_MSG_EQ (ring.front ().sequence, ref.front ().sequence, "Wrong front");
+        NS_TEST_ASSERT_MSG_EQ (ring.back ().sequence, ref.back ().sequence, "Wrong back");
+    }
+}
+
+void PacketRingTestCase::DoRun ()
+{
+    rmcat::PacketRing ring;
+    Reference ref;
+    const size_t initial = ring.capacity ();
+    CheckContents (ring, ref);
+
+    // Wrap around: the oldest record sits in the middle of the buffer
+    Push (ring, ref, initial - 2);
+    Pop (ring, ref, initial / 2);
+    Push (ring, ref, initial / 2);
+    NS_TEST_ASSERT_MSG_EQ (ring.capacity (), initial, "Grown before being full");
+    CheckContents (ring, ref);
+
+    // Growth while wrapped: the records are unrolled in order
+    Push (ring, ref, 3);
+    NS_TEST_ASSERT_MSG_EQ (ring.capacity (), 2 * initial, "Not doubled when full");
+    CheckContents (ring, ref);
+
+    // Pops across the power-of-two boundary, in and out of a full ring
+    Push (ring, ref, ring.capacity () - ring.size ());
+    Pop (ring, ref, ring.capacity () - 1);
+    Push (ring, ref, ring.capacity () - 1);
+    NS_TEST_ASSERT_MSG_EQ (ring.size (), ring.capacity (), "Ring not full");
+    for (size_t n = 0; n < 3 * ring.capacity (); ++n) {
+        Pop (ring, ref, 1);
+        Push (ring, ref, 1);
+    }
+    NS_TEST_ASSERT_MSG_EQ (ring.capacity (), 2 * initial, "Grown in steady state");
+    CheckContents (ring, ref);
+
+    // Reservation while wrapped keeps the records; it never shrinks
+    ring.reserve (5 * initial);
+    NS_TEST_ASSERT_MSG_EQ (ring.capacity (), 8 * initial, "Not rounded up to a power of two");
+    CheckContents (ring, ref);
+    ring.reserve (initial);
+    NS_TEST_ASSERT_MSG_EQ (ring.capacity (), 8 * initial, "Shrunk");
+
+    // Emptied, then cleared: capacity kept, records gone
+    Pop (ring, ref, ref.size ());
+    CheckContents (ring, ref);
+    Push (ring, ref, initial);
+    ring.clear ();
+    ref.clear ();
+    NS_TEST_ASSERT_MSG_EQ (ring.capacity (), 8 * initial, "Capacity not kept by clear");
+    CheckContents (ring, ref);
+
+    // Controllers dimension their buffers after the maximal rate: a 20 Mbps
+    // flow keeps at least 0.5 s of 1000-byte packets in its history, and
+    // 5 s of them in transit, without growing
+    RingNadaController controller;
+    const size_t history = controller.m_packetHistory.capacity ();
+    const size_t inTransit = controller.m_inTransitPackets.capacity ();
+    controller.setMaxBw (20e6);
+    NS_TEST_ASSERT_MSG_EQ (controller.m_packetHistory.capacity () > history, true,
+                           "History not dimensioned after the maximal rate");
+    NS_TEST_ASSERT_MSG_EQ (controller.m_packetHistory.capacity () >= 20e6 / 8 / 1000 / 2, true,
+                           "History too small for the maximal rate");
+    NS_TEST_ASSERT_MSG_EQ (controller.m_inTransitPackets.capacity () > inTransit, true,
+                           "In-transit table not dimensioned after the maximal rate");
+    NS_TEST_ASSERT_MSG_EQ (controller.m_inTransitPackets.capacity () >= 20e6 / 8 / 1000 * 5, true,
+                           "In-transit table too small for the maximal rate");
+}
+
+/* Controller whose delay and loss metrics, and packet records, can be checked */
+class MetricsDummyController : public rmcat::DummyController
+{
+public:
+    using rmcat::SenderBasedController::getCurrentQdelay;
+    using rmcat::SenderBasedController::getCurrentRTT;
+    using rmcat::SenderBasedController::getMaxQdelay;
+    using rmcat::SenderBasedController::getPktLossInfo;
+    using rmcat::SenderBasedController::m_inTransitPackets;
+    using rmcat::SenderBasedController::m_packetHistory;
+    using rmcat::SenderBasedController::m_baseDelay;
+};
+
+/*
+ * In-transit table and feedback accounting: out of
+ * order, duplicate, stale, future and missing feedback
+ * counted as such, losses declared beyond the reorder
+ * window, and one way delays and round trip times of
+ * the packets moved to the history
+ */
+class FeedbackAccountingTestCase : public TestCase
+{
+public:
+    FeedbackAccountingTestCase ();
+
+private:
+    virtual void DoRun ();
+    void CheckTable ();
+    bool Feedback (MetricsDummyController& controller, uint32_t seq);
+
+    uint64_t m_now;                 // time of the last feedback, never decreasing
+    std::vector<uint64_t> m_fbTime; // time of the first feedback about each packet
+};
+
+/* Packet seq is sent at TX0 + seq * INTERVAL, received OWD(seq) later, and
+ * its feedback reaches the sender FB_LAG after that, or later if it comes
+ * after feedback about later packets */
+static const uint64_t RMCAT_TC_FB_TX0 = 1000 * 1000;     // us
+static const uint64_t RMCAT_TC_FB_INTERVAL = 10 * 1000;  // us
+static const uint64_t RMCAT_TC_FB_LAG = 30 * 1000;       // us
+
+static uint64_t FbTx (uint32_t seq)
+{
+    return RMCAT_TC_FB_TX0 + seq * RMCAT_TC_FB_INTERVAL;
+}
+
+static uint64_t FbOwd (uint32_t seq)
+{
+    return 40 * 1000 + (seq % 4) * 1000;
+}
+
+FeedbackAccountingTestCase::FeedbackAccountingTestCase ()
+: TestCase{"rmcat-controller-feedback-accounting"}
+, m_now{0}
+, m_fbTime{}
+{}
+
+bool FeedbackAccountingTestCase::Feedback (MetricsDummyController& controller, uint32_t seq)
+{
+    const uint64_t rx = FbTx (seq) + FbOwd (seq);
+    m_now = std::max (m_now, rx + RMCAT_TC_FB_LAG);
+    if (seq < m_fbTime.size () && m_fbTime[seq] == 0) {
+        m_fbTime[seq] = m_now;
+    }
+    return controller.processFeedback (m_now, seq, rx);
+}
+
+/* Direct-mapped table: ranges across the uint32_t wrap, out of order acks, growth */
+void FeedbackAccountingTestCase::CheckTable ()
+{
+    rmcat::InTransitTable table;
+    const size_t initial = table.capacity ();
+    const uint32_t first = 0xfffffffau;
+    for (uint32_t i = 0; i < initial; ++i) {
+        table.push_back (rmcat::PacketRecord{first + i, FbTx (i), 1000, 0, 0, rmcat::ECN_NOT_ECT});
+    }
+    NS_TEST_ASSERT_MSG_EQ (table.size (), initial, "Wrong range");
+    NS_TEST_ASSERT_MSG_EQ (table.firstSequence (), first, "Wrong first sequence");
+    NS_TEST_ASSERT_MSG_EQ (table.contains (first - 1), false, "Sequence before the range contained");
+    NS_TEST_ASSERT_MSG_EQ (table.contains (first + initial), false, "Sequence after the range contained");
+    NS_TEST_ASSERT_MSG_EQ (table.contains (0), true, "Wrapped sequence not contained");
+
+    // Acked out of order, then grown with the range across the wrap
+    table.ack (first + 7, 111, 222, rmcat::ECN_CE);
+    table.ack (first + 2, 333, 444, rmcat::ECN_ECT0);
+    table.push_back (rmcat::PacketRecord{uint32_t (first + initial), FbTx (initial), 1000, 0, 0,
+                                         rmcat::ECN_NOT_ECT});
+    NS_TEST_ASSERT_MSG_EQ (table.capacity (), 2 * initial, "Not doubled when full");
+    for (uint32_t i = 0; i <= initial; ++i) {
+        const uint32_t seq = first + i;
+        const bool acked = (i == 7 || i == 2);
+        NS_TEST_ASSERT_MSG_EQ (table.isAcked (seq), acked, "Wrong ack state of " << seq);
+        NS_TEST_ASSERT_MSG_EQ (table.record (seq).sequence, seq, "Wrong record for " << seq);
+        NS_TEST_ASSERT_MSG_EQ (table.record (seq).txTimestamp, FbTx (i), "Wrong timestamp of " << seq);
+    }
+    NS_TEST_ASSERT_MSG_EQ (table.record (first + 7).owd, 111, "Wrong owd");
+    NS_TEST_ASSERT_MSG_EQ (table.record (first + 7).rtt, 222, "Wrong rtt");
+    NS_TEST_ASSERT_MSG_EQ (table.record (first + 7).ecn, rmcat::ECN_CE, "Wrong ecn");
+    NS_TEST_ASSERT_MSG_EQ (table.record (first + 2).owd, 333, "Wrong owd");
+
+    // Popped across the wrap
+    for (uint32_t i = 0; i < 7; ++i) {
+        table.pop_front ();
+    }
+    NS_TEST_ASSERT_MSG_EQ (table.firstSequence (), first + 7, "Wrong first sequence");
+    NS_TEST_ASSERT_MSG_EQ (table.frontAcked (), true, "Front not acked");
+    NS_TEST_ASSERT_MSG_EQ (table.front ().owd, 111, "Wrong front record");
+    NS_TEST_ASSERT_MSG_EQ (table.contains (first + 2), false, "Popped sequence contained");
+    table.clear ();
+    NS_TEST_ASSERT_MSG_EQ (table.empty (), true, "Not cleared");
+    NS_TEST_ASSERT_MSG_EQ (table.capacity (), 2 * initial, "Capacity not kept by clear");
+}
+
+void FeedbackAccountingTestCase::DoRun ()
+{
+    CheckTable ();
+
+    MetricsDummyController controller;
+    controller.setStatsSink (std::make_shared<rmcat::ColumnarStatsSink> ());
+    const uint32_t numPackets = 20;
+    m_fbTime.assign (numPackets, 0);
+    for (uint32_t seq = 0; seq < numPackets; ++seq) {
+        NS_TEST_ASSERT_MSG_EQ (controller.processSendPacket (FbTx (seq), seq, 1000), true,
+                               "Send of " << seq << " rejected");
+    }
+
+    // In order
+    for (uint32_t seq = 0; seq < 3; ++seq) {
+        NS_TEST_ASSERT_MSG_EQ (Feedback (controller, seq), true, "Feedback rejected");
+    }
+    NS_TEST_ASSERT_MSG_EQ (controller.m_packetHistory.size (), 3, "Packets not moved to the history");
+
+    // Reordered: 4 waits for 3, a duplicate of 4 meanwhile
+    NS_TEST_ASSERT_MSG_EQ (Feedback (controller, 4), true, "Feedback rejected");
+    NS_TEST_ASSERT_MSG_EQ (controller.m_packetHistory.size (), 3, "Packet moved before an earlier one");
+    NS_TEST_ASSERT_MSG_EQ (controller.m_inTransitPackets.isAcked (4), true, "Feedback not stored");
+    NS_TEST_ASSERT_MSG_EQ (Feedback (controller, 4), true, "Duplicate rejected");
+    NS_TEST_ASSERT_MSG_EQ (Feedback (controller, 3), true, "Feedback rejected");
+    NS_TEST_ASSERT_MSG_EQ (controller.m_packetHistory.size (), 5, "Reordered packets not moved");
+
+    // Missing: 5 is declared lost once feedback about 5 + 4 arrives
+    for (uint32_t seq = 6; seq < 9; ++seq) {
+        NS_TEST_ASSERT_MSG_EQ (Feedback (controller, seq), true, "Feedback rejected");
+    }
+    NS_TEST_ASSERT_MSG_EQ (controller.m_inTransitPackets.firstSequence (), 5, "Lost before the reorder window");
+    NS_TEST_ASSERT_MSG_EQ (Feedback (controller, 9), true, "Feedback rejected");
+    NS_TEST_ASSERT_MSG_EQ (controller.m_inTransitPackets.firstSequence (), 10, "Loss not declared");
+
+    // Stale: about a packet declared lost, and about one in the history.
+    // Future: about a packet not sent
+    NS_TEST_ASSERT_MSG_EQ (Feedback (controller, 5), true, "Stale feedback rejected");
+    NS_TEST_ASSERT_MSG_EQ (Feedback (controller, 2), true, "Stale feedback rejected");
+    NS_TEST_ASSERT_MSG_EQ (Feedback (controller, numPackets + 5), false, "Future feedback accepted");
+
+    for (uint32_t seq = 10; seq < numPackets; ++seq) {
+        NS_TEST_ASSERT_MSG_EQ (Feedback (controller, seq), true, "Feedback rejected");
+    }
+
+    const rmcat::ControllerEventCounters& events = controller.getEventCounters ();
+    NS_TEST_ASSERT_MSG_EQ (events.illegalSendSequences, 0, "Wrong illegal send count");
+    NS_TEST_ASSERT_MSG_EQ (events.inTransitTimeouts, 0, "Wrong in-transit timeout count");
+    NS_TEST_ASSERT_MSG_EQ (events.futureFeedback, 1, "Wrong future feedback count");
+    NS_TEST_ASSERT_MSG_EQ (events.duplicateFeedback, 1, "Wrong duplicate feedback count");
+    NS_TEST_ASSERT_MSG_EQ (events.lateFeedback, 1, "Wrong late feedback count");
+    NS_TEST_ASSERT_MSG_EQ (events.staleFeedback, 2, "Wrong stale feedback count");
+    NS_TEST_ASSERT_MSG_EQ (events.stalePurges, 1, "Wrong stale purge count");
+    NS_TEST_ASSERT_MSG_EQ (events.decreasingTimestamps, 0, "Wrong decreasing timestamp count");
+    NS_TEST_ASSERT_MSG_EQ (events.obsoleteHistoryResets, 0, "Wrong history reset count");
+
+    // One loss in the 20 sequences of the history
+    uint32_t nLoss = 0;
+    float plr = -1.f;
+    NS_TEST_ASSERT_MSG_EQ (controller.getPktLossInfo (nLoss, plr), true, "No loss stats");
+    NS_TEST_ASSERT_MSG_EQ (nLoss, 1, "Wrong number of losses");
+    NS_TEST_ASSERT_MSG_EQ_TOL (plr, 1.f / numPackets, 1e-6, "Wrong loss ratio");
+
+    // Delay samples of the packets received, in sequence order
+    const rmcat::PacketRing& history = controller.m_packetHistory;
+    NS_TEST_ASSERT_MSG_EQ (history.size (), numPackets - 1, "Wrong history");
+    for (size_t i = 0; i < history.size (); ++i) {
+        const uint32_t seq = history.sequence (i);
+        NS_TEST_ASSERT_MSG_EQ (seq, (i < 5) ? i : i + 1, "Wrong sequence in the history");
+        NS_TEST_ASSERT_MSG_EQ (history.owd (i), FbOwd (seq), "Wrong owd of " << seq);
+        NS_TEST_ASSERT_MSG_EQ (history.rtt (i), m_fbTime[seq] - FbTx (seq), "Wrong rtt of " << seq);
+    }
+    uint64_t rtt = 0;
+    uint64_t qdelay = 0;
+    NS_TEST_ASSERT_MSG_EQ (controller.getCurrentRTT (rtt), true, "No rtt");
+    NS_TEST_ASSERT_MSG_EQ (rtt, FbOwd (0) + RMCAT_TC_FB_LAG, "Wrong rtt"); // as fast as any later packet
+    NS_TEST_ASSERT_MSG_EQ (controller.m_baseDelay, FbOwd (0), "Wrong base delay");
+    NS_TEST_ASSERT_MSG_EQ (controller.getCurrentQdelay (qdelay), true, "No queuing delay");
+    NS_TEST_ASSERT_MSG_EQ (qdelay, 0, "Wrong queuing delay");
+    NS_TEST_ASSERT_MSG_EQ (controller.getMaxQdelay (qdelay), true, "No maximum queuing delay");
+    NS_TEST_ASSERT_MSG_EQ (qdelay, FbOwd (3) - FbOwd (0), "Wrong maximum queuing delay");
+
+    // Packets without feedback for too long time out; a sequence gap is refused
+    NS_TEST_ASSERT_MSG_EQ (controller.processSendPacket (FbTx (numPackets), numPackets, 1000), true,
+                           "Send rejected");
+    NS_TEST_ASSERT_MSG_EQ (controller.processSendPacket (FbTx (numPackets) + 6 * 1000 * 1000,
+                                                         numPackets + 1, 1000), true,
+                           "Send rejected");
+    NS_TEST_ASSERT_MSG_EQ (events.inTransitTimeouts, 1, "Wrong in-transit timeout count");
+    NS_TEST_ASSERT_MSG_EQ (controller.m_inTransitPackets.firstSequence (), numPackets + 1,
+                           "Timed out packet still in transit");
+    NS_TEST_ASSERT_MSG_EQ (controller.processSendPacket (FbTx (numPackets) + 7 * 1000 * 1000,
+                                                         numPackets + 3, 1000), false,
+                           "Sequence gap accepted");
+    NS_TEST_ASSERT_MSG_EQ (events.illegalSendSequences, 1, "Wrong illegal send count");
+}
+
+/*
+ * Delay filters: the incremental minimum filters of
+ * queuing delay and round trip time give the same
+ * result as a scan of the last taps of the history,
+ * and the maximum queuing delay the same as a scan of
+ * the whole history, over random delays with losses,
+ * base delay changes, filter length changes, garbage
+ * collection and history resets
+ */
+class DelayFilterTestCase : public TestCase
+{
+public:
+    DelayFilterTestCase ();
+
+private:
+    /* Packet whose feedback is yet to be delivered */
+    struct Pending {
+        uint32_t seq;
+        uint64_t tx;
+        uint64_t owd;
+        bool lost;
+    };
+
+    virtual void DoRun ();
+    void RunRandom (uint32_t seed);
+    void CheckMinFilters (const MetricsDummyController& controller);
+    void CheckMaxFilter (const MetricsDummyController& controller);
+
+    size_t m_taps;  // current number of taps of the minimum filters
+};
+
+/* Random traffic of DelayFilterTestCase */
+static const uint32_t RMCAT_TC_DF_PACKETS = 20000;
+static const uint64_t RMCAT_TC_DF_FB_LAG = 20 * 1000;  // us, receiver to sender
+static const size_t RMCAT_TC_DF_DEFAULT_TAPS = 15;     // as the controllers' default
+
+DelayFilterTestCase::DelayFilterTestCase ()
+: TestCase{"rmcat-controller-delay-filters"}
+, m_taps{RMCAT_TC_DF_DEFAULT_TAPS}
+{}
+
+/* Scan of the last taps of the history, as the controllers used to do */
+void DelayFilterTestCase::CheckMinFilters (const MetricsDummyController& controller)
+{
+    const rmcat::PacketRing& history = controller.m_packetHistory;
+    uint64_t qdelay = 0;
+    uint64_t rtt = 0;
+    const bool qdelayOk = controller.getCurrentQdelay (qdelay);
+    const bool rttOk = controller.getCurrentRTT (rtt);
+    NS_TEST_ASSERT_MSG_EQ (qdelayOk, !history.empty (), "Queuing delay availability");
+    NS_TEST_ASSERT_MSG_EQ (rttOk, !history.empty (), "Round trip time availability");
+    if (history.empty ()) {
+        return;
+    }
+
+    uint64_t qdelayMin = 0;
+    uint64_t rttMin = 0;
+    size_t iter = 0;
+    for (size_t i = history.size (); i-- > 0; ) {
+        const uint64_t qdelayCurrent = history.owd (i) - controller.m_baseDelay;
+        qdelayMin = (iter > 0) ? std::min (qdelayMin, qdelayCurrent) : qdelayCurrent;
+        rttMin = (iter > 0) ? std::min (rttMin, history.rtt (i)) : history.rtt (i);
+        if (++iter >= m_taps) {
+            break;
+        }
+    }
+    NS_TEST_ASSERT_MSG_EQ (qdelay, qdelayMin, "Wrong queuing delay with " << m_taps << " taps and "
+                           << history.size () << " packets in the history");
+    NS_TEST_ASSERT_MSG_EQ (rtt, rttMin, "Wrong round trip time with " << m_taps << " taps and "
+                           << history.size () << " packets in the history");
+}
+
+/* Scan of the whole history, as NADA's ramp-up decision used to do */
+void DelayFilterTestCase::CheckMaxFilter (const MetricsDummyController& controller)
+{
+    const rmcat::PacketRing& history = controller.m_packetHistory;
+    uint64_t qdelayMax = 0;
+    const bool ok = controller.getMaxQdelay (qdelayMax);
+    NS_TEST_ASSERT_MSG_EQ (ok, !history.empty (), "Maximum queuing delay availability");
+    if (history.empty ()) {
+        return;
+    }
+
+    uint64_t qdelayScan = 0;
+    for (size_t i = 0; i < history.size (); ++i) {
+        qdelayScan = std::max (qdelayScan, history.owd (i) - controller.m_baseDelay);
+    }
+    NS_TEST_ASSERT_MSG_EQ (qdelayMax, qdelayScan, "Wrong maximum queuing delay with "
+                           << history.size () << " packets in the history");
+}
+
+void DelayFilterTestCase::RunRandom (uint32_t seed)
+{
+    std::mt19937 rng{seed};
+    std::uniform_int_distribution<uint64_t> gap{1 * 1000, 20 * 1000};       // us
+    std::uniform_int_distribution<uint64_t> longGap{600 * 1000, 1000 * 1000};
+    std::uniform_int_distribution<uint64_t> queuing{0, 60 * 1000};
+    std::uniform_int_distribution<size_t> taps{1, 80};
+    std::uniform_int_distribution<uint32_t> percent{0, 99};
+
+    MetricsDummyController controller;
+    controller.setStatsSink (std::make_shared<rmcat::ColumnarStatsSink> ());
+    m_taps = RMCAT_TC_DF_DEFAULT_TAPS;
+    uint64_t now = 1000 * 1000;
+    uint64_t baseOwd = 50 * 1000;
+    std::deque<Pending> pending;
+
+    for (uint32_t seq = 0; seq < RMCAT_TC_DF_PACKETS; ++seq) {
+        // Mostly a few ms between packets, rarely long enough for the
+        // history to become obsolete (500 ms)
+        now += (percent (rng) == 0 && percent (rng) < 20) ? longGap (rng) : gap (rng);
+        // Route changes: the base delay drops or rises
+        if (percent (rng) == 0 && percent (rng) < 10) {
+            baseOwd = (percent (rng) < 50) ? baseOwd - 30 * 1000 : baseOwd + 30 * 1000;
+            baseOwd = std::max<uint64_t> (baseOwd, 10 * 1000);
+        }
+        controller.processSendPacket (now, seq, 1000);
+        pending.push_back (Pending{seq, now, baseOwd + queuing (rng), percent (rng) < 3});
+
+        // Feedback in sequence order, once it has arrived
+        while (!pending.empty ()) {
+            const Pending& front = pending.front ();
+            const uint64_t rx = front.tx + front.owd;
+            if (rx + RMCAT_TC_DF_FB_LAG > now) {
+                break;
+            }
+            if (!front.lost) {
+                controller.processFeedback (now, front.seq, rx);
+                CheckMinFilters (controller);
+                CheckMaxFilter (controller);
+            }
+            pending.pop_front ();
+        }
+
+        // Filter length changes, with and without samples in the history
+        if (percent (rng) == 0 && percent (rng) < 30) {
+            m_taps = taps (rng);
+            controller.setMinFilterTaps (m_taps);
+            CheckMinFilters (controller);
+        }
+    }
+    NS_TEST_ASSERT_MSG_GT (controller.getEventCounters ().obsoleteHistoryResets, 0,
+                           "History never reset");
+    NS_TEST_ASSERT_MSG_GT (controller.getEventCounters ().stalePurges, 0, "No losses");
+}
+
+void DelayFilterTestCase::DoRun ()
+{
+    for (uint32_t seed = 1; seed <= 5; ++seed) {
+        RunRandom (seed);
+    }
+}
+
+/* NADA controller whose ramp-up decision can be checked */
+class RampUpNadaController : public rmcat::NadaController
+{
+public:
+    using rmcat::SenderBasedController::getMaxQdelay;
+    using rmcat::SenderBasedController::m_packetHistory;
+    using rmcat::SenderBasedController::m_baseDelay;
+    using rmcat::NadaController::getRampUpMode;
+};
+
+/*
+ * NADA's ramp-up decision: accelerated ramp-up as long
+ * as no queuing delay in the history exceeds QEPS, the
+ * same as a scan of the whole history. Queuing delays
+ * are relative to the current base delay, so they all
+ * grow when it drops, and a large one stops counting
+ * once it leaves the history
+ */
+class NadaRampUpTestCase : public TestCase
+{
+public:
+    NadaRampUpTestCase ();
+
+private:
+    virtual void DoRun ();
+    void Send (RampUpNadaController& controller, uint64_t owd);
+    void CheckDecision (RampUpNadaController& controller, int expected);
+
+    uint32_t m_seq;
+    uint64_t m_now;
+    uint64_t m_lastFeedback;  // feedback is delivered in sending order
+};
+
+/* Packets of NadaRampUpTestCase: every 10 ms, feedback 20 ms after reception */
+static const uint64_t RMCAT_TC_RU_INTERVAL = 10 * 1000;  // us
+static const uint64_t RMCAT_TC_RU_FB_LAG = 20 * 1000;    // us
+
+NadaRampUpTestCase::NadaRampUpTestCase ()
+: TestCase{"rmcat-controller-nada-ramp-up"}
+, m_seq{0}
+, m_now{0}
+, m_lastFeedback{0}
+{}
+
+/* Send a packet and deliver its feedback right away */
+void NadaRampUpTestCase::Send (RampUpNadaController& controller, uint64_t owd)
+{
+    m_now += RMCAT_TC_RU_INTERVAL;
+    controller.processSendPacket (m_now, m_seq, 1000);
+    m_lastFeedback = std::max (m_lastFeedback, m_now + owd + RMCAT_TC_RU_FB_LAG);
+    controller.processFeedback (m_lastFeedback, m_seq, m_now + owd);
+    ++m_seq;
+}
+
+/* The decision matches the scan of the whole history, and the expected one */
+void NadaRampUpTestCase::CheckDecision (RampUpNadaController& controller, int expected)
+{
+    const rmcat::PacketRing& history = controller.m_packetHistory;
+    int scan = 0;
+    for (size_t i = 0; i < history.size (); ++i) {
+        if (history.owd (i) - controller.m_baseDelay > RMCAT_TC_NADA_QEPS) {
+            scan = 1;
+        }
+    }
+    const int rmode = controller.getRampUpMode ();
+    NS_TEST_ASSERT_MSG_EQ (rmode, scan, "Decision differs from a history scan at packet " << m_seq);
+    if (expected >= 0) {
+        NS_TEST_ASSERT_MSG_EQ (rmode, expected, "Wrong decision at packet " << m_seq);
+    }
+}
+
+void NadaRampUpTestCase::DoRun ()
+{
+    const uint64_t ms = 1000;
+    RampUpNadaController controller;
+    controller.setStatsSink (std::make_shared<rmcat::ColumnarStatsSink> ());
+
+    // 50 ms one-way delay, one packet queued 8 ms: below QEPS
+    for (int i = 0; i < 20; ++i) {
+        Send (controller, 50 * ms);
+    }
+    Send (controller, 58 * ms);
+    for (int i = 0; i < 5; ++i) {
+        Send (controller, 50 * ms);
+        CheckDecision (controller, 0);
+    }
+    uint64_t qdelayMax = 0;
+    NS_TEST_ASSERT_MSG_EQ (controller.getMaxQdelay (qdelayMax), true, "No maximum queuing delay");
+    NS_TEST_ASSERT_MSG_EQ (qdelayMax, 8 * ms, "Wrong maximum queuing delay");
+
+    // The base delay drops by 5 ms: the packet queued 8 ms is now 13 ms
+    // above it, beyond QEPS, without any new sample exceeding it
+    Send (controller, 45 * ms);
+    NS_TEST_ASSERT_MSG_EQ (controller.m_baseDelay, 45 * ms, "Base delay not lowered");
+    NS_TEST_ASSERT_MSG_EQ (controller.getMaxQdelay (qdelayMax), true, "No maximum queuing delay");
+    NS_TEST_ASSERT_MSG_EQ (qdelayMax, 13 * ms, "Maximum not rebased on the new base delay");
+    CheckDecision (controller, 1);
+
+    // Until that packet leaves the history (500 ms)
+    bool expired = false;
+    for (int i = 0; i < 60; ++i) {
+        Send (controller, 46 * ms);
+        if (!expired && controller.getRampUpMode () == 0) {
+            expired = true;
+            NS_TEST_ASSERT_MSG_EQ (controller.getMaxQdelay (qdelayMax), true, "No maximum queuing delay");
+            NS_TEST_ASSERT_MSG_EQ (qdelayMax, 5 * ms, "Wrong maximum queuing delay after expiry");
+        }
+        CheckDecision (controller, expired ? 0 : 1);
+    }
+    NS_TEST_ASSERT_MSG_EQ (expired, true, "Queuing delay never left the history");
+
+    // Random queuing around QEPS, without losses
+    std::mt19937 rng{42};
+    std::uniform_int_distribution<uint64_t> queuing{0, 11 * ms};
+    std::uniform_int_distribution<uint32_t> percent{0, 99};
+    uint64_t baseOwd = 46 * ms;
+    uint32_t gradual = 0;
+    for (int i = 0; i < 5000; ++i) {
+        if (percent (rng) == 0) {
+            baseOwd = (percent (rng) < 50) ? baseOwd - 3 * ms : baseOwd + 3 * ms;
+            baseOwd = std::max (baseOwd, 20 * ms);
+        }
+        // Queuing mostly below QEPS, 1 in 50 packets beyond it
+        const uint64_t q = (percent (rng) < 2) ? queuing (rng) + 5 * ms : queuing (rng) / 2;
+        Send (controller, baseOwd + q);
+        CheckDecision (controller, -1);
+        gradual += controller.getRampUpMode ();
+    }
+    NS_TEST_ASSERT_MSG_GT (gradual, 0, "Never gradual");
+    NS_TEST_ASSERT_MSG_LT (gradual, 5000, "Never accelerated");
+}
+
+/* NADA controller whose marking stats can be checked */
+class MarkingNadaController : public rmcat::NadaController
+{
+public:
+    using rmcat::SenderBasedController::getPktMarkingInfo;
+};
+
+/*
+ * NADA with ECN: CE marks fed back are counted in
+ * the marking ratio, and add DMARK * (pmr / PMRREF)^2
+ * to the congestion signal x_curr, which lowers the
+ * rate compared to a flow without marks
+ */
+class NadaEcnTestCase : public TestCase
+{
+public:
+    NadaEcnTestCase ();
+
+private:
+    virtual void DoRun ();
+};
+
+NadaEcnTestCase::NadaEcnTestCase ()
+: TestCase{"rmcat-controller-nada-ecn"}
+{}
+
+void NadaEcnTestCase::DoRun ()
+{
+    // 1000-byte packets every 10 ms, constant 50 ms one-way delay (no
+    // queuing), feedback 100 ms after sending. One packet in 10 is marked
+    const uint64_t interval = 10 * 1000;    // us
+    const uint64_t owd = 50 * 1000;         // us
+    const uint32_t feedbackLag = 10;        // packets
+    const uint32_t markEvery = 10;
+    const uint32_t numPackets = 2000;       // 20 s
+
+    MarkingNadaController clean;
+    MarkingNadaController marked;
+    auto cleanStats = std::make_shared<rmcat::ColumnarStatsSink> ();
+    auto markedStats = std::make_shared<rmcat::ColumnarStatsSink> ();
+    clean.setStatsSink (cleanStats);
+    marked.setStatsSink (markedStats);
+
+    for (uint32_t seq = 0; seq < numPackets; ++seq) {
+        const uint64_t now = seq * interval;
+        clean.processSendPacket (now, seq, 1000);
+        marked.processSendPacket (now, seq, 1000);
+        if (seq < feedbackLag) {
+            continue;
+        }
+        const uint32_t acked = seq - feedbackLag;
+        const uint64_t rx = acked * interval + owd;
+        const uint8_t ecn = (acked % markEvery == 0) ? rmcat::ECN_CE : rmcat::ECN_ECT0;
+        clean.processFeedback (now, acked, rx, rmcat::ECN_ECT0);
+        marked.processFeedback (now, acked, rx, ecn);
+    }
+
+    // Marking ratio over the history
+    uint32_t nMarked = 0;
+    float pmr = -1.f;
+    NS_TEST_ASSERT_MSG_EQ (clean.getPktMarkingInfo (nMarked, pmr), true, "No marking stats");
+    NS_TEST_ASSERT_MSG_EQ (nMarked, 0, "Marks counted without CE feedback");
+    NS_TEST_ASSERT_MSG_EQ_TOL (pmr, 0.f, 1e-6, "Marking ratio without CE feedback");
+    NS_TEST_ASSERT_MSG_EQ (marked.getPktMarkingInfo (nMarked, pmr), true, "No marking stats");
+    const auto loglen = markedStats->loglen.back ();
+    NS_TEST_ASSERT_MSG_EQ (loglen % markEvery, 0, "History not a whole number of mark periods");
+    NS_TEST_ASSERT_MSG_EQ (nMarked, loglen / markEvery, "Wrong number of marks in the history");
+    NS_TEST_ASSERT_MSG_EQ_TOL (pmr, 1.f / markEvery, 1e-6, "Wrong marking ratio");
+
+    // The rate updates were logged, the last ones with the marking
+    // ratio filtered to its steady value
+    NS_TEST_ASSERT_MSG_EQ (cleanStats->size () > 100, true, "Too few rate updates");
+    NS_TEST_ASSERT_MSG_EQ (markedStats->size (), cleanStats->size (), "Different rate updates");
+    NS_TEST_ASSERT_MSG_EQ ((markedStats->fields.back () & rmcat::STATS_FIELD_XCURR) != 0, true,
+                           "x_curr not reported");
+    NS_TEST_ASSERT_MSG_EQ (markedStats->qdel.back (), 0, "Queuing delay seen");
+    NS_TEST_ASSERT_MSG_EQ_TOL (cleanStats->xcurr.back (), 0.f, 1e-3,
+                               "Congestion signal without queuing, losses or marks");
+    const float pmr0 = pmr / RMCAT_TC_NADA_PMRREF;
+    const float penalty = RMCAT_TC_NADA_DMARK * pmr0 * pmr0;
+    NS_TEST_ASSERT_MSG_EQ_TOL (markedStats->xcurr.back (), penalty, 0.01 * penalty,
+                               "Wrong marking penalty in x_curr");
+    NS_TEST_ASSERT_MSG_EQ (markedStats->srate.back () < cleanStats->srate.back (), true,
+                           "Rate not lowered by the marks");
+    NS_TEST_ASSERT_MSG_EQ (marked.getBandwidth (0) < clean.getBandwidth (0), true,
+                           "Rate not lowered by the marks");
+}
+
+class RmcatControllerTestSuite : public TestSuite
+{
+public:
+    RmcatControllerTestSuite ();
+};
+
+RmcatControllerTestSuite::RmcatControllerTestSuite ()
+: TestSuite{"rmcat-controller", UNIT}
+{
+    AddTestCase (new FlowStateExchangeTestCase, TestCase::QUICK);
+    AddTestCase (new PacketRingTestCase, TestCase::QUICK);
+    AddTestCase (new FeedbackAccountingTestCase, TestCase::QUICK);
+    AddTestCase (new DelayFilterTestCase, TestCase::QUICK);
+    AddTestCase (new NadaRampUpTestCase, TestCase::QUICK);
+    AddTestCase (new NadaEcnTestCase, TestCase::QUICK);
+}
+
+static RmcatControllerTestSuite rmcatControllerTestSuite;
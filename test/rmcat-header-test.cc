@@ -0,0 +1,353 @@
+/******************************************************************************
+ * Copyright 2016-2017 Cisco Systems, Inc.                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ *                                                                            *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+/**
+ * @file
+ * Round-trip tests of the rmcat packet headers.
+ *
+ * @version 0.1.0
+ * @author Jiantao Fu
+ * @author Sergio Mena
+ * @author Xiaoqing Zhu
+ */
+
+#include "ns3/test.h"
+#include "ns3/buffer.h"
+#include "ns3/rmcat-header.h"
+#include "ns3/rmcat-constants.h"
+
+using namespace ns3;
+
+/* Serialize a header into a buffer, and deserialize it into another */
+template <typename HEADER>
+static uint32_t RoundTrip (const HEADER& in, HEADER& out, uint32_t& size)
+{
+    Buffer buffer;
+    size = in.GetSerializedSize ();
+    buffer.AddAtStart (size);
+    in.Serialize (buffer.Begin ());
+    return out.Deserialize (buffer.Begin ());
+}
+
+/*
+ * Feedback arrival times: delta format chosen at the
+ * boundaries between formats, and precision of the
+ * arrival times decoded
+ */
+class FeedbackDeltaTestCase : public TestCase
+{
+public:
+    FeedbackDeltaTestCase ();
+
+private:
+    virtual void DoRun ();
+    void CheckFormat (int64_t deltaUs, FeedbackHeader::DeltaFormat format);
+};
+
+FeedbackDeltaTestCase::FeedbackDeltaTestCase ()
+: TestCase{"rmcat-header-feedback-delta"}
+{}
+
+void FeedbackDeltaTestCase::CheckFormat (int64_t deltaUs,
+                                         FeedbackHeader::DeltaFormat format)
+{
+    const uint64_t base = 10 * 1000 * 1000;
+    FeedbackHeader in;
+    in.AddFeedback (100, base);
+    in.AddFeedback (101, base + deltaUs);
+    NS_TEST_ASSERT_MSG_EQ (in.GetDeltaFormat (), format,
+                           "Wrong delta format for a delta of " << deltaUs << " us");
+
+    FeedbackHeader out;
+    uint32_t size = 0;
+    NS_TEST_ASSERT_MSG_EQ (RoundTrip (in, out, size), size, "Wrong size deserialized");
+    NS_TEST_ASSERT_MSG_EQ (out.GetDeltaFormat (), format, "Delta format changed by round trip");
+    NS_TEST_ASSERT_MSG_EQ (out.GetFeedback ().size (), 2, "Wrong number of packets");
+    const int64_t error = int64_t (out.GetFeedback ()[1].receive_tstmp - (base + deltaUs));
+    const int64_t maxError = (format == FeedbackHeader::DELTA_32BIT) ?
+                             0 : FeedbackHeader::FEEDBACK_DELTA_UNIT / 2;
+    NS_TEST_ASSERT_MSG_EQ (error >= -maxError && error <= maxError, true,
+                           "Arrival time off by " << error << " us");
+}
+
+void FeedbackDeltaTestCase::DoRun ()
+{
+    const int64_t unit = FeedbackHeader::FEEDBACK_DELTA_UNIT;
+    CheckFormat (0, FeedbackHeader::DELTA_8BIT);
+    CheckFormat (255 * unit, FeedbackHeader::DELTA_8BIT);
+    CheckFormat (255 * unit + unit / 2 - 1, FeedbackHeader::DELTA_8BIT);
+    CheckFormat (255 * unit + unit / 2, FeedbackHeader::DELTA_16BIT);
+    CheckFormat (-unit, FeedbackHeader::DELTA_16BIT);
+    CheckFormat (-unit / 2 + 1, FeedbackHeader::DELTA_8BIT); // rounds to 0
+    CheckFormat (32767 * unit, FeedbackHeader::DELTA_16BIT);
+    CheckFormat (-32768 * unit, FeedbackHeader::DELTA_16BIT);
+    CheckFormat (32768 * unit, FeedbackHeader::DELTA_32BIT);
+    CheckFormat (-32769 * unit, FeedbackHeader::DELTA_32BIT);
+
+    // Rounding errors do not accumulate over many packets
+    const uint64_t base = 5 * 1000 * 1000;
+    FeedbackHeader in;
+    for (uint32_t i = 0; i < 1000; ++i) {
+        in.AddFeedback (i, base + i * 1001);
+    }
+    NS_TEST_ASSERT_MSG_EQ (in.GetDeltaFormat (), FeedbackHeader::DELTA_8BIT, "Wrong delta format");
+    FeedbackHeader out;
+    uint32_t size = 0;
+    RoundTrip (in, out, size);
+    NS_TEST_ASSERT_MSG_EQ (out.GetFeedback ().size (), 1000, "Wrong number of packets");
+    for (uint32_t i = 0; i < 1000; ++i) {
+        const int64_t error = int64_t (out.GetFeedback ()[i].receive_tstmp - (base + i * 1001));
+        NS_TEST_ASSERT_MSG_EQ (error >= -unit / 2 && error <= unit / 2, true,
+                               "Arrival time of packet " << i << " off by " << error << " us");
+    }
+}
+
+/*
+ * Feedback sequences: runs of received and lost
+ * packets, reordered additions, sequence wrapping
+ * and the maximum span of a report
+ */
+class FeedbackSequenceTestCase : public TestCase
+{
+public:
+    FeedbackSequenceTestCase ();
+
+private:
+    virtual void DoRun ();
+    void CheckRoundTrip (const std::vector<uint32_t>& sequences);
+};
+
+FeedbackSequenceTestCase::FeedbackSequenceTestCase ()
+: TestCase{"rmcat-header-feedback-sequence"}
+{}
+
+void FeedbackSequenceTestCase::CheckRoundTrip (const std::vector<uint32_t>& sequences)
+{
+    FeedbackHeader in;
+    in.flow_id = 1234;
+    for (size_t i = 0; i < sequences.size (); ++i) {
+        NS_TEST_ASSERT_MSG_EQ (in.AddFeedback (sequences[i], 1000 * (i + 1)), true,
+                               "Could not add sequence " << sequences[i]);
+    }
+    FeedbackHeader out;
+    uint32_t size = 0;
+    NS_TEST_ASSERT_MSG_EQ (RoundTrip (in, out, size), size, "Wrong size deserialized");
+    NS_TEST_ASSERT_MSG_EQ (out.flow_id, 1234, "Wrong flow id");
+    const auto& inEntries = in.GetFeedback ();
+    const auto& outEntries = out.GetFeedback ();
+    NS_TEST_ASSERT_MSG_EQ (outEntries.size (), inEntries.size (), "Wrong number of packets");
+    for (size_t i = 0; i < inEntries.size (); ++i) {
+        NS_TEST_ASSERT_MSG_EQ (outEntries[i].sequence, inEntries[i].sequence, "Wrong sequence");
+        NS_TEST_ASSERT_MSG_EQ (outEntries[i].receive_tstmp, inEntries[i].receive_tstmp,
+                               "Wrong arrival time");
+    }
+}
+
+void FeedbackSequenceTestCase::DoRun ()
+{
+    // Runs of received packets, separated by losses of one and many
+    std::vector<uint32_t> seqs;
+    for (uint32_t s : {10, 11, 12, 14, 15, 100, 200, 201}) {
+        seqs.push_back (s);
+    }
+    CheckRoundTrip (seqs);
+
+    // Added out of order, duplicates ignored
+    FeedbackHeader in;
+    for (uint32_t s : {7, 5, 6, 9, 5, 8}) {
+        in.AddFeedback (s, 1000 * s);
+    }
+    NS_TEST_ASSERT_MSG_EQ (in.GetFeedback ().size (), 5, "Duplicate not ignored");
+    for (size_t i = 0; i < in.GetFeedback ().size (); ++i) {
+        NS_TEST_ASSERT_MSG_EQ (in.GetFeedback ()[i].sequence, 5 + i, "Packets not sorted");
+    }
+
+    // Crossing 16-bit (RTP) and 32-bit sequence boundaries
+    seqs.clear ();
+    for (uint32_t s : {0xfffdu, 0xfffeu, 0xffffu, 0x10000u, 0x10002u}) {
+        seqs.push_back (s);
+    }
+    CheckRoundTrip (seqs);
+    seqs.clear ();
+    for (uint32_t s : {0xfffffffeu, 0xffffffffu, 0u, 2u}) {
+        seqs.push_back (s);
+    }
+    CheckRoundTrip (seqs);
+
+    // Maximum span, in order and out of order
+    const uint32_t first = 0xfffffff0u;
+    const uint32_t span = FeedbackHeader::FEEDBACK_MAX_SPAN;
+    FeedbackHeader full;
+    NS_TEST_ASSERT_MSG_EQ (full.AddFeedback (first, 1000), true, "Could not add first");
+    NS_TEST_ASSERT_MSG_EQ (full.AddFeedback (first + span - 1, 2000), true,
+                           "Could not add last sequence within span");
+    NS_TEST_ASSERT_MSG_EQ (full.AddFeedback (first + span, 3000), false,
+                           "Added sequence beyond span");
+    NS_TEST_ASSERT_MSG_EQ (full.AddFeedback (first - 1, 3000), false,
+                           "Added earlier sequence beyond span");
+    NS_TEST_ASSERT_MSG_EQ (full.GetFeedback ().size (), 2, "Report changed by failed additions");
+    FeedbackHeader out;
+    uint32_t size = 0;
+    RoundTrip (full, out, size);
+    NS_TEST_ASSERT_MSG_EQ (out.GetFeedback ().size (), 2, "Wrong number of packets");
+    NS_TEST_ASSERT_MSG_EQ (out.GetFeedback ()[1].sequence, first + span - 1, "Wrong last sequence");
+}
+
+/*
+ * Feedback ECN markings: packed four per byte, and
+ * only present if any packet was ECN-capable
+ */
+class FeedbackEcnTestCase : public TestCase
+{
+public:
+    FeedbackEcnTestCase ();
+
+private:
+    virtual void DoRun ();
+};
+
+FeedbackEcnTestCase::FeedbackEcnTestCase ()
+: TestCase{"rmcat-header-feedback-ecn"}
+{}
+
+void FeedbackEcnTestCase::DoRun ()
+{
+    FeedbackHeader noEcn;
+    FeedbackHeader ecn;
+    const uint8_t marks[] = {0, 1, 2, 3, 3, 0, 2};
+    const size_t n = sizeof (marks) / sizeof (marks[0]);
+    for (size_t i = 0; i < n; ++i) {
+        noEcn.AddFeedback (i, 1000 * i);
+        ecn.AddFeedback (i, 1000 * i, marks[i]);
+    }
+    // (n + 3) / 4 bytes of markings
+    NS_TEST_ASSERT_MSG_EQ (ecn.GetSerializedSize (), noEcn.GetSerializedSize () + 2,
+                           "Wrong size of ECN markings");
+
+    FeedbackHeader out;
+    uint32_t size = 0;
+    NS_TEST_ASSERT_MSG_EQ (RoundTrip (ecn, out, size), size, "Wrong size deserialized");
+    NS_TEST_ASSERT_MSG_EQ (out.GetFeedback ().size (), n, "Wrong number of packets");
+    for (size_t i = 0; i < n; ++i) {
+        NS_TEST_ASSERT_MSG_EQ (uint32_t (out.GetFeedback ()[i].ecn), uint32_t (marks[i]),
+                               "Wrong ECN marking of packet " << i);
+    }
+
+    RoundTrip (noEcn, out, size);
+    for (size_t i = 0; i < n; ++i) {
+        NS_TEST_ASSERT_MSG_EQ (uint32_t (out.GetFeedback ()[i].ecn), 0, "Spurious ECN marking");
+    }
+}
+
+/*
+ * RTP header with its one-byte header extensions:
+ * the two known ones round trip, and CSRCs and
+ * unknown extensions are skipped
+ */
+class RtpHeaderTestCase : public TestCase
+{
+public:
+    RtpHeaderTestCase ();
+
+private:
+    virtual void DoRun ();
+};
+
+RtpHeaderTestCase::RtpHeaderTestCase ()
+: TestCase{"rmcat-header-rtp"}
+{}
+
+void RtpHeaderTestCase::DoRun ()
+{
+    RtpHeader in;
+    in.marker = true;
+    in.payload_type = 96;
+    in.sequence = 0xffff;
+    in.timestamp = 0xdeadbeef;
+    in.ssrc = 42;
+    in.transport_sequence = 0xffff;
+    in.abs_send_time = RtpHeader::ToAbsSendTime (63 * 1000 * 1000 + 500 * 1000); // 63.5 s
+    NS_TEST_ASSERT_MSG_EQ (in.GetSerializedSize (), RTP_HEADER_SIZE + RTP_HEADER_EXTENSION_SIZE,
+                           "Wrong RTP header size");
+    // The sender counts either header's bytes (see RmcatSender::SetRtpHeader)
+    NS_TEST_ASSERT_MSG_EQ (MediaHeader{}.GetSerializedSize (), MEDIA_HEADER_SIZE,
+                           "Wrong media header size");
+    NS_TEST_ASSERT_MSG_EQ (in.abs_send_time, (63u << 18) | (1u << 17), "Wrong abs-send-time");
+    NS_TEST_ASSERT_MSG_EQ (RtpHeader::ToAbsSendTime (64 * 1000 * 1000), 0, "abs-send-time not wrapped");
+
+    RtpHeader out;
+    uint32_t size = 0;
+    NS_TEST_ASSERT_MSG_EQ (RoundTrip (in, out, size), size, "Wrong size deserialized");
+    NS_TEST_ASSERT_MSG_EQ (out.marker, true, "Wrong marker");
+    NS_TEST_ASSERT_MSG_EQ (uint32_t (out.payload_type), 96, "Wrong payload type");
+    NS_TEST_ASSERT_MSG_EQ (out.sequence, 0xffff, "Wrong sequence");
+    NS_TEST_ASSERT_MSG_EQ (out.timestamp, 0xdeadbeef, "Wrong timestamp");
+    NS_TEST_ASSERT_MSG_EQ (out.ssrc, 42, "Wrong SSRC");
+    NS_TEST_ASSERT_MSG_EQ (out.transport_sequence, 0xffff, "Wrong transport-wide sequence");
+    NS_TEST_ASSERT_MSG_EQ (out.abs_send_time, in.abs_send_time, "Wrong abs-send-time");
+
+    // As another RTP stack may send it: one CSRC, an unknown extension
+    // element before the known ones, in the opposite order, and padding
+    Buffer buffer;
+    buffer.AddAtStart (12 + 4 + 4 + 16);
+    auto it = buffer.Begin ();
+    it.WriteU8 (0x80 | 0x10 | 1); // V=2, X=1, CC=1
+    it.WriteU8 (96);
+    it.WriteHtonU16 (0);
+    it.WriteHtonU32 (1000);
+    it.WriteHtonU32 (7);
+    it.WriteHtonU32 (8);          // CSRC
+    it.WriteHtonU16 (0xBEDE);
+    it.WriteHtonU16 (4);          // 16 bytes of elements
+    it.WriteU8 ((9 << 4) | 3);    // unknown, 4 bytes
+    it.WriteHtonU32 (0xffffffff);
+    it.WriteU8 ((3 << 4) | 2);    // abs-send-time
+    it.WriteU8 (0x12);
+    it.WriteU8 (0x34);
+    it.WriteU8 (0x56);
+    it.WriteU8 ((5 << 4) | 1);    // transport-wide sequence
+    it.WriteHtonU16 (0);
+    it.WriteU8 (0);               // padding
+    it.WriteU8 (0);
+    it.WriteU8 (0);
+    it.WriteU8 (0);
+    RtpHeader other;
+    NS_TEST_ASSERT_MSG_EQ (other.Deserialize (buffer.Begin ()), 36, "Wrong size deserialized");
+    NS_TEST_ASSERT_MSG_EQ (other.GetSerializedSize (), 36, "Wrong size kept");
+    NS_TEST_ASSERT_MSG_EQ (other.ssrc, 7, "Wrong SSRC");
+    NS_TEST_ASSERT_MSG_EQ (other.sequence, 0, "Wrong sequence");
+    NS_TEST_ASSERT_MSG_EQ (other.transport_sequence, 0, "Wrong transport-wide sequence");
+    NS_TEST_ASSERT_MSG_EQ (other.abs_send_time, 0x123456, "Wrong abs-send-time");
+}
+
+/* Unit tests of the rmcat packet headers */
+class RmcatHeaderTestSuite : public TestSuite
+{
+public:
+    RmcatHeaderTestSuite ();
+};
+
+RmcatHeaderTestSuite::RmcatHeaderTestSuite ()
+: TestSuite{"rmcat-header", UNIT}
+{
+    AddTestCase (new FeedbackDeltaTestCase, TestCase::QUICK);
+    AddTestCase (new FeedbackSequenceTestCase, TestCase::QUICK);
+    AddTestCase (new FeedbackEcnTestCase, TestCase::QUICK);
+    AddTestCase (new RtpHeaderTestCase, TestCase::QUICK);
+}
+
+static RmcatHeaderTestSuite rmcatHeaderTestSuite;
@@ -0,0 +1,326 @@
+/******************************************************************************
+ * Copyright 2016-2017 Cisco Systems, Inc.                                    *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License");            *
+ * you may not use this file except in compliance with the License.           *
+ *                                                                            *
+ * You may obtain a copy of the License at                                    *
+ *                                                                            *
+ *     http://www.apache.org/licenses/LICENSE-2.0                             *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ ******************************************************************************/
+
+/**
+ * @file
+ * Unit tests of the sender's pacer (rate shaping buffer).
+ *
+ * @version 0.1.0
+ * @author Jiantao Fu
+ * @author Sergio Mena
+ * @author Xiaoqing Zhu
+ */
+
+#include "ns3/test.h"
+#include "ns3/nstime.h"
+#include "ns3/rmcat-pacer.h"
+#include "ns3/rmcat-constants.h"
+
+#include <cmath>
+
+using namespace ns3;
+
+const uint32_t RMCAT_TC_PACER_PKT = 1200;   // bytes
+const uint32_t RMCAT_TC_PACER_NPKTS = 1000;
+
+/*
+ * Send the packet at the head of the pacer as soon as it is allowed
+ * to leave, no earlier than now; returns its departure time in ns
+ */
+static int64_t SendNext (RmcatPacer& pacer, Time now)
+{
+    Time wait;
+    while ((wait = pacer.GetTimeToNextSend (now)) > Time{0}) {
+        now = now + wait;
+    }
+    pacer.Dequeue (now);
+    return now.GetNanoSeconds ();
+}
+
+/* Time, in ns, it takes to send the given number of bytes at the given rate */
+static double TxTimeNs (uint32_t bytes, double bps)
+{
+    return bytes * 8. * 1e9 / bps;
+}
+
+/*
+ * Strict pacing above 10 Mbps: consecutive packets are spaced by
+ * size / rate, well under a millisecond, and the rounding of each
+ * gap to the nanosecond does not accumulate over many packets
+ */
+class PacerSpacingTestCase : public TestCase
+{
+public:
+    PacerSpacingTestCase ();
+
+private:
+    virtual void DoRun ();
+};
+
+PacerSpacingTestCase::PacerSpacingTestCase ()
+: TestCase{"Pacer: sub-millisecond spacing above 10 Mbps"}
+{}
+
+void PacerSpacingTestCase::DoRun ()
+{
+    // 37 Mbps gives gaps that are not a whole number of nanoseconds
+    for (const double bps : {12e6, 20e6, 37e6, 50e6}) {
+        RmcatPacer pacer;
+        const auto start = Seconds (1);
+        pacer.Clear (start);
+        pacer.SetRate (bps, start);
+        for (uint32_t i = 0; i < RMCAT_TC_PACER_NPKTS; ++i) {
+            pacer.Enqueue (RMCAT_TC_PACER_PKT);
+        }
+
+        const auto gap = TxTimeNs (RMCAT_TC_PACER_PKT, bps);
+        NS_TEST_ASSERT_MSG_LT (gap, 1e6, "Test expects sub-millisecond gaps");
+
+        auto prev = SendNext (pacer, start);
+        NS_TEST_ASSERT_MSG_EQ (prev, start.GetNanoSeconds (),
+                               "First packet should leave right away");
+        for (uint32_t i = 1; i < RMCAT_TC_PACER_NPKTS; ++i) {
+            const auto t = SendNext (pacer, NanoSeconds (prev));
+            NS_TEST_ASSERT_MSG_EQ_TOL (t - prev, gap, 2.,
+                                       "Gap should be size / rate");
+            prev = t;
+        }
+        NS_TEST_ASSERT_MSG_EQ (pacer.IsEmpty (), true, "All packets should be sent");
+
+        const double elapsed = prev - start.GetNanoSeconds ();
+        NS_TEST_ASSERT_MSG_EQ_TOL (elapsed, (RMCAT_TC_PACER_NPKTS - 1) * gap, 2.,
+                                   "Rounding errors should not accumulate");
+    }
+}
+
+/*
+ * Burst allowance: after an idle period, the allowance (plus the packet
+ * taking the bucket into debt) leaves back to back, however long the
+ * idle period was; pacing then resumes at the sending rate
+ */
+class PacerBurstTestCase : public TestCase
+{
+public:
+    PacerBurstTestCase ();
+
+private:
+    virtual void DoRun ();
+    /* Number of packets that leave at now, without waiting */
+    static uint32_t SendBackToBack (RmcatPacer& pacer, Time now);
+};
+
+PacerBurstTestCase::PacerBurstTestCase ()
+: TestCase{"Pacer: burst allowance"}
+{}
+
+uint32_t PacerBurstTestCase::SendBackToBack (RmcatPacer& pacer, Time now)
+{
+    uint32_t sent = 0;
+    while (!pacer.IsEmpty () && pacer.GetTimeToNextSend (now) == Time{0}) {
+        pacer.Dequeue (now);
+        ++sent;
+    }
+    return sent;
+}
+
+void PacerBurstTestCase::DoRun ()
+{
+    const double bps = 20e6;
+    const uint32_t burstPkts = 4;
+    const auto gap = TxTimeNs (RMCAT_TC_PACER_PKT, bps);
+
+    RmcatPacer pacer;
+    pacer.SetBurstAllowance (burstPkts * RMCAT_TC_PACER_PKT);
+    NS_TEST_ASSERT_MSG_EQ (pacer.GetBurstAllowance (), burstPkts * RMCAT_TC_PACER_PKT,
+                           "Wrong burst allowance");
+    auto now = Seconds (1);
+    pacer.Clear (now);
+    pacer.SetRate (bps, now);
+
+    for (uint32_t i = 0; i < 3 * burstPkts; ++i) {
+        pacer.Enqueue (RMCAT_TC_PACER_PKT);
+    }
+    NS_TEST_ASSERT_MSG_EQ (SendBackToBack (pacer, now), burstPkts + 1,
+                           "A full bucket should let the burst allowance out at once");
+    NS_TEST_ASSERT_MSG_EQ_TOL (pacer.GetTimeToNextSend (now).GetNanoSeconds (), gap, 2.,
+                               "Pacing should resume once the bucket is in debt");
+    auto t = now.GetNanoSeconds ();
+    while (!pacer.IsEmpty ()) {
+        const auto next = SendNext (pacer, NanoSeconds (t));
+        NS_TEST_ASSERT_MSG_EQ_TOL (next - t, gap, 2., "Gap should be size / rate");
+        t = next;
+    }
+
+    // Tokens are capped at the allowance, even after a long idle period
+    now = NanoSeconds (t) + Seconds (10);
+    for (uint32_t i = 0; i < 3 * burstPkts; ++i) {
+        pacer.Enqueue (RMCAT_TC_PACER_PKT);
+    }
+    NS_TEST_ASSERT_MSG_EQ (SendBackToBack (pacer, now), burstPkts + 1,
+                           "Idle time should not earn more than the burst allowance");
+
+    // Lowering the allowance drops the tokens in excess
+    now = now + Seconds (10);
+    pacer.SetBurstAllowance (RMCAT_TC_PACER_PKT);
+    NS_TEST_ASSERT_MSG_EQ (SendBackToBack (pacer, now), 2u,
+                           "A lower allowance should cap the burst at once");
+
+    // No allowance: strict pacing, one packet at a time after idling
+    now = now + Seconds (10);
+    pacer.SetBurstAllowance (0);
+    NS_TEST_ASSERT_MSG_EQ (SendBackToBack (pacer, now), 1u,
+                           "Without allowance, packets should never leave back to back");
+    NS_TEST_ASSERT_MSG_EQ_TOL (pacer.GetTimeToNextSend (now).GetNanoSeconds (), gap, 2.,
+                               "Wrong time to next send");
+}
+
+/*
+ * Per-packet overhead: taken from the bucket along with each packet,
+ * so that the rate on the wire is the sending rate, but not counted
+ * in the buffered bytes nor returned by Dequeue
+ */
+class PacerOverheadTestCase : public TestCase
+{
+public:
+    PacerOverheadTestCase ();
+
+private:
+    virtual void DoRun ();
+};
+
+PacerOverheadTestCase::PacerOverheadTestCase ()
+: TestCase{"Pacer: per-packet overhead"}
+{}
+
+void PacerOverheadTestCase::DoRun ()
+{
+    const double bps = 20e6;
+    const uint32_t overhead = RTP_HEADER_SIZE + RTP_HEADER_EXTENSION_SIZE;
+
+    RmcatPacer pacer;
+    pacer.SetPacketOverhead (overhead);
+    NS_TEST_ASSERT_MSG_EQ (pacer.GetPacketOverhead (), overhead, "Wrong overhead");
+    const auto start = Seconds (1);
+    pacer.Clear (start);
+    pacer.SetRate (bps, start);
+
+    for (uint32_t i = 0; i < RMCAT_TC_PACER_NPKTS; ++i) {
+        pacer.Enqueue (RMCAT_TC_PACER_PKT);
+    }
+    NS_TEST_ASSERT_MSG_EQ (pacer.GetBytes (), RMCAT_TC_PACER_NPKTS * RMCAT_TC_PACER_PKT,
+                           "Overhead should not be counted in the buffered bytes");
+
+    NS_TEST_ASSERT_MSG_EQ (pacer.Dequeue (start), RMCAT_TC_PACER_PKT,
+                           "Dequeue should return the buffered size");
+    const auto gap = TxTimeNs (RMCAT_TC_PACER_PKT + overhead, bps);
+    NS_TEST_ASSERT_MSG_EQ (pacer.GetTimeToNextSend (start).GetNanoSeconds (),
+                           static_cast<int64_t> (std::ceil (gap)),
+                           "Gap should cover the packet and its overhead");
+
+    auto t = start.GetNanoSeconds ();
+    while (!pacer.IsEmpty ()) {
+        t = SendNext (pacer, NanoSeconds (t));
+    }
+    NS_TEST_ASSERT_MSG_EQ (pacer.GetBytes (), 0u, "Buffered bytes should drop to zero");
+
+    // The last packet left after NPKTS - 1 gaps
+    const double elapsed = (t - start.GetNanoSeconds ()) * 1e-9;
+    const double wireBps = (RMCAT_TC_PACER_NPKTS - 1) *
+                           (RMCAT_TC_PACER_PKT + overhead) * 8. / elapsed;
+    const double payloadBps = (RMCAT_TC_PACER_NPKTS - 1) * RMCAT_TC_PACER_PKT * 8. / elapsed;
+    NS_TEST_ASSERT_MSG_EQ_TOL (wireBps, bps, bps * 1e-6,
+                               "Rate on the wire should be the sending rate");
+    NS_TEST_ASSERT_MSG_EQ_TOL (payloadBps,
+                               bps * RMCAT_TC_PACER_PKT / (RMCAT_TC_PACER_PKT + overhead),
+                               bps * 1e-6, "Payload rate should leave room for the overhead");
+}
+
+/*
+ * Times going backwards: a call for an earlier time than one already
+ * accounted for is taken as happening at that later time, so that it
+ * neither earns nor loses tokens
+ */
+class PacerTimeBackwardsTestCase : public TestCase
+{
+public:
+    PacerTimeBackwardsTestCase ();
+
+private:
+    virtual void DoRun ();
+};
+
+PacerTimeBackwardsTestCase::PacerTimeBackwardsTestCase ()
+: TestCase{"Pacer: calls for earlier times"}
+{}
+
+void PacerTimeBackwardsTestCase::DoRun ()
+{
+    const double bps = 20e6;
+    const auto gap = TxTimeNs (RMCAT_TC_PACER_PKT, bps);     // 480 us
+    const auto t0 = Seconds (1);
+    const auto t1 = t0 + MicroSeconds (100);
+
+    RmcatPacer pacer;
+    pacer.Clear (t0);
+    pacer.SetRate (bps, t0);
+    for (uint32_t i = 0; i < 3; ++i) {
+        pacer.Enqueue (RMCAT_TC_PACER_PKT);
+    }
+    pacer.Dequeue (t0);
+
+    const double waitT1 = gap - 100e3;
+    NS_TEST_ASSERT_MSG_EQ_TOL (pacer.GetTimeToNextSend (t1).GetNanoSeconds (), waitT1, 1.,
+                               "Wrong time to next send");
+    NS_TEST_ASSERT_MSG_EQ_TOL (pacer.GetTimeToNextSend (t0).GetNanoSeconds (), waitT1, 1.,
+                               "An earlier time should not lose tokens already earned");
+    NS_TEST_ASSERT_MSG_EQ_TOL (pacer.GetTimeToNextSend (t1).GetNanoSeconds (), waitT1, 1.,
+                               "Going back should not earn tokens twice");
+
+    // A packet released early, for an earlier time: charged, not refilled
+    pacer.Dequeue (t0 + MicroSeconds (50));
+    NS_TEST_ASSERT_MSG_EQ_TOL (pacer.GetTimeToNextSend (t1).GetNanoSeconds (), waitT1 + gap, 1.,
+                               "An early departure should add to the debt");
+
+    // A rate change for an earlier time keeps the tokens earned at the old rate
+    pacer.SetRate (2 * bps, t0);
+    NS_TEST_ASSERT_MSG_EQ_TOL (pacer.GetTimeToNextSend (t1).GetNanoSeconds (),
+                               (waitT1 + gap) / 2., 1.,
+                               "The debt should be paid at the new rate from then on");
+
+    const auto t = SendNext (pacer, t1);
+    NS_TEST_ASSERT_MSG_EQ_TOL (t - t1.GetNanoSeconds (), (waitT1 + gap) / 2., 2.,
+                               "Packet should leave when the debt is paid");
+    NS_TEST_ASSERT_MSG_EQ (pacer.IsEmpty (), true, "All packets should be sent");
+}
+
+/* Unit tests of the sender's pacer */
+class RmcatPacerTestSuite : public TestSuite
+{
+public:
+    RmcatPacerTestSuite ();
+};
+
+RmcatPacerTestSuite::RmcatPacerTestSuite ()
+: TestSuite{"rmcat-pacer", UNIT}
+{
+    AddTestCase (new PacerSpacingTestCase, TestCase::QUICK);
+    AddTestCase (new PacerBurstTestCase, TestCase::QUICK);
+    AddTestCase (new PacerOverheadTestCase, TestCase::QUICK);
+    AddTestCase (new PacerTimeBackwardsTestCase, TestCase::QUICK);
+}
+
+static RmcatPacerTestSuite rmcatPacerTestSuite;
@@ -60,14 +60,14 @@
  * Defines collection of test cases as specified in
  * Section 4 of the rmcat-wireless-tests draft
  */
-class RmcatWifiTestSuite : public TestSuite
+class RmcatWifiTestSuite : public RmcatShardedTestSuite
 {
 public:
     RmcatWifiTestSuite ();
 };
 
 RmcatWifiTestSuite :: RmcatWifiTestSuite ()
-    : TestSuite{"rmcat-wifi", UNIT}
+    : RmcatShardedTestSuite{"rmcat-wifi", UNIT}
 {
     // ----------------
     // Default test case parameters
@@ -192,13 +192,13 @@ RmcatWifiTestSuite :: RmcatWifiTestSuite ()
      * (Section 4.1. in rmcat-wireless-tests draft)
      * to test suite
      */
-    AddTestCase (tc41a, TestCase::QUICK);
-    AddTestCase (tc41b, TestCase::QUICK);
-    AddTestCase (tc41c, TestCase::QUICK);
-    AddTestCase (tc41d, TestCase::QUICK);
-    AddTestCase (tc41e, TestCase::QUICK);
-    AddTestCase (tc41f, TestCase::QUICK);
-    AddTestCase (tc41g, TestCase::QUICK);
+    AddShardedTestCase (tc41a, TestCase::QUICK);
+    AddShardedTestCase (tc41b, TestCase::QUICK);
+    AddShardedTestCase (tc41c, TestCase::QUICK);
+    AddShardedTestCase (tc41d, TestCase::QUICK);
+    AddShardedTestCase (tc41e, TestCase::QUICK);
+    AddShardedTestCase (tc41f, TestCase::QUICK);
+    AddShardedTestCase (tc41g, TestCase::QUICK);
 
     // -----------------------
     // Test Case 4.2.x: Wireless Bottleneck
@@ -252,9 +252,9 @@ RmcatWifiTestSuite :: RmcatWifiTestSuite ()
         /* Add test cases to test suite */
         // You can comment out these lines if you wish to reduce the time
         //    it takes to run the suite, as these test cases take a while
-        AddTestCase (tc42a,TestCase::QUICK);
-        AddTestCase (tc42b,TestCase::QUICK);
-        AddTestCase (tc42c,TestCase::QUICK);
+        AddShardedTestCase (tc42a, TestCase::QUICK);
+        AddShardedTestCase (tc42b, TestCase::QUICK);
+        AddShardedTestCase (tc42c, TestCase::QUICK);
     }
 
     // -----------------------
@@ -313,8 +313,8 @@ RmcatWifiTestSuite :: RmcatWifiTestSuite ()
      * (Section 4.2. in rmcat-wireless-tests draft)
      * to test suite
      */
-    AddTestCase (tc42d,TestCase::QUICK);
-    AddTestCase (tc42e,TestCase::QUICK);
+    AddShardedTestCase (tc42d, TestCase::QUICK);
+    AddShardedTestCase (tc42e, TestCase::QUICK);
 }
 
 static RmcatWifiTestSuite rmcatWifiTestSuite;
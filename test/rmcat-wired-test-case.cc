@@ -26,6 +26,9 @@
  */
 
 #include "rmcat-wired-test-case.h"
+#include <algorithm>
+#include <iterator>
+#include <set>
 
 NS_LOG_COMPONENT_DEFINE ("RmcatSimTestWired");
 
@@ -43,8 +46,6 @@ NS_LOG_COMPONENT_DEFINE ("RmcatSimTestWired");
  * defined in the rmcat-eval-test draft.
  */
 
-// TODO (deferred):  Jitter model
-// TODO (deferred):  Audio + Video combined
 // TODO (deferred):  align topology implementation with wifi case
 
 static void SenderPauseResume (Ptr<RmcatSender> send, bool pause)
@@ -52,6 +53,28 @@ static void SenderPauseResume (Ptr<RmcatSender> send, bool pause)
     send->PauseResume (pause);
 }
 
+/*
+ * Keep the record, and log it as the controller
+ * would have without a stats sink
+ */
+void RmcatTestStatsSink::write (const rmcat::StatsRecord& record)
+{
+    rmcat::ColumnarStatsSink::write (record);
+    if (Topo::logFromControllerEnabled ()) {
+        Topo::logFromController (rmcat::formatStatsRecord (record));
+    }
+}
+
+/*
+ * Index of a flow in the records kept by a
+ * stats sink, stats.ids.size () if none
+ */
+static size_t FindStatsFlow (const RmcatTestStatsSink& stats, const std::string& flowId)
+{
+    const auto found = std::find (stats.ids.begin (), stats.ids.end (), flowId);
+    return found - stats.ids.begin ();
+}
+
 /* Constructor */
 RmcatWiredTestCase::RmcatWiredTestCase (uint64_t capacity, // bottleneck capacity (in bps)
                                         uint32_t delay,    // one-way propagation delay (in ms)
@@ -64,8 +87,27 @@ RmcatWiredTestCase::RmcatWiredTestCase (uint64_t capacity, // bottleneck capacit
   m_numShortTcpFlows{0},
   m_numInitOnFlows{0},
   m_simTime{RMCAT_TC_SIMTIME},
+  m_fbIntervalMs{0},
+  m_audioStream{false},
+  m_burstMode{false},
+  m_coupledCC{false},
+  m_ecn{false},
+  m_linkRateSchedule{false},
+  m_linkTraceSchedule{false},
   m_pauseFid{0},
-  m_codecType{SYNCODEC_TYPE_FIXFPS}
+  m_codecType{SYNCODEC_TYPE_FIXFPS},
+  m_minRateShare{0.},
+  m_maxRateShare{0.},
+  m_maxQdelayMs{0},
+  m_cleanFeedback{false},
+  m_maxRateRatio{0.},
+  m_maxLossRatio{0.},
+  m_maxSojournMs{0},
+  m_checkReordering{false},
+  m_reordered{false},
+  m_minEventsPerPacket{0.},
+  m_maxEventsPerPacket{0.},
+  m_maxAllocationsPerPacket{0.}
 {}
 
 
@@ -177,6 +219,17 @@ void RmcatWiredTestCase::SetTCPShortFlows (size_t numFlows,
 void RmcatWiredTestCase::DoSetup ()
 {
     RmcatTestCase::DoSetup ();
+    if (m_linkTraceSchedule) {
+        // The traces are written next to the test case's log file
+        if (m_capacitiesFw.size () > 0) {
+            WriteLinkTrace (m_timesFw, m_capacitiesFw, m_logfile + ".fwd.trace");
+            m_topo.SetLinkTrace (m_logfile + ".fwd.trace", true);
+        }
+        if (m_capacitiesBw.size () > 0) {
+            WriteLinkTrace (m_timesBw, m_capacitiesBw, m_logfile + ".bwd.trace");
+            m_topo.SetLinkTrace (m_logfile + ".bwd.trace", false);
+        }
+    }
     m_topo.Build (m_capacity, m_delay, m_qdelay);
     ns3::LogComponentEnable ("RmcatSimTestWired", LOG_LEVEL_INFO);
 }
@@ -231,13 +284,283 @@ void RmcatWiredTestCase::DoRun ()
     NS_LOG_INFO ("Run Simulation.");
     Simulator::Stop (Seconds (m_simTime));
     Simulator::Run ();
+    LogSojournStats (true);
+    LogSojournStats (false);
     Simulator::Destroy ();
     NS_LOG_INFO ("Done.");
+
+    CheckExpectations (sendFw, true);
+    CheckExpectations (sendBw, false);
+}
+
+/*
+ * Split the simulation into periods during which neither
+ * the available bandwidth nor the set of active RMCAT
+ * flows change
+ */
+std::vector<RmcatWiredTestCase::CheckPeriod> RmcatWiredTestCase::GetCheckPeriods (bool fwd) const
+{
+    const auto& times = fwd ? m_timesFw : m_timesBw;
+    const auto& capacities = fwd ? m_capacitiesFw : m_capacitiesBw;
+    const auto& startTimes = fwd ? m_startTimesFw : m_startTimesBw;
+    const auto& endTimes = fwd ? m_endTimesFw : m_endTimesBw;
+    const size_t numFlows = fwd ? m_numFlowsFw : m_numFlowsBw;
+    const uint32_t stopTime = m_simTime - 1; // see SetUpRMCAT
+
+    std::set<uint32_t> bounds{0, stopTime};
+    bounds.insert (times.begin (), times.end ());
+    bounds.insert (startTimes.begin (), startTimes.end ());
+    bounds.insert (endTimes.begin (), endTimes.end ());
+
+    std::vector<CheckPeriod> periods;
+    for (auto it = bounds.begin (); it != bounds.end () && *it < stopTime; ++it) {
+        CheckPeriod period;
+        period.start = *it;
+        period.end = *std::next (it);
+        period.capacity = m_capacity;
+        for (size_t i = 0; i < times.size () && times[i] <= period.start; ++i) {
+            period.capacity = capacities[i];
+        }
+        for (size_t i = 0; i < numFlows; ++i) {
+            const uint32_t start = startTimes.empty () ? 0 : startTimes[i];
+            const uint32_t end = endTimes.empty () ? stopTime : endTimes[i];
+            if (start <= period.start && period.end <= end) {
+                period.flows.push_back (i);
+            }
+        }
+        periods.push_back (period);
+    }
+    return periods;
+}
+
+/*
+ * Mean sending rate reported by a flow's controller
+ * between two times (in seconds)
+ */
+double RmcatWiredTestCase::GetMeanRate (bool fwd, size_t fid, uint32_t start, uint32_t end) const
+{
+    const auto& stats = fwd ? m_statsFw : m_statsBw;
+    const auto& flowId = fwd ? m_flowIdsFw[fid] : m_flowIdsBw[fid];
+    const size_t flow = FindStatsFlow (*stats, flowId);
+
+    double sum = 0.;
+    size_t n = 0;
+    for (size_t i = 0; i < stats->size (); ++i) {
+        if (stats->flow[i] == flow &&
+            stats->ts[i] >= start * 1000000ull && stats->ts[i] < end * 1000000ull) {
+            sum += stats->srate[i];
+            ++n;
+        }
+    }
+    return n > 0 ? sum / n : 0.;
+}
+
+/*
+ * Check the expectations set for the test case on the
+ * RMCAT flows of one direction, once the simulation is
+ * over: rates are compared to the available bandwidth
+ * in each period, once settled (see RMCAT_TC_CHECK_SETTLE)
+ */
+void RmcatWiredTestCase::CheckExpectations (const std::vector<Ptr<RmcatSender> >& send, bool fwd)
+{
+    const auto& stats = fwd ? m_statsFw : m_statsBw;
+    const auto& flowIds = fwd ? m_flowIdsFw : m_flowIdsBw;
+    if (send.empty ()) {
+        return;
+    }
+
+    if (m_cleanFeedback) {
+        for (size_t i = 0; i < send.size (); ++i) {
+            const auto& counters = send[i]->GetController ()->getEventCounters ();
+            NS_TEST_ASSERT_MSG_EQ (counters.illegalSendSequences, 0u,
+                                   flowIds[i] << ": packets sent out of sequence");
+            NS_TEST_ASSERT_MSG_EQ (counters.futureFeedback, 0u,
+                                   flowIds[i] << ": feedback about packets not sent yet");
+            NS_TEST_ASSERT_MSG_EQ (counters.duplicateFeedback, 0u,
+                                   flowIds[i] << ": duplicate feedback");
+        }
+    }
+
+    if (m_checkReordering) {
+        uint64_t lateFeedback = 0;
+        for (size_t i = 0; i < send.size (); ++i) {
+            lateFeedback += send[i]->GetController ()->getEventCounters ().lateFeedback;
+        }
+        if (m_reordered) {
+            NS_TEST_ASSERT_MSG_GT (lateFeedback, 0u,
+                                   (fwd ? "fwd" : "bwd") << " no feedback arrived out of order");
+        } else {
+            NS_TEST_ASSERT_MSG_EQ (lateFeedback, 0u,
+                                   (fwd ? "fwd" : "bwd") << " feedback arrived out of order");
+        }
+    }
+
+    if (m_minEventsPerPacket > 0. || m_maxEventsPerPacket > 0.) {
+        for (size_t i = 0; i < send.size (); ++i) {
+            const uint64_t packets = send[i]->GetSentPackets ();
+            NS_TEST_ASSERT_MSG_GT (packets, 0u, flowIds[i] << ": no media packets sent");
+            const double events = double (send[i]->GetScheduledEvents ()) / packets;
+            NS_LOG_INFO (flowIds[i] << ": media packets: " << packets
+                         << ", sender events per packet: " << events);
+            if (m_minEventsPerPacket > 0.) {
+                NS_TEST_ASSERT_MSG_GT (events, m_minEventsPerPacket,
+                                       flowIds[i] << ": too few sender events per packet");
+            }
+            if (m_maxEventsPerPacket > 0.) {
+                NS_TEST_ASSERT_MSG_LT (events, m_maxEventsPerPacket,
+                                       flowIds[i] << ": too many sender events per packet");
+            }
+        }
+    }
+
+    if (m_maxAllocationsPerPacket > 0.) {
+        const auto& settled = fwd ? m_settledPoolsFw : m_settledPoolsBw;
+        for (size_t i = 0; i < send.size (); ++i) {
+            const RmcatPacketPool& pool = send[i]->GetPacketPool ();
+            const uint64_t requests = pool.GetRequests () - settled[i].first;
+            const uint64_t allocations = pool.GetAllocations () - settled[i].second;
+            NS_TEST_ASSERT_MSG_GT (requests, 0u, flowIds[i] << ": no media packets sent once settled");
+            const double perPacket = double (allocations) / requests;
+            NS_LOG_INFO (flowIds[i] << ": media packets once settled: " << requests
+                         << ", allocations per packet: " << perPacket);
+            NS_TEST_ASSERT_MSG_LT (perPacket, m_maxAllocationsPerPacket,
+                                   flowIds[i] << ": media packets not recycled");
+        }
+    }
+
+    if (m_maxQdelayMs > 0 || m_maxLossRatio > 0.) {
+        for (size_t i = 0; i < flowIds.size (); ++i) {
+            const size_t flow = FindStatsFlow (*stats, flowIds[i]);
+            uint64_t sumQdel = 0;
+            double sumPlr = 0.;
+            uint64_t n = 0;
+            for (size_t j = 0; j < stats->size (); ++j) {
+                if (stats->flow[j] == flow) {
+                    sumQdel += stats->qdel[j];
+                    sumPlr += stats->plr[j];
+                    ++n;
+                }
+            }
+            NS_TEST_ASSERT_MSG_GT (n, 0u, flowIds[i] << ": no stats reported");
+            if (m_maxQdelayMs > 0) {
+                NS_TEST_ASSERT_MSG_LT (sumQdel / n, m_maxQdelayMs * 1000ull,
+                                       flowIds[i] << ": mean queuing delay (us) too high");
+            }
+            if (m_maxLossRatio > 0.) {
+                NS_TEST_ASSERT_MSG_LT (sumPlr / n, m_maxLossRatio,
+                                       flowIds[i] << ": mean packet loss ratio too high");
+            }
+        }
+    }
+
+    if (m_maxSojournMs > 0) {
+        const SojournStats& sojourn = m_topo.GetSojournStats (fwd);
+        NS_TEST_ASSERT_MSG_GT (sojourn.packets, 0u,
+                               (fwd ? "fwd" : "bwd") << " bottleneck sojourn times not recorded");
+        NS_TEST_ASSERT_MSG_LT (sojourn.GetMean ().GetMicroSeconds (), m_maxSojournMs * 1000ll,
+                               (fwd ? "fwd" : "bwd") << " mean bottleneck sojourn time (us) too high");
+    }
+
+    if (m_maxRateShare > 0. || m_maxRateRatio > 0.) {
+        for (const auto& period : GetCheckPeriods (fwd)) {
+            const uint32_t start = period.start + RMCAT_TC_CHECK_SETTLE;
+            if (start >= period.end || period.flows.empty ()) {
+                continue;
+            }
+            double rate = 0.;
+            double minRate = 0.;
+            double maxRate = 0.;
+            for (size_t i : period.flows) {
+                const double flowRate = GetMeanRate (fwd, i, start, period.end);
+                minRate = (i == period.flows.front ()) ? flowRate : std::min (minRate, flowRate);
+                maxRate = std::max (maxRate, flowRate);
+                rate += flowRate;
+            }
+            if (m_maxRateRatio > 0.) {
+                NS_TEST_ASSERT_MSG_LT (maxRate, m_maxRateRatio * minRate,
+                                       (fwd ? "fwd" : "bwd") << " unfair rates in ["
+                                       << start << " s, " << period.end << " s)");
+            }
+            if (m_maxRateShare <= 0.) {
+                continue;
+            }
+            const double nFlows = period.flows.size ();
+            const double available = std::min (double (period.capacity), nFlows * RMCAT_TC_RMAX);
+            const double allowed = std::max (double (period.capacity), nFlows * RMCAT_TC_RMIN);
+            NS_TEST_ASSERT_MSG_GT (rate, m_minRateShare * available,
+                                   (fwd ? "fwd" : "bwd") << " rate too low in ["
+                                   << start << " s, " << period.end << " s)");
+            NS_TEST_ASSERT_MSG_LT (rate, m_maxRateShare * allowed,
+                                   (fwd ? "fwd" : "bwd") << " rate too high in ["
+                                   << start << " s, " << period.end << " s)");
+        }
+    }
 }
 
 
 /*
- * Realize time-varying available bandwidth by
+ * Packets requested from, and created by, a sender's
+ * packet pool until its flow has settled, so that the
+ * checks only count those sent afterwards
+ */
+void RmcatWiredTestCase::RecordSettledPool (Ptr<RmcatSender> sender, bool fwd, size_t fid)
+{
+    auto& settled = fwd ? m_settledPoolsFw : m_settledPoolsBw;
+    NS_ASSERT (fid < settled.size ());
+    const RmcatPacketPool& pool = sender->GetPacketPool ();
+    settled[fid] = std::make_pair (pool.GetRequests (), pool.GetAllocations ());
+}
+
+/*
+ * Time spent in the bottleneck queue, when an AQM
+ * queue disc holds it
+ */
+void RmcatWiredTestCase::LogSojournStats (bool fwd) const
+{
+    const SojournStats& stats = m_topo.GetSojournStats (fwd);
+    if (stats.packets == 0) {
+        return;
+    }
+    NS_LOG_INFO ("Bottleneck sojourn time (" << (fwd ? "fwd" : "bwd") << ")"
+                 << ", packets: " << stats.packets
+                 << ", mean: " << stats.GetMean ().GetMicroSeconds () << " us"
+                 << ", max: " << stats.max.GetMicroSeconds () << " us");
+}
+
+/*
+ * Write a packet-delivery trace (Mahimahi format: one
+ * line per MTU-sized delivery opportunity, with its
+ * time in ms) giving the bottleneck the scheduled
+ * capacities, until the end of the simulation
+ */
+void RmcatWiredTestCase::WriteLinkTrace (const std::vector<uint32_t>& times,
+                                         const std::vector<uint64_t>& capacities,
+                                         const std::string& filename) const
+{
+    NS_ASSERT (capacities.size () == times.size ());
+    NS_ASSERT (times.size () > 0 && times[0] == 0);
+    const double mtuBits = WIRED_TOPO_TRACE_MTU * 8.;
+
+    std::ofstream trace{filename.c_str ()};
+    NS_ASSERT (trace.is_open ());
+    double opportunities = 0.; // carried over, fractions of an opportunity
+    for (size_t i = 0; i < times.size (); ++i) {
+        const uint32_t endTime = (i < times.size () - 1) ? times[i + 1] : m_simTime;
+        const double perMs = double (capacities[i]) / mtuBits / 1000.;
+        for (uint64_t ms = uint64_t (times[i]) * 1000; ms < uint64_t (endTime) * 1000; ++ms) {
+            for (opportunities += perMs; opportunities >= 1.; opportunities -= 1.) {
+                trace << ms << '\n';
+            }
+        }
+    }
+}
+
+/*
+ * Realize time-varying available bandwidth either by
+ * changing the bottleneck link's capacity at the
+ * scheduled times (see SetLinkRateSchedule), by a
+ * trace-driven bottleneck link, set up before the
+ * topology is built (see SetLinkTraceSchedule), or by
  * introducing background time-varying UDP background
  * traffic, as specified in Section 5.1 of the
  * rmcat-eval-test draft:
@@ -259,6 +582,17 @@ void RmcatWiredTestCase::SetUpPath (const std::vector<uint32_t>& times,
         NS_ASSERT (m_capacity >= *std::max_element (capacities.begin (), capacities.end ()));
         NS_ASSERT (times[0] == 0);
 
+        if (m_linkRateSchedule) {
+            // Change the bottleneck's capacity itself
+            for (size_t i = 0; i < times.size (); ++i) {
+                m_topo.ScheduleCapacity (Seconds (times[i]), capacities[i], fwd);
+            }
+            return;
+        }
+        if (m_linkTraceSchedule) {
+            return; // already in the bottleneck's packet-delivery trace
+        }
+
         uint32_t pktsize = RMCAT_TC_UDP_PKTSIZE;
         for (size_t i = 0; i < times.size (); ++i) {
             const uint32_t current_rate = m_capacity - capacities[i];
@@ -323,6 +657,18 @@ void RmcatWiredTestCase::SetUpRMCAT (std::vector<Ptr<RmcatSender> >& send,
         ss0 << "bwd_";
     }
 
+    // Reported stats are kept for the checks after the simulation
+    auto& stats = fwd ? m_statsFw : m_statsBw;
+    auto& flowIds = fwd ? m_flowIdsFw : m_flowIdsBw;
+    stats = std::make_shared<RmcatTestStatsSink> ();
+    flowIds.resize (numFlows);
+
+    // Flows in the same direction share the bottleneck
+    std::shared_ptr<rmcat::FlowStateExchange> fse;
+    if (m_coupledCC) {
+        fse = std::make_shared<rmcat::FlowStateExchange> ();
+    }
+
     for (size_t i = 0; i < numFlows; ++i) {
         // configure per-flow RTT
         if (fwd && m_pDelays.size () > 0) {
@@ -344,6 +690,22 @@ void RmcatWiredTestCase::SetUpRMCAT (std::vector<Ptr<RmcatSender> >& send,
         send[i]->SetRmax (RMCAT_TC_RMAX);
         send[i]->SetStartTime (Seconds (0));
         send[i]->SetStopTime (Seconds (m_simTime-1));
+        send[i]->SetEcn (m_ecn);
+        send[i]->SetBurstMode (m_burstMode);
+        send[i]->GetController ()->setStatsSink (stats);
+        flowIds[i] = ss.str ();
+        if (fse) {
+            send[i]->SetFlowStateExchange (fse, 1.);
+        }
+        if (m_audioStream) {
+            auto audio = new syncodecs::SimpleFpsBasedCodec{RMCAT_TC_AUDIO_FPS};
+            send[i]->AddStream (std::shared_ptr<syncodecs::Codec>{
+                                    new syncodecs::ShapedPacketizer{audio, DEFAULT_PACKET_SIZE}},
+                                RMCAT_TC_AUDIO_WEIGHT);
+        }
+
+        auto recv = DynamicCast<RmcatReceiver> (rmcatApps.Get (1));
+        recv->SetFeedbackInterval (MilliSeconds (m_fbIntervalMs));
     }
 
     /* configure start/end times for forward flows */
@@ -396,6 +758,18 @@ void RmcatWiredTestCase::SetUpRMCAT (std::vector<Ptr<RmcatSender> >& send,
             rtimers[i] = std::shared_ptr<Timer>{rtimer};
         }
     }
+
+    /* record the senders' packet pool counters once each flow has settled */
+    if (m_maxAllocationsPerPacket > 0.) {
+        const auto& startTimes = fwd ? m_startTimesFw : m_startTimesBw;
+        auto& settled = fwd ? m_settledPoolsFw : m_settledPoolsBw;
+        settled.assign (numFlows, std::make_pair (uint64_t (0), uint64_t (0)));
+        for (size_t i = 0; i < numFlows; ++i) {
+            const uint32_t start = startTimes.empty () ? 0 : startTimes[i];
+            Simulator::Schedule (Seconds (start + RMCAT_TC_CHECK_SETTLE),
+                                 &RmcatWiredTestCase::RecordSettledPool, this, send[i], fwd, i);
+        }
+    }
 }
 
 /*
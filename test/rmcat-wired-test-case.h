@@ -33,15 +33,29 @@
 #include "ns3/rmcat-sender.h"
 #include "ns3/rmcat-receiver.h"
 #include "ns3/rmcat-constants.h"
+#include "ns3/stats-sink.h"
 #include "ns3/bulk-send-application.h"
 #include "ns3/application-container.h"
 #include "ns3/log.h"
 #include "ns3/timer.h"
 #include "rmcat-common-test.h"
 #include <fstream>
+#include <utility>
 
 using namespace ns3;
 
+/**
+ * Stats sink keeping the records reported by the
+ * RMCAT controllers of a test case, for the checks
+ * run after the simulation, while still logging
+ * them as controller_log lines
+ */
+class RmcatTestStatsSink : public rmcat::ColumnarStatsSink
+{
+public:
+    virtual void write (const rmcat::StatsRecord& record);
+};
+
 /**
  * Defines common configuration parameters of a RMCAT
  * wired test case;
@@ -72,6 +86,32 @@ public:
     void SetSimTime (uint32_t simTime) {m_simTime = simTime; };
     void SetCodec (SyncodecType codecType) { m_codecType = codecType; };
     void SetPropDelays (const std::vector<uint32_t>& pDelays) { m_pDelays = pDelays; } ;
+    void SetFeedbackInterval (uint32_t fbIntervalMs) { m_fbIntervalMs = fbIntervalMs; };
+    void SetRtpHeader (bool rtpHeader) { m_topo.SetRtpHeader (rtpHeader); };
+    void SetBurstMode (bool burstMode) { m_burstMode = burstMode; };
+    void SetAudioStream (bool audioStream) { m_audioStream = audioStream; };
+    void SetCoupledCC (bool coupledCC) { m_coupledCC = coupledCC; };
+    void SetEcn (bool ecn) { m_ecn = ecn; m_topo.SetEcnMarking (ecn); };
+    void SetAqm (BottleneckAqm aqm) { m_topo.SetBottleneckAqm (aqm); };
+    void SetLinkRateSchedule (bool linkRate) { m_linkRateSchedule = linkRate; };
+    void SetLinkTraceSchedule (bool linkTrace) { m_linkTraceSchedule = linkTrace; };
+    void SetSharedReceiver (bool shared) { m_topo.SetSharedReceiver (shared); };
+    void SetJitter (Ptr<RandomVariableStream> jitter, bool reorder) { m_topo.SetBottleneckJitter (jitter, reorder); };
+
+    /*
+     * Expectations checked once the simulation
+     * is over, on the RMCAT flows of each direction
+     * (see CheckExpectations)
+     */
+    void ExpectRateShare (double minShare, double maxShare) { m_minRateShare = minShare; m_maxRateShare = maxShare; };
+    void ExpectMaxQdelay (uint32_t qdelayMs) { m_maxQdelayMs = qdelayMs; };
+    void ExpectCleanFeedback () { m_cleanFeedback = true; };
+    void ExpectFairness (double maxRatio) { m_maxRateRatio = maxRatio; };
+    void ExpectMaxLossRatio (double lossRatio) { m_maxLossRatio = lossRatio; };
+    void ExpectMaxSojourn (uint32_t sojournMs) { m_maxSojournMs = sojournMs; };
+    void ExpectReordering (bool reordered) { m_checkReordering = true; m_reordered = reordered; };
+    void ExpectEventsPerPacket (double minEvents, double maxEvents) { m_minEventsPerPacket = minEvents; m_maxEventsPerPacket = maxEvents; };
+    void ExpectMaxAllocationsPerPacket (double allocations) { m_maxAllocationsPerPacket = allocations; };
 
     /* configure time-varying BW */
     void SetBW (const std::vector<uint32_t>& times,
@@ -120,10 +160,41 @@ protected:
                         size_t numInitOnFlows,
                         std::vector<Ptr<BulkSendApplication> >& tcpSend);
 
+    /* Write a packet-delivery trace realizing time-varying BW */
+    void WriteLinkTrace (const std::vector<uint32_t>& times,
+                         const std::vector<uint64_t>& capacities,
+                         const std::string& filename) const;
+
+    /* Log bottleneck queue statistics after the simulation */
+    void LogSojournStats (bool fwd) const;
+
+    /* Check the expectations set for the test case after the simulation */
+    void CheckExpectations (const std::vector<Ptr<RmcatSender> >& send, bool fwd);
+
     /* network toplogy configuration */
     WiredTopo m_topo;
 
 private:
+    /*
+     * Period during which neither the available
+     * bandwidth nor the set of active RMCAT flows
+     * change
+     */
+    struct CheckPeriod {
+        uint32_t start;            // in seconds
+        uint32_t end;              // in seconds
+        uint64_t capacity;         // available bandwidth (in bps)
+        std::vector<size_t> flows; // active RMCAT flows
+    };
+
+    std::vector<CheckPeriod> GetCheckPeriods (bool fwd) const;
+
+    /* Record the packet pool counters of a flow's sender, once settled */
+    void RecordSettledPool (Ptr<RmcatSender> sender, bool fwd, size_t fid);
+
+    /* mean of a flow's reported sending rate (in bps), 0 if no record */
+    double GetMeanRate (bool fwd, size_t fid, uint32_t start, uint32_t end) const;
+
     /* Member variables specifying test case configuration */
     size_t m_numFlowsFw;        // # of RMCAT flows on forward path
     size_t m_numFlowsBw;        // # of RMCAT flows on backward path
@@ -131,6 +202,13 @@ private:
     size_t m_numShortTcpFlows;  // # of short lived TCP flows, only on forward path
     size_t m_numInitOnFlows;    // # of short lived TCP flows initially in ON state
     uint32_t m_simTime;         // simulation duration (in seconds)
+    uint32_t m_fbIntervalMs;    // feedback aggregation interval (in ms), 0: per packet
+    bool m_audioStream;         // audio stream alongside the video one, same controller
+    bool m_burstMode;           // RMCAT senders producing and pacing a frame's packets at once
+    bool m_coupledCC;           // RMCAT flows in each direction coupled (flow state exchange)
+    bool m_ecn;                 // ECN-capable RMCAT flows, marking bottleneck
+    bool m_linkRateSchedule;    // time-varying BW as bottleneck rate changes, rather than CBR flows
+    bool m_linkTraceSchedule;   // time-varying BW as a trace-driven bottleneck, rather than CBR flows
 
     /* time-varying capacities */
     std::vector<uint64_t> m_capacitiesFw;
@@ -161,6 +239,30 @@ private:
     std::vector<uint32_t> m_resumeTimes;
 
     SyncodecType m_codecType;
+
+    /* expectations checked after the simulation, 0: not checked */
+    double m_minRateShare;      // min share of the available BW taken by the RMCAT flows
+    double m_maxRateShare;      // max share of the available BW taken by the RMCAT flows
+    uint32_t m_maxQdelayMs;     // max mean queuing delay of each RMCAT flow (in ms)
+    bool m_cleanFeedback;       // no illegal sequence, future or duplicate feedback
+    double m_maxRateRatio;      // max ratio between the rates of concurrent RMCAT flows
+    double m_maxLossRatio;      // max mean packet loss ratio of each RMCAT flow
+    uint32_t m_maxSojournMs;    // max mean sojourn time in the bottleneck queue disc (in ms)
+    bool m_checkReordering;     // whether to check m_reordered
+    bool m_reordered;           // some feedback about RMCAT packets arriving out of order
+    double m_minEventsPerPacket; // min events scheduled by each RMCAT sender per packet sent
+    double m_maxEventsPerPacket; // max events scheduled by each RMCAT sender per packet sent
+    double m_maxAllocationsPerPacket; // max packets created per packet sent by each RMCAT sender, once settled
+
+    /* flow IDs and reported stats of the RMCAT flows */
+    std::vector<std::string> m_flowIdsFw;
+    std::vector<std::string> m_flowIdsBw;
+    std::shared_ptr<RmcatTestStatsSink> m_statsFw;
+    std::shared_ptr<RmcatTestStatsSink> m_statsBw;
+
+    /* packet pool counters (requests, allocations) of the RMCAT senders, once settled */
+    std::vector<std::pair<uint64_t, uint64_t> > m_settledPoolsFw;
+    std::vector<std::pair<uint64_t, uint64_t> > m_settledPoolsBw;
 };
 
 #endif /* RMCAT_WIRED_TEST_CASE_H */
@@ -41,14 +41,14 @@
  * Defines collection of test cases as specified in
  * the rmcat-eval-test draft
  */
-class RmcatTestSuite : public TestSuite
+class RmcatTestSuite : public RmcatShardedTestSuite
 {
 public:
   RmcatTestSuite ();
 };
 
 RmcatTestSuite::RmcatTestSuite ()
-  : TestSuite{"rmcat-wired", UNIT}
+  : RmcatShardedTestSuite{"rmcat-wired", UNIT}
 {
     // ----------------
     // Default test case parameters
@@ -85,6 +85,10 @@ RmcatTestSuite::RmcatTestSuite ()
     RmcatWiredTestCase * tc51a = new RmcatWiredTestCase{bw, pdel, qdel, "rmcat-test-case-5.1-fixfps"};
     tc51a->SetSimTime (simT);
     tc51a->SetBW (timeTC51, bwTC51, true); // FWD path
+    tc51a->ExpectRateShare (0.4, 1.3);
+    tc51a->ExpectCleanFeedback ();
+    tc51a->ExpectEventsPerPacket (2.5, 0.); // enqueue, send and oversleep events per packet
+    tc51a->ExpectMaxAllocationsPerPacket (0.01); // media packets recycled once settled
 
     RmcatWiredTestCase * tc51b = new RmcatWiredTestCase{bw, pdel, qdel, "rmcat-test-case-5.1-cbrlike"};
     tc51b->SetSimTime (simT);
@@ -111,6 +115,94 @@ RmcatTestSuite::RmcatTestSuite ()
     tc51f->SetBW (timeTC51, bwTC51, true); // FWD path
     tc51f->SetCodec (SYNCODEC_TYPE_HYBRID); // hybrid (trace/statistics) video source
 
+    RmcatWiredTestCase * tc51g = new RmcatWiredTestCase{bw, pdel, qdel, "rmcat-test-case-5.1-fixfps-rtp"};
+    tc51g->SetSimTime (simT);
+    tc51g->SetBW (timeTC51, bwTC51, true); // FWD path
+    tc51g->SetRtpHeader (true); // RTP media headers, as WebRTC stacks send them
+    tc51g->ExpectRateShare (0.4, 1.3); // header bytes counted in the rates
+    tc51g->ExpectCleanFeedback ();     // sequences and timestamps read back from RTP
+    tc51g->ExpectMaxAllocationsPerPacket (0.01); // recycled packets stripped of their headers
+
+    RmcatWiredTestCase * tc51q = new RmcatWiredTestCase{bw, pdel, qdel, "rmcat-test-case-5.1-fixfps-burst"};
+    tc51q->SetSimTime (simT);
+    tc51q->SetBW (timeTC51, bwTC51, true); // FWD path
+    tc51q->SetBurstMode (true); // a frame's packets produced and planned at once
+    tc51q->ExpectRateShare (0.4, 1.3); // as in the per-packet case (5.1-fixfps)
+    tc51q->ExpectCleanFeedback ();
+    tc51q->ExpectEventsPerPacket (0., 2.); // one timer wake-up per packet, one enqueue per frame
+
+    RmcatWiredTestCase * tc51h = new RmcatWiredTestCase{bw, pdel, qdel, "rmcat-test-case-5.1-fixfps-audio"};
+    tc51h->SetSimTime (simT);
+    tc51h->SetBW (timeTC51, bwTC51, true); // FWD path
+    tc51h->SetAudioStream (true); // audio + video sharing the flow's controller
+    tc51h->ExpectRateShare (0.4, 1.3); // both streams within the flow's rate
+    tc51h->ExpectCleanFeedback ();     // one sequence space for both streams
+
+    RmcatWiredTestCase * tc51i = new RmcatWiredTestCase{bw, pdel, qdel, "rmcat-test-case-5.1-fixfps-ecn"};
+    tc51i->SetSimTime (simT);
+    tc51i->SetBW (timeTC51, bwTC51, true); // FWD path
+    tc51i->SetEcn (true); // ECN-marking RED at the bottleneck
+    tc51i->ExpectRateShare (0.4, 1.3);
+    tc51i->ExpectMaxLossRatio (0.01); // congestion marked rather than dropped
+    tc51i->ExpectMaxSojourn (50);     // queue kept around RED's thresholds
+
+    // AQM at the bottleneck, only where this ns-3 release has the queue disc
+    const BottleneckAqm aqmTC51[] = {AQM_CODEL, AQM_FQ_CODEL, AQM_PIE};
+    const char * aqmNameTC51[] = {"codel", "fqcodel", "pie"};
+    std::vector<RmcatWiredTestCase *> tc51aqm;
+    for (size_t i = 0; i < sizeof (aqmTC51) / sizeof (aqmTC51[0]); ++i) {
+        if (!WiredTopo::IsBottleneckAqmSupported (aqmTC51[i])) {
+            continue;
+        }
+        RmcatWiredTestCase * tc = new RmcatWiredTestCase{bw, pdel, qdel,
+                                                         std::string{"rmcat-test-case-5.1-fixfps-"} + aqmNameTC51[i]};
+        tc->SetSimTime (simT);
+        tc->SetBW (timeTC51, bwTC51, true); // FWD path
+        tc->SetAqm (aqmTC51[i]);
+        tc->ExpectRateShare (0.4, 1.3);
+        tc->ExpectMaxQdelay (100);
+        tc->ExpectMaxSojourn (50); // AQMs target a few ms of queuing
+        tc51aqm.push_back (tc);
+    }
+
+    RmcatWiredTestCase * tc51m = new RmcatWiredTestCase{bw, pdel, qdel, "rmcat-test-case-5.1-fixfps-linkrate"};
+    tc51m->SetSimTime (simT);
+    tc51m->SetBW (timeTC51, bwTC51, true); // FWD path
+    tc51m->SetLinkRateSchedule (true); // bottleneck rate changes instead of CBR background
+    tc51m->ExpectRateShare (0.4, 1.3);  // rate follows each capacity change
+    tc51m->ExpectMaxQdelay (200);
+
+    RmcatWiredTestCase * tc51n = new RmcatWiredTestCase{bw, pdel, qdel, "rmcat-test-case-5.1-fixfps-linktrace"};
+    tc51n->SetSimTime (simT);
+    tc51n->SetBW (timeTC51, bwTC51, true); // FWD path
+    tc51n->SetLinkTraceSchedule (true); // packet-delivery trace instead of CBR background
+    tc51n->ExpectRateShare (0.4, 1.3);  // rate follows the trace's capacities
+    tc51n->ExpectMaxQdelay (200);
+    tc51n->ExpectMaxSojourn (200);      // timed through the trace-driven queue disc
+
+    auto uniformJitter = CreateObject<UniformRandomVariable> ();
+    uniformJitter->SetAttribute ("Min", DoubleValue (0.));
+    uniformJitter->SetAttribute ("Max", DoubleValue (RMCAT_TC_JITTER_MAX_MS));
+    RmcatWiredTestCase * tc51o = new RmcatWiredTestCase{bw, pdel, qdel, "rmcat-test-case-5.1-fixfps-jitter"};
+    tc51o->SetSimTime (simT);
+    tc51o->SetBW (timeTC51, bwTC51, true); // FWD path
+    tc51o->SetJitter (uniformJitter, false); // packets keep their order
+    tc51o->ExpectRateShare (0.3, 1.3);
+    tc51o->ExpectCleanFeedback ();
+    tc51o->ExpectReordering (false);
+
+    auto paretoJitter = CreateObject<ParetoRandomVariable> ();
+    paretoJitter->SetAttribute ("Mean", DoubleValue (RMCAT_TC_JITTER_PARETO_MEAN_MS));
+    paretoJitter->SetAttribute ("Shape", DoubleValue (RMCAT_TC_JITTER_PARETO_SHAPE));
+    paretoJitter->SetAttribute ("Bound", DoubleValue (RMCAT_TC_JITTER_PARETO_BOUND_MS));
+    RmcatWiredTestCase * tc51p = new RmcatWiredTestCase{bw, pdel, qdel, "rmcat-test-case-5.1-fixfps-jitter-reorder"};
+    tc51p->SetSimTime (simT);
+    tc51p->SetBW (timeTC51, bwTC51, true); // FWD path
+    tc51p->SetJitter (paretoJitter, true); // packets may be reordered
+    tc51p->ExpectRateShare (0.3, 1.3);
+    tc51p->ExpectCleanFeedback ();
+    tc51p->ExpectReordering (true); // handled within the reorder window
+
     // -----------------------
     // Test Case 5.2: Variable Available Capacity with Multiple Flows
     // -----------------------
@@ -127,6 +219,14 @@ RmcatTestSuite::RmcatTestSuite ()
     tc52->SetBW (timeTC52, bwTC52, true);
     tc52->SetRMCATFlows (2, t0s, t0s, true);
 
+    RmcatWiredTestCase * tc52b = new RmcatWiredTestCase{bw, pdel, qdel, "rmcat-test-case-5.2-fixfps-linkrate"};
+    tc52b->SetSimTime (simT);
+    tc52b->SetBW (timeTC52, bwTC52, true);
+    tc52b->SetRMCATFlows (2, t0s, t0s, true);
+    tc52b->SetLinkRateSchedule (true); // bottleneck rate changes instead of CBR background
+    tc52b->ExpectRateShare (0.4, 1.3);
+    tc52b->ExpectMaxQdelay (200);
+
     // -----------------------
     // Test Case 5.3: Congested Feedback Link with Bi-directional Media Flows
     // -----------------------
@@ -150,6 +250,28 @@ RmcatTestSuite::RmcatTestSuite ()
     tc53->SetRMCATFlows (1, t0s, t0s, true);     // Forward path
     tc53->SetRMCATFlows (1, t0s, t0s, false);    // Backward path
 
+    RmcatWiredTestCase * tc53c = new RmcatWiredTestCase{bw, pdel, qdel, "rmcat-test-case-5.3-fixfps-linkrate"};
+    tc53c->SetSimTime (simT);
+    tc53c->SetBW (timeTC53fwd, bwTC53fwd, true);  // Forward path
+    tc53c->SetBW (timeTC53bwd, bwTC53bwd, false); // Backward path
+    tc53c->SetRMCATFlows (1, t0s, t0s, true);     // Forward path
+    tc53c->SetRMCATFlows (1, t0s, t0s, false);    // Backward path
+    tc53c->SetLinkRateSchedule (true); // bottleneck rate changes instead of CBR background
+    tc53c->ExpectRateShare (0.4, 1.3);  // both paths, each capacity period
+    tc53c->ExpectMaxQdelay (200);
+
+    // Same, with feedback aggregated over 50 ms
+    RmcatWiredTestCase * tc53b = new RmcatWiredTestCase{bw, pdel, qdel, "rmcat-test-case-5.3-fixfps-aggfb"};
+    tc53b->SetSimTime (simT);
+    tc53b->SetBW (timeTC53fwd, bwTC53fwd, true);  // Forward path
+    tc53b->SetBW (timeTC53bwd, bwTC53bwd, false); // Backward path
+    tc53b->SetRMCATFlows (1, t0s, t0s, true);     // Forward path
+    tc53b->SetRMCATFlows (1, t0s, t0s, false);    // Backward path
+    tc53b->SetFeedbackInterval (50);
+    tc53b->ExpectRateShare (0.4, 1.3);  // both paths, each capacity period
+    tc53b->ExpectMaxQdelay (200);
+    tc53b->ExpectCleanFeedback ();      // no report lost or repeated by the aggregation
+
     // -----------------------
     // Test Case 5.4: Competing Media Flows with same Congestion Control Algorithm
     // -----------------------
@@ -158,6 +280,24 @@ RmcatTestSuite::RmcatTestSuite ()
     tc54->SetSimTime (simT);
     tc54->SetRMCATFlows (3, t0s, t0s, true);    // Forward path
 
+    // Same, with all flows sinking at a single receiver application
+    RmcatWiredTestCase * tc54b = new RmcatWiredTestCase{bw, pdel, qdel, "rmcat-test-case-5.4-fixfps-sharedrecv"};
+    tc54b->SetCapacity (3600 * (1u << 10));  // bottleneck capacity: 3.6 Mbps
+    tc54b->SetSimTime (simT);
+    tc54b->SetRMCATFlows (3, t0s, t0s, true);    // Forward path
+    tc54b->SetSharedReceiver (true);
+    tc54b->ExpectRateShare (0.4, 1.3);
+    tc54b->ExpectFairness (2.);     // no flow starved by another's feedback
+    tc54b->ExpectCleanFeedback ();  // each flow only gets its own feedback
+
+    RmcatWiredTestCase * tc54c = new RmcatWiredTestCase{bw, pdel, qdel, "rmcat-test-case-5.4-fixfps-coupled"};
+    tc54c->SetCapacity (3600 * (1u << 10));  // bottleneck capacity: 3.6 Mbps
+    tc54c->SetSimTime (simT);
+    tc54c->SetRMCATFlows (3, t0s, t0s, true);    // Forward path
+    tc54c->SetCoupledCC (true); // rates allocated by a flow state exchange
+    tc54c->ExpectRateShare (0.4, 1.3);
+    tc54c->ExpectFairness (1.3); // equal priorities, equal shares
+
     // -----------------------
     // Test Case 5.5: Round Trip Time Fairness
     // -----------------------
@@ -182,6 +322,14 @@ RmcatTestSuite::RmcatTestSuite ()
     tc55->SetRMCATFlows (5, tstartTC55, tstopTC55, true);  // Forward path
     tc55->SetPropDelays (pDelaysTC55);
 
+    RmcatWiredTestCase * tc55b = new RmcatWiredTestCase{bw, 10, qdel, "rmcat-test-case-5.5-fixfps-coupled"};
+    tc55b->SetSimTime (300);  // simulation time: 300s
+    tc55b->SetRMCATFlows (5, tstartTC55, tstopTC55, true);  // Forward path
+    tc55b->SetPropDelays (pDelaysTC55);
+    tc55b->SetCoupledCC (true); // rates allocated by a flow state exchange
+    tc55b->ExpectRateShare (0.4, 1.3);
+    tc55b->ExpectFairness (1.3); // equal shares whatever the flows' RTT
+
     // -----------------------
     // Test Case 5.6: Media Flow Competing with a Long TCP Flow
     // -----------------------
@@ -225,21 +373,38 @@ RmcatTestSuite::RmcatTestSuite ()
     // Add test cases to test suite
     // -------------------------------
 
-    AddTestCase (tc51a, TestCase::QUICK);
-    AddTestCase (tc51b, TestCase::QUICK);
-    AddTestCase (tc51c, TestCase::QUICK);
-    AddTestCase (tc51d, TestCase::QUICK);
-    AddTestCase (tc51e, TestCase::QUICK);
-    AddTestCase (tc51f, TestCase::QUICK);
-
-    AddTestCase (tc52, TestCase::QUICK);
-
-    AddTestCase (tc53, TestCase::QUICK);
-    AddTestCase (tc54, TestCase::QUICK);
-    AddTestCase (tc55, TestCase::QUICK);
-    AddTestCase (tc56, TestCase::QUICK);
-    AddTestCase (tc57, TestCase::QUICK);
-    AddTestCase (tc58, TestCase::QUICK);
+    AddShardedTestCase (tc51a, TestCase::QUICK);
+    AddShardedTestCase (tc51b, TestCase::QUICK);
+    AddShardedTestCase (tc51c, TestCase::QUICK);
+    AddShardedTestCase (tc51d, TestCase::QUICK);
+    AddShardedTestCase (tc51e, TestCase::QUICK);
+    AddShardedTestCase (tc51f, TestCase::QUICK);
+    AddShardedTestCase (tc51g, TestCase::EXTENSIVE);
+    AddShardedTestCase (tc51q, TestCase::EXTENSIVE);
+    AddShardedTestCase (tc51h, TestCase::EXTENSIVE);
+    AddShardedTestCase (tc51i, TestCase::EXTENSIVE);
+    for (auto tc : tc51aqm) {
+        AddShardedTestCase (tc, TestCase::EXTENSIVE);
+    }
+    AddShardedTestCase (tc51m, TestCase::EXTENSIVE);
+    AddShardedTestCase (tc51n, TestCase::EXTENSIVE);
+    AddShardedTestCase (tc51o, TestCase::EXTENSIVE);
+    AddShardedTestCase (tc51p, TestCase::EXTENSIVE);
+
+    AddShardedTestCase (tc52, TestCase::QUICK);
+    AddShardedTestCase (tc52b, TestCase::EXTENSIVE);
+
+    AddShardedTestCase (tc53, TestCase::QUICK);
+    AddShardedTestCase (tc53b, TestCase::EXTENSIVE);
+    AddShardedTestCase (tc53c, TestCase::EXTENSIVE);
+    AddShardedTestCase (tc54, TestCase::QUICK);
+    AddShardedTestCase (tc54b, TestCase::EXTENSIVE);
+    AddShardedTestCase (tc54c, TestCase::EXTENSIVE);
+    AddShardedTestCase (tc55, TestCase::QUICK);
+    AddShardedTestCase (tc55b, TestCase::EXTENSIVE);
+    AddShardedTestCase (tc56, TestCase::QUICK);
+    AddShardedTestCase (tc57, TestCase::QUICK);
+    AddShardedTestCase (tc58, TestCase::QUICK);
 }
 
 static RmcatTestSuite rmcatTestSuite;
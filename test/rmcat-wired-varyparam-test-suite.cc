@@ -43,14 +43,14 @@
  * delay) for specific test cases in the rmcat-eval-test
  * draft
  */
-class RmcatVaryParamTestSuite : public TestSuite
+class RmcatVaryParamTestSuite : public RmcatShardedTestSuite
 {
 public:
   RmcatVaryParamTestSuite ();
 };
 
 RmcatVaryParamTestSuite::RmcatVaryParamTestSuite ()
-  : TestSuite{"rmcat-vparam", UNIT}
+  : RmcatShardedTestSuite{"rmcat-vparam", UNIT}
 {
     // ----------------
     // Default test case parameters
@@ -110,7 +110,7 @@ RmcatVaryParamTestSuite::RmcatVaryParamTestSuite ()
             tc56tmp->SetSimTime (simT);                // Simulation time: 300s
             tc56tmp->SetTCPLongFlows (1, tstartTC56, tstopTC56, true);    // Forward path
 
-            AddTestCase (tc56tmp, TestCase::QUICK);
+            AddShardedTestCase (tc56tmp, TestCase::QUICK);
         }
     }
 }
@@ -21,6 +21,7 @@ import os
 import sys
 import re
 import json
+import struct
 
 SEP = '\t'
 
@@ -86,11 +87,60 @@ def process_tcp_log(line, test_logs):
         return
     assert False, "Error: Unrecognized tcp log line: <{}>".format(line)
 
+# Binary stats files, see rmcat::BinaryStatsSink (stats-sink.h)
+STATS_MAGIC = b'RMST'
+STATS_VERSION = 2
+STATS_FLOW_HDR = struct.Struct('<H')
+STATS_RECORD = struct.Struct('<HIQQQQIfffffI')
+
+def process_stats_file(abs_fn, test_logs):
+    'parsing binary stats records; same output as the nada log lines'
+    with open(abs_fn, 'rb') as f_stats:
+        data = f_stats.read()
+    assert data[:4] == STATS_MAGIC, "Error: not a stats file: {}".format(abs_fn)
+    assert ord(data[4:5]) == STATS_VERSION, "Error: unsupported stats file version"
+    pos = 5
+    flows = {}
+    while pos < len(data):
+        entry = data[pos:pos + 1]
+        pos += 1
+        if entry == b'F':
+            (index,) = STATS_FLOW_HDR.unpack_from(data, pos)
+            pos += STATS_FLOW_HDR.size
+            strs = []
+            for _ in range(2):
+                length = ord(data[pos:pos + 1])
+                strs.append(data[pos + 1:pos + 1 + length].decode('ascii'))
+                pos += 1 + length
+            flows[index] = strs
+            continue
+        assert entry == b'R', "Error: corrupt stats file: {}".format(abs_fn)
+        (index, fields, ts, loglen, qdel, rtt, ploss, plr, x_curr,
+         rrate, srate, avgint, curint) = STATS_RECORD.unpack_from(data, pos)
+        pos += STATS_RECORD.size
+        (algo, obj) = flows[index]
+        if algo != 'nada':
+            continue
+        if obj not in test_logs['nada']:
+            test_logs['nada'][obj] = []
+        test_logs['nada'][obj].append([ts / 1.e6, qdel / 1000., rtt / 1000.,
+                                       ploss, plr, x_curr,
+                                       rrate, srate, loglen, avgint, curint])
+
 def process_log(dirname, filename, all_logs):
     abs_fn = os.path.join(dirname, filename)
     if not os.path.isfile(abs_fn):
         print "Skipping file {} (not a regular file)".format(filename)
         return
+    match = re.match(r'([a-zA-Z0-9_\.-]+)\.rmst$', filename)
+    if match:
+        print "Processing stats file {}...".format(filename)
+        test_name = match.group(1).replace(".", "_").replace("-", "_")
+        test_logs = {'nada': {}, 'tcp': {} }
+        all_logs[test_name] = test_logs
+        process_stats_file(abs_fn, test_logs)
+        saveto_matfile(dirname, filename, test_logs)
+        return
     match = re.match(r'([a-zA-Z0-9_\.-]+).log', filename)
     if match is None:
         print "Skipping file {} (not a log file)".format(filename)
@@ -0,0 +1,182 @@
+#!/usr/bin/python
+
+###############################################################################
+#  Copyright 2016-2017 Cisco Systems, Inc.                                    #
+#                                                                             #
+#  Licensed under the Apache License, Version 2.0 (the "License");            #
+#  you may not use this file except in compliance with the License.           #
+#                                                                             #
+#  You may obtain a copy of the License at                                    #
+#                                                                             #
+#      http://www.apache.org/licenses/LICENSE-2.0                             #
+#                                                                             #
+#  Unless required by applicable law or agreed to in writing, software        #
+#  distributed under the License is distributed on an "AS IS" BASIS,          #
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   #
+#  See the License for the specific language governing permissions and        #
+#  limitations under the License.                                             #
+###############################################################################
+
+# Run the test cases of an rmcat test suite in parallel, as separate
+# test-runner processes, each running one shard of the suite's test cases
+# (see RMCAT_TC_SHARD in test/rmcat-common-test.h)
+#
+# run from ns3 root directory, after building: ns-3.xx/
+#
+# Example:
+# python src/ns3-rmcat/tools/run_parallel.py vparam testpy-output/2017-07-21-rmcat-wired-vparam
+# python src/ns3-rmcat/tools/run_parallel.py -j 16 wired
+# python src/ns3-rmcat/tools/run_parallel.py -f EXTENSIVE wired
+#
+# As with test.csh, the output directory is optional, the per-test-case
+# logs are written to it, and process_test_logs.py and plot_tests.py can
+# then be run on it. It also gets, per shard, the test-runner's output
+# and XML results, and a merged summary: <suite>-summary.txt
+
+from __future__ import print_function
+
+import glob
+import multiprocessing
+import multiprocessing.pool
+import optparse
+import os
+import subprocess
+import sys
+import time
+import xml.etree.ElementTree as ET
+
+
+def find_test_runner():
+    runners = glob.glob(os.path.join('build', 'utils', 'ns3*-test-runner*'))
+    runners = [r for r in runners if os.access(r, os.X_OK) and not r.endswith('.o')]
+    if len(runners) != 1:
+        print('Cannot find a single test-runner in build/utils, use --runner', file=sys.stderr)
+        sys.exit(1)
+    return os.path.abspath(runners[0])
+
+
+def run_shard(args):
+    runner, suite, fullness, shard, nshards, odir = args
+    prefix = os.path.join(odir, '{}-shard-{}'.format(suite, shard))
+    cmd = [runner,
+           '--test-name={}'.format(suite),
+           '--fullness={}'.format(fullness),
+           '--xml',
+           '--tempdir={}'.format(odir),
+           '--out={}.xml'.format(prefix)]
+
+    env = dict(os.environ)
+    env['RMCAT_TC_SHARD'] = '{}/{}'.format(shard, nshards)
+    # same as test.py: ns3 libraries are not installed
+    libdir = os.path.abspath(os.path.join('build', 'lib'))
+    for var in ['LD_LIBRARY_PATH', 'DYLD_LIBRARY_PATH']:
+        env[var] = os.pathsep.join([libdir, env.get(var, '')])
+
+    if os.path.exists('{}.xml'.format(prefix)):
+        os.remove('{}.xml'.format(prefix)) # left by an earlier run
+    start = time.time()
+    with open('{}.out'.format(prefix), 'w') as out:
+        # per-test-case logs go to the current directory
+        status = subprocess.call(cmd, cwd=odir, env=env,
+                                 stdout=out, stderr=subprocess.STDOUT)
+    return (shard, status, time.time() - start, '{}.xml'.format(prefix))
+
+
+def parse_results(xmlfile):
+    'test cases run by a shard: list of (name, result, seconds)'
+    try:
+        root = ET.parse(xmlfile).getroot()
+    except (IOError, ET.ParseError):
+        return None
+    # the suite is the top-level <Test>, its test cases the nested ones
+    suite = root if root.tag == 'Test' else root.find('Test')
+    if suite is None:
+        return None
+    cases = []
+    for tc in suite.findall('Test'):
+        name = tc.findtext('Name', '?')
+        result = tc.findtext('Result', '?')
+        t = tc.find('Time')
+        secs = float(t.get('real')) if t is not None and t.get('real') else float('nan')
+        cases.append((name, result, secs))
+    return cases
+
+
+def main():
+    parser = optparse.OptionParser(usage='%prog [options] wired|vparam|wifi [output_directory]')
+    parser.add_option('-j', '--jobs', type='int', default=multiprocessing.cpu_count(),
+                      help='processes running at the same time [default: %default]')
+    parser.add_option('-n', '--shards', type='int', default=0,
+                      help='shards the test cases are split into [default: jobs]')
+    parser.add_option('-f', '--fullness', default='QUICK',
+                      choices=['QUICK', 'EXTENSIVE', 'TAKES_FOREVER'],
+                      help='longest test cases run, as test.py\'s --fullness [default: %default]')
+    parser.add_option('--runner', default='',
+                      help='test-runner executable [default: found in build/utils]')
+    (options, args) = parser.parse_args()
+    if len(args) not in (1, 2):
+        parser.error('wrong number of arguments')
+
+    suite = args[0] if args[0].startswith('rmcat-') else 'rmcat-' + args[0]
+    if len(args) == 2:
+        odir = args[1]
+    else:
+        odir = os.path.join('testpy-output', time.strftime('%Y-%m-%d-%H-%M-%S-CUT', time.gmtime()))
+    odir = os.path.abspath(odir)
+    if not os.path.exists(odir):
+        os.makedirs(odir)
+
+    runner = os.path.abspath(options.runner) if options.runner else find_test_runner()
+    jobs = max(1, options.jobs)
+    nshards = options.shards if options.shards > 0 else jobs
+
+    print('running {} in {} shards, {} at a time ...'.format(suite, nshards, jobs))
+    start = time.time()
+    pool = multiprocessing.pool.ThreadPool(jobs)
+    shards = []
+    for res in pool.imap_unordered(run_shard,
+                                   [(runner, suite, options.fullness, k, nshards, odir)
+                                    for k in range(nshards)]):
+        shard, status, secs, _ = res
+        print('shard {}/{}: exit status {}, {:.1f} s'.format(shard, nshards, status, secs))
+        shards.append(res)
+    pool.close()
+    pool.join()
+    elapsed = time.time() - start
+
+    # merged summary, test cases in shard order
+    lines = []
+    ncases = 0
+    nfailed = 0
+    cpu_secs = 0.
+    for shard, status, secs, xmlfile in sorted(shards):
+        cpu_secs += secs
+        cases = parse_results(xmlfile)
+        if cases is None:
+            lines.append('CRASH  {:>9}  shard {} (exit status {}, no results, see {})'.format(
+                '-', shard, status, os.path.basename(xmlfile)[:-4] + '.out'))
+            nfailed += 1
+            continue
+        for name, result, tc_secs in cases:
+            ncases += 1
+            if result != 'PASS':
+                nfailed += 1
+            lines.append('{:<5}  {:>9.1f}  {}'.format(result, tc_secs, name))
+        if status != 0 and all(r == 'PASS' for _, r, _ in cases):
+            lines.append('CRASH  {:>9}  shard {} (exit status {})'.format('-', shard, status))
+            nfailed += 1
+
+    lines.append('')
+    lines.append('{}: {} test cases, {} failures, {} shards'.format(suite, ncases, nfailed, nshards))
+    lines.append('wall clock: {:.1f} s, sum over shards: {:.1f} s'.format(elapsed, cpu_secs))
+    summary = '\n'.join(lines) + '\n'
+
+    with open(os.path.join(odir, '{}-summary.txt'.format(suite)), 'w') as f:
+        f.write(summary)
+    print()
+    print(summary, end='')
+    return 1 if nfailed > 0 else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())